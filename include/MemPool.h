@@ -171,10 +171,12 @@ public:
     void clean(time_t maxage);
 
     void setDefaultPoolChunking(bool const &);
+
     MemImplementingAllocator *pools;
     ssize_t mem_idle_limit;
     int poolCount;
     bool defaultIsChunked;
+    bool defaultIsSlab; ///< overrides defaultIsChunked
 private:
     static MemPools *Instance;
 };
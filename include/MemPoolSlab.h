@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef _MEM_POOL_SLAB_H_
+#define _MEM_POOL_SLAB_H_
+
+#include "MemPool.h"
+
+#include <vector>
+
+/// \ingroup MemPoolsAPI
+/// the maximum number of objects moved between a pool and its class at once
+#define MEM_SLAB_MAX_BATCH 64
+
+class MemSlab;
+
+/// \ingroup MemPoolsAPI
+/// utilization of one slab class, as reported by MemSlabClass::GetStats()
+class MemSlabClassStats
+{
+public:
+    size_t obj_size;
+    size_t slab_size;
+    int slab_capacity;
+    int pools; ///< the number of pools sharing the class
+
+    int slabs_alloc;
+    int slabs_free; ///< slabs with all objects free
+    int slabs_partial; ///< slabs with some objects free
+
+    int items_out; ///< objects in use or cached by pools
+    int items_free; ///< free objects in slabs
+
+    double refills; ///< the number of batches given to pools
+    double drains; ///< the number of batches returned by pools
+};
+
+/**
+ \ingroup MemPoolsAPI
+ * Slabs of objects of one size class, shared by all slab pools with
+ * objects of that size. Pools get and return free objects in batches.
+ */
+class MemSlabClass
+{
+public:
+    /// the class for objects of the given size, created if needed
+    static MemSlabClass &ForSize(size_t objSize);
+
+    /// appends the utilization of every class; returns the number of classes
+    static int GetStats(std::vector<MemSlabClassStats> &stats);
+
+    /// gives up to count free objects; returns the number given
+    int refill(void *&list, int count);
+
+    /// returns count objects from the list to their slabs
+    void drain(void *&list, int count);
+
+    /// releases slabs that have been totally free for maxage seconds
+    void clean(time_t maxage);
+
+    /// whether some slabs are totally free
+    bool hasIdleSlabs() const { return slabsFree > 0; }
+
+    const size_t objSize;
+    const size_t slabSize;
+    const int slabCapacity;
+    int pools; ///< the number of pools sharing this class
+
+private:
+    MemSlabClass(size_t objSize, size_t slabSize);
+
+    void createSlab();
+    void destroySlab(MemSlab *slab);
+    void linkFirst(MemSlab *slab);
+    void linkLast(MemSlab *slab);
+    void unlink(MemSlab *slab);
+
+    Splay<MemSlab *> allSlabs;
+    MemSlab *freeSlabs; ///< slabs with free objects, fullest first
+    MemSlab *freeSlabsTail;
+    int slabsAlloc;
+    int slabsFree;
+    int itemsOut;
+    double refills;
+    double drains;
+};
+
+/**
+ \ingroup MemPoolsAPI
+ * A pool that keeps a small cache of free objects and exchanges them with
+ * the shared MemSlabClass slabs in batches. The batch size grows when the
+ * pool alternates between emptying and overflowing its cache.
+ */
+class MemPoolSlab : public MemImplementingAllocator
+{
+public:
+    MemPoolSlab(char const *label, size_t aSize);
+    ~MemPoolSlab();
+    virtual bool idleTrigger(int shift) const;
+    virtual void clean(time_t maxage);
+
+    /**
+     \param stats   Object to be filled with statistical data about pool.
+     \retval        Number of objects in use, ie. allocated.
+     */
+    virtual int getStats(MemPoolStats * stats, int accumulate);
+
+    virtual int getInUseCount();
+protected:
+    virtual void *allocate();
+    virtual void deallocate(void *, bool aggressive);
+private:
+    void refill();
+    void drain(int count);
+
+    MemSlabClass &slabClass;
+    void *freeCache; ///< cached free objects, linked through their first word
+    int cached; ///< the number of objects in freeCache
+    int batch; ///< the number of objects to get or return at once
+    bool drained; ///< whether the cache overflowed since the last refill
+};
+
+#endif /* _MEM_POOL_SLAB_H_ */
+
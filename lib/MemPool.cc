@@ -18,6 +18,7 @@
 #include "MemPool.h"
 #include "MemPoolChunked.h"
 #include "MemPoolMalloc.h"
+#include "MemPoolSlab.h"
 
 #define FLUSH_LIMIT 1000    /* Flush memPool counters to memMeters after flush limit calls */
 
@@ -92,20 +93,29 @@ MemPools::idleLimit() const
 /* Change the default calue of defaultIsChunked to override
  * all pools - including those used before main() starts where
  * MemPools::GetInstance().setDefaultPoolChunking() can be called.
+ *
+ * The MEMPOOLS environment variable selects the pool type at startup:
+ * 0 for malloc-based pools, 2 for slab pools, other numbers for chunked.
  */
 MemPools::MemPools() : pools(NULL), mem_idle_limit(2 << 20 /* 2 MB */),
-    poolCount(0), defaultIsChunked(USE_CHUNKEDMEMPOOLS && !RUNNING_ON_VALGRIND)
+    poolCount(0), defaultIsChunked(USE_CHUNKEDMEMPOOLS && !RUNNING_ON_VALGRIND),
+    defaultIsSlab(false)
 {
     char *cfg = getenv("MEMPOOLS");
-    if (cfg)
-        defaultIsChunked = atoi(cfg);
+    if (cfg) {
+        const int type = atoi(cfg);
+        defaultIsSlab = (type == 2);
+        defaultIsChunked = type && !defaultIsSlab;
+    }
 }
 
 MemImplementingAllocator *
 MemPools::create(const char *label, size_t obj_size)
 {
     ++poolCount;
-    if (defaultIsChunked)
+    if (defaultIsSlab)
+        return new MemPoolSlab (label, obj_size);
+    else if (defaultIsChunked)
         return new MemPoolChunked (label, obj_size);
     else
         return new MemPoolMalloc (label, obj_size);
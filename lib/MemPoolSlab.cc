@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * DEBUG: section 63    Low Level Memory Pool Management
+ */
+
+#include "squid.h"
+#include "MemPoolSlab.h"
+
+#include <cassert>
+#include <cstring>
+#include <map>
+
+/*
+ * Slab pools:
+ *   Objects are carved from slabs shared by all pools whose object sizes
+ *   round up to the same size class. Classes are 16 bytes apart for small
+ *   objects and four per power of two between 128 and 1024 bytes, so a class
+ *   wastes at most a quarter of each object while letting many small pools
+ *   (e.g., header entries and list nodes of similar sizes) fill the same
+ *   slabs. Bigger objects get classes 64 bytes apart.
+ *
+ *   Each pool caches a few free objects. An empty cache is refilled with a
+ *   batch of objects from the class; a cache holding more than two batches
+ *   returns one. A pool that keeps bouncing between these limits doubles
+ *   its batch, up to MEM_SLAB_MAX_BATCH, so busy pools rarely touch the
+ *   shared slabs at all.
+ *
+ *   Slabs with free objects are listed with partially used slabs first,
+ *   so totally free slabs stay untouched and can be released by clean().
+ */
+
+/*
+ * XXX This is a boundary violation between lib and src.. would be good
+ * if it could be solved otherwise, but left for now.
+ */
+extern time_t squid_curtime;
+
+/// \ingroup MemPoolsAPI
+class MemSlab
+{
+public:
+    MemSlab(MemSlabClass &aClass);
+    ~MemSlab();
+
+    char *objects;
+    char *end; ///< just after the last object
+    void *freeList;
+    int freeCount;
+    time_t lastref;
+    MemSlab *prev;
+    MemSlab *next;
+};
+
+/* local prototypes */
+static int memCompSlabs(MemSlab * const &, MemSlab * const &);
+static int memCompObjSlabs(void * const &, MemSlab * const &);
+
+/* Compare slabs */
+static int
+memCompSlabs(MemSlab * const &slabA, MemSlab * const &slabB)
+{
+    if (slabA->objects > slabB->objects)
+        return 1;
+    else if (slabA->objects < slabB->objects)
+        return -1;
+    else
+        return 0;
+}
+
+/* Compare object to slab */
+static int
+memCompObjSlabs(void * const &obj, MemSlab * const &slab)
+{
+    if (obj < static_cast<void *>(slab->objects))
+        return -1;
+    if (obj < static_cast<void *>(slab->end))
+        return 0;
+    return 1;
+}
+
+/// the size of objects in the class for objects of the given size
+static size_t
+memSlabClassSize(size_t objSize)
+{
+    if (objSize <= 128)
+        return (objSize + 15) / 16 * 16;
+
+    // few pools have big objects; do not waste memory to share slabs
+    if (objSize > 1024)
+        return (objSize + 63) / 64 * 64;
+
+    size_t step = 128;
+    while (step * 2 < objSize)
+        step *= 2;
+    step /= 4;
+    return (objSize + step - 1) / step * step;
+}
+
+/// the size of slabs holding objects of the given class size
+static size_t
+memSlabSize(size_t objSize)
+{
+    size_t size = objSize * MEM_MIN_FREE;
+    if (size < MEM_CHUNK_SIZE)
+        size = MEM_CHUNK_SIZE;
+    if (size > MEM_CHUNK_MAX_SIZE)
+        size = MEM_CHUNK_MAX_SIZE;
+    if (size < objSize)
+        size = objSize;
+    if (size / objSize > MEM_MAX_FREE)
+        size = objSize * MEM_MAX_FREE;
+    return (size + MEM_PAGE_SIZE - 1) / MEM_PAGE_SIZE * MEM_PAGE_SIZE;
+}
+
+typedef std::map<size_t, MemSlabClass *> MemSlabClasses;
+
+/// all slab classes, by object size
+static MemSlabClasses &
+TheSlabClasses()
+{
+    /* Must use this idiom, as pools may be created during static initialisations */
+    static MemSlabClasses *classes = new MemSlabClasses;
+    return *classes;
+}
+
+MemSlab::MemSlab(MemSlabClass &aClass) :
+    objects(static_cast<char *>(xmalloc(aClass.slabSize))),
+    end(objects + aClass.objSize * aClass.slabCapacity),
+    freeList(objects),
+    freeCount(aClass.slabCapacity),
+    lastref(squid_curtime),
+    prev(NULL),
+    next(NULL)
+{
+    void **Free = static_cast<void **>(freeList);
+    for (int i = 1; i < aClass.slabCapacity; ++i) {
+        *Free = static_cast<char *>(static_cast<void *>(Free)) + aClass.objSize;
+        Free = static_cast<void **>(*Free);
+    }
+    *Free = NULL;
+}
+
+MemSlab::~MemSlab()
+{
+    xfree(objects);
+}
+
+MemSlabClass &
+MemSlabClass::ForSize(size_t objSize)
+{
+    const size_t size = memSlabClassSize(objSize);
+    MemSlabClass *&slabClass = TheSlabClasses()[size];
+    if (!slabClass)
+        slabClass = new MemSlabClass(size, memSlabSize(size));
+    return *slabClass;
+}
+
+int
+MemSlabClass::GetStats(std::vector<MemSlabClassStats> &stats)
+{
+    const MemSlabClasses &classes = TheSlabClasses();
+    for (MemSlabClasses::const_iterator i = classes.begin(); i != classes.end(); ++i) {
+        const MemSlabClass &c = *i->second;
+        MemSlabClassStats s;
+        s.obj_size = c.objSize;
+        s.slab_size = c.slabSize;
+        s.slab_capacity = c.slabCapacity;
+        s.pools = c.pools;
+        s.slabs_alloc = c.slabsAlloc;
+        s.slabs_free = c.slabsFree;
+        s.slabs_partial = 0;
+        s.items_free = 0;
+        for (const MemSlab *slab = c.freeSlabs; slab; slab = slab->next) {
+            if (slab->freeCount < c.slabCapacity)
+                ++s.slabs_partial;
+            s.items_free += slab->freeCount;
+        }
+        s.items_out = c.itemsOut;
+        s.refills = c.refills;
+        s.drains = c.drains;
+        stats.push_back(s);
+    }
+    return classes.size();
+}
+
+MemSlabClass::MemSlabClass(size_t anObjSize, size_t aSlabSize) :
+    objSize(anObjSize),
+    slabSize(aSlabSize),
+    slabCapacity(aSlabSize / anObjSize),
+    pools(0),
+    freeSlabs(NULL),
+    freeSlabsTail(NULL),
+    slabsAlloc(0),
+    slabsFree(0),
+    itemsOut(0),
+    refills(0),
+    drains(0)
+{
+    assert(slabCapacity > 0);
+}
+
+int
+MemSlabClass::refill(void *&list, int count)
+{
+    for (int given = 0; given < count;) {
+        if (!freeSlabs)
+            createSlab();
+
+        MemSlab *slab = freeSlabs;
+        if (slab->freeCount == slabCapacity)
+            --slabsFree;
+
+        while (given < count && slab->freeList) {
+            void **Free = static_cast<void **>(slab->freeList);
+            slab->freeList = *Free;
+            *Free = list;
+            list = Free;
+            --slab->freeCount;
+            ++given;
+        }
+        slab->lastref = squid_curtime;
+
+        if (!slab->freeList)
+            unlink(slab);
+    }
+
+    itemsOut += count;
+    ++refills;
+    return count;
+}
+
+void
+MemSlabClass::drain(void *&list, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        void **Free = static_cast<void **>(list);
+        assert(Free);
+        list = *Free;
+
+        MemSlab * const *found = allSlabs.find(static_cast<void *>(Free), memCompObjSlabs);
+        assert(found); // object must belong to this class
+        MemSlab *slab = *found;
+
+        *Free = slab->freeList;
+        slab->freeList = Free;
+        slab->lastref = squid_curtime;
+
+        const bool listed = slab->freeCount > 0;
+        ++slab->freeCount;
+        if (slab->freeCount == slabCapacity) {
+            // totally free slabs go last, ready to be released
+            if (listed)
+                unlink(slab);
+            linkLast(slab);
+            ++slabsFree;
+        } else if (!listed) {
+            linkFirst(slab);
+        }
+    }
+
+    itemsOut -= count;
+    ++drains;
+}
+
+void
+MemSlabClass::clean(time_t maxage)
+{
+    MemSlab *slab = freeSlabsTail;
+    while (slab && slab->freeCount == slabCapacity) {
+        MemSlab *prev = slab->prev;
+        if (squid_curtime - slab->lastref >= maxage)
+            destroySlab(slab);
+        slab = prev;
+    }
+}
+
+void
+MemSlabClass::createSlab()
+{
+    MemSlab *slab = new MemSlab(*this);
+    allSlabs.insert(slab, memCompSlabs);
+    ++slabsAlloc;
+    ++slabsFree;
+    linkLast(slab);
+}
+
+void
+MemSlabClass::destroySlab(MemSlab *slab)
+{
+    unlink(slab);
+    allSlabs.remove(slab, memCompSlabs);
+    --slabsAlloc;
+    --slabsFree;
+    delete slab;
+}
+
+void
+MemSlabClass::linkFirst(MemSlab *slab)
+{
+    slab->prev = NULL;
+    slab->next = freeSlabs;
+    if (freeSlabs)
+        freeSlabs->prev = slab;
+    else
+        freeSlabsTail = slab;
+    freeSlabs = slab;
+}
+
+void
+MemSlabClass::linkLast(MemSlab *slab)
+{
+    slab->next = NULL;
+    slab->prev = freeSlabsTail;
+    if (freeSlabsTail)
+        freeSlabsTail->next = slab;
+    else
+        freeSlabs = slab;
+    freeSlabsTail = slab;
+}
+
+void
+MemSlabClass::unlink(MemSlab *slab)
+{
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        freeSlabs = slab->next;
+    if (slab->next)
+        slab->next->prev = slab->prev;
+    else
+        freeSlabsTail = slab->prev;
+    slab->prev = slab->next = NULL;
+}
+
+MemPoolSlab::MemPoolSlab(char const *aLabel, size_t aSize) : MemImplementingAllocator(aLabel, aSize),
+    slabClass(MemSlabClass::ForSize(obj_size)),
+    freeCache(NULL),
+    cached(0),
+    batch(2),
+    drained(false)
+{
+    ++slabClass.pools;
+
+    const int objects = MEM_CHUNK_SIZE / slabClass.objSize;
+    if (objects > batch)
+        batch = objects < MEM_SLAB_MAX_BATCH / 4 ? objects : MEM_SLAB_MAX_BATCH / 4;
+}
+
+MemPoolSlab::~MemPoolSlab()
+{
+    assert(meter.inuse.level == 0);
+    drain(cached);
+    --slabClass.pools;
+}
+
+void *
+MemPoolSlab::allocate()
+{
+    if (freeCache)
+        ++saved_calls;
+    else
+        refill();
+
+    void **obj = static_cast<void **>(freeCache);
+    freeCache = *obj;
+    --cached;
+    memMeterDec(meter.idle);
+    memMeterInc(meter.inuse);
+
+    if (doZero)
+        memset(obj, 0, obj_size);
+    else
+        *obj = NULL;
+    return obj;
+}
+
+void
+MemPoolSlab::deallocate(void *obj, bool aggressive)
+{
+    void **Free = static_cast<void **>(obj);
+    *Free = freeCache;
+    freeCache = obj;
+    ++cached;
+    memMeterDec(meter.inuse);
+    memMeterInc(meter.idle);
+
+    if (aggressive) {
+        drain(cached);
+    } else if (cached > 2 * batch) {
+        drained = true;
+        drain(batch);
+    }
+}
+
+void
+MemPoolSlab::refill()
+{
+    // a pool that refills soon after draining needs bigger batches
+    if (drained && batch < MEM_SLAB_MAX_BATCH)
+        batch *= 2;
+    drained = false;
+
+    const int count = slabClass.refill(freeCache, batch);
+    cached += count;
+    memMeterAdd(meter.alloc, count);
+    memMeterAdd(meter.idle, count);
+}
+
+void
+MemPoolSlab::drain(int count)
+{
+    if (!count)
+        return;
+
+    slabClass.drain(freeCache, count);
+    cached -= count;
+    memMeterDel(meter.alloc, count);
+    memMeterDel(meter.idle, count);
+}
+
+int
+MemPoolSlab::getStats(MemPoolStats * stats, int accumulate)
+{
+    if (!accumulate)    /* need skip memset for GlobalStats accumulation */
+        memset(stats, 0, sizeof(MemPoolStats));
+
+    stats->pool = this;
+    stats->label = objectType();
+    stats->meter = &meter;
+    stats->obj_size = obj_size;
+    stats->chunk_capacity = 0; // slabs are reported per class
+
+    stats->items_alloc += meter.alloc.level;
+    stats->items_inuse += meter.inuse.level;
+    stats->items_idle += meter.idle.level;
+
+    stats->overhead += sizeof(MemPoolSlab) + strlen(objectType()) + 1;
+
+    return meter.inuse.level;
+}
+
+int
+MemPoolSlab::getInUseCount()
+{
+    return meter.inuse.level;
+}
+
+bool
+MemPoolSlab::idleTrigger(int shift) const
+{
+    return cached > (shift ? batch : 0) || slabClass.hasIdleSlabs();
+}
+
+void
+MemPoolSlab::clean(time_t maxage)
+{
+    drain(cached);
+    slabClass.clean(maxage);
+}
+
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 14    IP Cache */
+
+#include "squid.h"
+#include "base/RunnersRegistry.h"
+#include "DnsSharedCache.h"
+#include "SquidConfig.h"
+#include "tools.h"
+
+const char *const DnsSharedCache::IpcacheName = "ipcache";
+const char *const DnsSharedCache::FqdncacheName = "fqdncache";
+
+bool
+DnsSharedCache::Enabled()
+{
+    return Config.onoff.dns_cache_shared && UsingSmp();
+}
+
+/// initializes shared memory segments used by ipcache and fqdncache
+class DnsSharedCacheRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    DnsSharedCacheRr(): ipcacheOwner(NULL), fqdncacheOwner(NULL) {}
+    virtual ~DnsSharedCacheRr();
+
+protected:
+    virtual void create();
+
+private:
+    DnsSharedCache::Owner *ipcacheOwner;
+    DnsSharedCache::Owner *fqdncacheOwner;
+};
+
+RunnerRegistrationEntry(DnsSharedCacheRr);
+
+void
+DnsSharedCacheRr::create()
+{
+    if (!DnsSharedCache::Enabled())
+        return;
+
+    if (Config.ipcache.size > 0)
+        ipcacheOwner = DnsSharedCache::Init(DnsSharedCache::IpcacheName, Config.ipcache.size);
+    if (Config.fqdncache.size > 0)
+        fqdncacheOwner = DnsSharedCache::Init(DnsSharedCache::FqdncacheName, Config.fqdncache.size);
+}
+
+DnsSharedCacheRr::~DnsSharedCacheRr()
+{
+    delete ipcacheOwner;
+    delete fqdncacheOwner;
+}
+
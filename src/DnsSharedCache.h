@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_DNSSHAREDCACHE_H
+#define SQUID_DNSSHAREDCACHE_H
+
+#include "ipc/SharedCache.h"
+
+/// a DNS lookup result as stored in the shared cache
+class DnsSharedAnswer
+{
+public:
+    DnsSharedAnswer(): expires(0), negative(false), count(0), size(0) {
+        error[0] = '\0';
+    }
+
+    /// the maximum size of all items; enough for 32 IPv6 addresses
+    static const size_t DataSize = 512;
+
+    time_t expires; ///< when the answer becomes stale
+    bool negative; ///< whether the lookup has failed
+    char error[64]; ///< why the lookup has failed
+    uint8_t count; ///< the number of items (addresses or names) in data
+    uint16_t size; ///< the number of used data bytes
+    char data[DataSize]; ///< the answer items, formatted by the cache user
+};
+
+/// DNS answers shared by all SMP workers (see Ipc::SharedCache)
+class DnsSharedCache: public Ipc::SharedCache<DnsSharedAnswer>
+{
+public:
+    /// whether workers should share DNS answers
+    static bool Enabled();
+
+    /// shared memory segment names
+    static const char *const IpcacheName;
+    static const char *const FqdncacheName;
+
+    /// attaches to the shared memory segment created by Init()
+    explicit DnsSharedCache(const char *const aPath): Ipc::SharedCache<DnsSharedAnswer>(aPath) {}
+};
+
+#endif /* SQUID_DNSSHAREDCACHE_H */
+
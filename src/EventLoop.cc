@@ -96,19 +96,16 @@ EventLoop::runOnce()
     if (!waitingEngine && !engines.empty())
         waitingEngine = engines.back();
 
-    do {
-        // generate calls and events
-        typedef engine_vector::iterator EVI;
-        for (EVI i = engines.begin(); i != engines.end(); ++i) {
-            if (*i != waitingEngine)
-                checkEngine(*i, false);
-        }
+    // generate calls and events
+    typedef engine_vector::iterator EVI;
+    for (EVI i = engines.begin(); i != engines.end(); ++i) {
+        if (*i != waitingEngine)
+            checkEngine(*i, false);
+    }
 
-        // dispatch calls accumulated so far
-        sawActivity = dispatchCalls();
-        if (sawActivity)
-            runOnceResult = false;
-    } while (sawActivity);
+    // calls left queued by the previous iteration must not wait for I/O
+    if (!AsyncCallQueue::Instance().empty())
+        loop_delay = 0;
 
     if (waitingEngine != NULL)
         checkEngine(waitingEngine, true);
@@ -116,9 +113,11 @@ EventLoop::runOnce()
     if (timeService != NULL)
         timeService->tick();
 
-    // dispatch calls scheduled by waitingEngine and timeService
+    // Dispatch up to the lane budgets of the accumulated calls. The rest wait
+    // for the next iteration so that the waiting engine is checked between
+    // bursts of calls.
     sawActivity = dispatchCalls();
-    if (sawActivity)
+    if (sawActivity || !AsyncCallQueue::Instance().empty())
         runOnceResult = false;
 
     if (error) {
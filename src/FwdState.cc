@@ -136,6 +136,7 @@ FwdState::FwdState(const Comm::ConnectionPointer &client, StoreEntry * e, HttpRe
     request = r;
     HTTPMSGLOCK(request);
     pconnRace = raceImpossible;
+    spareScheduled = false;
     start_t = squid_curtime;
     serverDestinations.reserve(Config.forward_max_tries);
     e->lock("FwdState");
@@ -285,6 +286,8 @@ FwdState::~FwdState()
         calls.connector = NULL;
     }
 
+    stopSpareConnection("FwdState destructed");
+
     if (Comm::IsConnOpen(serverConn))
         closeServerConnection("~FwdState");
 
@@ -530,6 +533,20 @@ fwdConnectDoneWrapper(const Comm::ConnectionPointer &conn, Comm::Flag status, in
     fwd->connectDone(conn, status, xerrno);
 }
 
+void
+FwdState::StartSpareConnectionWrapper(void *data)
+{
+    FwdState *fwd = (FwdState *) data;
+    fwd->startSpareConnection();
+}
+
+void
+FwdState::SpareConnectDoneWrapper(const Comm::ConnectionPointer &conn, Comm::Flag status, int xerrno, void *data)
+{
+    FwdState *fwd = (FwdState *) data;
+    fwd->spareConnectDone(conn, status, xerrno);
+}
+
 /**** PRIVATE *****************************************************************/
 
 /*
@@ -660,6 +677,27 @@ FwdState::handleUnregisteredServerEnd()
 void
 FwdState::connectDone(const Comm::ConnectionPointer &conn, Comm::Flag status, int xerrno)
 {
+    calls.connector = NULL;
+    connOpener.clear();
+
+    if (status != Comm::OK && calls.spareConnector != NULL) {
+        // let the racing connection to the other address family decide
+        debugs(17, 3, "failed " << conn << "; waiting for " << spareDestination);
+        ErrorState *const anErr = makeConnectingError(ERR_CONNECT_FAIL);
+        anErr->xerrno = xerrno;
+        fail(anErr);
+        if (conn != NULL) {
+            if (conn->getPeer())
+                peerConnectFailed(conn->getPeer());
+            conn->close();
+        }
+        serverDestinations.erase(serverDestinations.begin());
+        return;
+    }
+
+    // the connection race (if any) is over
+    stopSpareConnection(status == Comm::OK ? "won the connection race" : "connection failed");
+
     if (status != Comm::OK) {
         ErrorState *const anErr = makeConnectingError(ERR_CONNECT_FAIL);
         anErr->xerrno = xerrno;
@@ -899,7 +937,141 @@ FwdState::connectStart()
     Comm::ConnOpener *cs = new Comm::ConnOpener(serverDestinations[0], calls.connector, timeLeft());
     if (host)
         cs->setHost(host);
+    connOpener = cs;
     AsyncJob::Start(cs);
+
+    scheduleSpareConnection();
+}
+
+/// the position of the first destination that may race serverDestinations[0]
+/// or zero if there is no such destination
+static size_t
+FindSpareDestination(const Comm::ConnectionList &destinations)
+{
+    const Comm::ConnectionPointer &primary = destinations[0];
+    for (size_t i = 1; i < destinations.size(); ++i) {
+        const Comm::ConnectionPointer &d = destinations[i];
+        if (d->getPeer() == primary->getPeer() && d->peerType == primary->peerType &&
+                d->remote.isIPv4() != primary->remote.isIPv4())
+            return i;
+    }
+    return 0;
+}
+
+/**
+ * Waits a little for the connection to serverDestinations[0] before also
+ * trying an address of the other family (RFC 6555), if there is one.
+ */
+void
+FwdState::scheduleSpareConnection()
+{
+    if (!Config.Timeout.happyEyeballsConnect || spareScheduled || spareOpener.valid())
+        return;
+
+    if (!FindSpareDestination(serverDestinations))
+        return;
+
+    debugs(17, 4, "may race " << serverDestinations[0] << " in " << Config.Timeout.happyEyeballsConnect << "ms");
+    eventAdd("FwdState::StartSpareConnectionWrapper", &FwdState::StartSpareConnectionWrapper, this,
+             Config.Timeout.happyEyeballsConnect / 1000.0, 0, true);
+    spareScheduled = true;
+}
+
+/// starts connecting to the other address family while the slow
+/// connection attempt to serverDestinations[0] continues
+void
+FwdState::startSpareConnection()
+{
+    spareScheduled = false;
+
+    if (calls.connector == NULL || serverDestinations.empty())
+        return; // the primary attempt is over; nothing to race
+
+    const size_t pos = FindSpareDestination(serverDestinations);
+    if (!pos)
+        return;
+
+    spareDestination = serverDestinations[pos];
+    serverDestinations.erase(serverDestinations.begin() + pos);
+    debugs(17, 3, "racing " << serverDestinations[0] << " with " << spareDestination);
+
+    spareDestination->local.port(0);
+    GetMarkingsToServer(request, *spareDestination);
+
+    calls.spareConnector = commCbCall(17,3, "FwdState::SpareConnectDoneWrapper", CommConnectCbPtrFun(&FwdState::SpareConnectDoneWrapper, this));
+    Comm::ConnOpener *cs = new Comm::ConnOpener(spareDestination, calls.spareConnector, timeLeft());
+    if (!spareDestination->getPeer())
+        cs->setHost(request->GetHost());
+    spareOpener = cs;
+    AsyncJob::Start(cs);
+}
+
+void
+FwdState::spareConnectDone(const Comm::ConnectionPointer &conn, Comm::Flag status, int xerrno)
+{
+    calls.spareConnector = NULL;
+    spareOpener.clear();
+    const Comm::ConnectionPointer spare = spareDestination;
+    spareDestination = NULL;
+
+    const bool primaryPending = calls.connector != NULL;
+
+    if (status != Comm::OK && primaryPending) {
+        // keep waiting for the primary connection
+        debugs(17, 3, "failed " << conn << "; still waiting for " << serverDestinations[0]);
+        if (conn != NULL) {
+            if (conn->getPeer())
+                peerConnectFailed(conn->getPeer());
+            conn->close();
+        }
+        return;
+    }
+
+    if (primaryPending) {
+        debugs(17, 3, conn << " won the race against " << serverDestinations[0]);
+        calls.connector->cancel("FwdState lost the connection race");
+        calls.connector = NULL;
+        if (connOpener.valid())
+            CallJobHere(17, 3, connOpener, Comm::ConnOpener, noteAbort);
+        connOpener.clear();
+        // the loser may have connected before learning about its loss
+        if (Comm::IsConnOpen(serverDestinations[0]))
+            serverDestinations[0]->close();
+    }
+
+    // the spare is now the current destination; connectDone() takes over
+    serverDestinations.insert(serverDestinations.begin(), spare);
+    connectDone(conn, status, xerrno);
+}
+
+/// abandons the spare connection attempt, if any
+void
+FwdState::stopSpareConnection(const char *reason)
+{
+    if (spareScheduled) {
+        eventDelete(&FwdState::StartSpareConnectionWrapper, this);
+        spareScheduled = false;
+    }
+
+    if (calls.spareConnector != NULL) {
+        debugs(17, 3, "stop connecting to " << spareDestination << ": " << reason);
+        calls.spareConnector->cancel(reason);
+        calls.spareConnector = NULL;
+        if (spareOpener.valid())
+            CallJobHere(17, 3, spareOpener, Comm::ConnOpener, noteAbort);
+        spareOpener.clear();
+    }
+
+    // the abandoned spare may still be useful if we have to retry
+    if (spareDestination != NULL) {
+        if (Comm::IsConnOpen(spareDestination))
+            spareDestination->close();
+        if (serverDestinations.empty())
+            serverDestinations.push_back(spareDestination);
+        else
+            serverDestinations.insert(serverDestinations.begin() + 1, spareDestination);
+        spareDestination = NULL;
+    }
 }
 
 void
@@ -9,6 +9,7 @@
 #ifndef SQUID_FORWARD_H
 #define SQUID_FORWARD_H
 
+#include "base/CbcPointer.h"
 #include "base/RefCount.h"
 #include "comm.h"
 #include "comm/Connection.h"
@@ -29,6 +30,11 @@ typedef RefCount<PconnPool> PconnPoolPointer;
 class ErrorState;
 class HttpRequest;
 
+namespace Comm
+{
+class ConnOpener;
+}
+
 #if USE_OPENSSL
 namespace Ssl
 {
@@ -120,6 +126,14 @@ private:
     /// stops monitoring server connection for closure and updates pconn stats
     void closeServerConnection(const char *reason);
 
+    /* racing connections to the other address family ("happy eyeballs") */
+    void scheduleSpareConnection();
+    void startSpareConnection();
+    void spareConnectDone(const Comm::ConnectionPointer &conn, Comm::Flag status, int xerrno);
+    void stopSpareConnection(const char *reason);
+    static void StartSpareConnectionWrapper(void *data);
+    static void SpareConnectDoneWrapper(const Comm::ConnectionPointer &conn, Comm::Flag status, int xerrno, void *data);
+
     void syncWithServerConn(const char *host);
 
 public:
@@ -139,8 +153,17 @@ private:
     // AsyncCalls which we set and may need cancelling.
     struct {
         AsyncCall::Pointer connector;  ///< a call linking us to the ConnOpener producing serverConn.
+        AsyncCall::Pointer spareConnector; ///< a call linking us to the ConnOpener racing the connector one.
     } calls;
 
+    CbcPointer<Comm::ConnOpener> connOpener; ///< the job opening a connection to serverDestinations[0]
+    CbcPointer<Comm::ConnOpener> spareOpener; ///< the job opening a connection to spareDestination
+
+    /// an address of the other family, taken out of serverDestinations while
+    /// we connect to it in parallel with serverDestinations[0]
+    Comm::ConnectionPointer spareDestination;
+    bool spareScheduled; ///< whether startSpareConnection() is waiting to be called
+
     struct {
         bool connected_okay; ///< TCP link ever opened properly. This affects retry of POST,PUT,CONNECT,etc
         bool dont_retry;
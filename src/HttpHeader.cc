@@ -9,6 +9,7 @@
 /* DEBUG: section 55    HTTP Header */
 
 #include "squid.h"
+#include "base/CharacterSet.h"
 #include "base64.h"
 #include "globals.h"
 #include "HttpHdrCc.h"
@@ -30,6 +31,7 @@
 #include "TimeOrTag.h"
 
 #include <algorithm>
+#include <limits>
 
 /* XXX: the whole set of API managing the entries vector should be rethought
  *      after the parse4r-ng effort is complete.
@@ -159,6 +161,27 @@ static const HttpHeaderFieldAttrs HeadersAttrs[] = {
 };
 
 static HttpHeaderFieldInfo *Headers = NULL;
+/// known field names, shared by all HttpHeaderEntry objects with those names
+static SBuf *HeaderNames = NULL;
+
+/// the shared name of a known field
+static const SBuf &
+KnownFieldName(const http_hdr_type id)
+{
+    if (!HeaderNames) {
+        HeaderNames = new SBuf[HDR_ENUM_END];
+        for (int i = 0; i < HDR_ENUM_END; ++i)
+            HeaderNames[i].assign(Headers[i].name.rawBuf(), Headers[i].name.size());
+    }
+    return HeaderNames[id];
+}
+
+/// whether the field name matches the given one, ignoring case
+static bool
+FieldNameIs(const SBuf &fieldName, const char *name, const size_t nameLen)
+{
+    return fieldName.length() == nameLen && strncasecmp(fieldName.rawContent(), name, nameLen) == 0;
+}
 
 http_hdr_type &operator++ (http_hdr_type &aHeader)
 {
@@ -332,6 +355,10 @@ static HttpHeaderStat HttpHeaderStats[] = {
 static int HttpHeaderStatCount = countof(HttpHeaderStats);
 
 static int HeaderEntryParsedCount = 0;
+static int HeaderEntrySharedCount = 0; ///< HttpHeaderEntry::share() calls
+static int HeaderEntryCopiedCount = 0; ///< shared entries copied on write
+static int HeaderImageBuiltCount = 0; ///< HttpHeaderImage::build() calls
+static int HeaderImageFieldCount = 0; ///< fields copied from HttpHeaderImages
 
 /*
  * forward declarations and local routines
@@ -414,6 +441,8 @@ httpHeaderCleanModule(void)
 {
     httpHeaderDestroyFieldsInfo(Headers, HDR_ENUM_END);
     Headers = NULL;
+    delete[] HeaderNames;
+    HeaderNames = NULL;
     httpHdrCcCleanModule();
     httpHdrScCleanModule();
 }
@@ -435,20 +464,29 @@ httpHeaderStatInit(HttpHeaderStat * hs, const char *label)
  * HttpHeader Implementation
  */
 
-HttpHeader::HttpHeader() : owner (hoNone), len (0), conflictingContentLength_(false)
+HttpHeader::HttpHeader() : owner (hoNone), len (0), conflictingContentLength_(false),
+    changeCount_(0),
+    indexOverflow(false)
 {
+    memset(otherNames, 0, sizeof(otherNames));
     httpHeaderMaskInit(&mask, 0);
 }
 
-HttpHeader::HttpHeader(const http_hdr_owner_type anOwner): owner(anOwner), len(0), conflictingContentLength_(false)
+HttpHeader::HttpHeader(const http_hdr_owner_type anOwner): owner(anOwner), len(0), conflictingContentLength_(false),
+    changeCount_(0),
+    indexOverflow(false)
 {
+    memset(otherNames, 0, sizeof(otherNames));
     assert(anOwner > hoNone && anOwner < hoEnd);
     debugs(55, 7, "init-ing hdr: " << this << " owner: " << owner);
     httpHeaderMaskInit(&mask, 0);
 }
 
-HttpHeader::HttpHeader(const HttpHeader &other): owner(other.owner), len(other.len), conflictingContentLength_(false)
+HttpHeader::HttpHeader(const HttpHeader &other): owner(other.owner), len(other.len), conflictingContentLength_(false),
+    changeCount_(0),
+    indexOverflow(false)
 {
+    memset(otherNames, 0, sizeof(otherNames));
     httpHeaderMaskInit(&mask, 0);
     update(&other); // will update the mask as well
 }
@@ -509,14 +547,17 @@ HttpHeader::clean()
         } else {
             if (owner <= hoReply)
                 HttpHeaderStats[owner].fieldTypeDistr.count(e->id);
-            delete e;
+            HttpHeaderEntry::Release(e);
         }
     }
 
     entries.clear();
+    ++changeCount_;
     httpHeaderMaskInit(&mask, 0);
     len = 0;
     conflictingContentLength_ = false;
+    indexOverflow = false;
+    memset(otherNames, 0, sizeof(otherNames));
     PROF_stop(HttpHeaderClean);
 }
 
@@ -531,7 +572,7 @@ HttpHeader::append(const HttpHeader * src)
     debugs(55, 7, "appending hdr: " << this << " += " << src);
 
     while ((e = src->getEntry(&pos))) {
-        addEntry(e->clone());
+        addEntry(e->share());
     }
 }
 
@@ -544,9 +585,8 @@ HttpHeader::needUpdate(HttpHeader const *fresh) const
         if (!e || skipUpdateHeader(e->id))
             continue;
         String value;
-        const char *name = e->name.termedBuf();
-        if (!getByNameIfPresent(name, value) ||
-                (value != fresh->getByName(name)))
+        if (!getByNameIfPresent(e->name, value) ||
+                (value != fresh->getByName(e->name)))
             return true;
     }
     return false;
@@ -605,7 +645,7 @@ HttpHeader::update(HttpHeader const *fresh)
         if (e->id != HDR_OTHER)
             delById(e->id);
         else
-            delByName(e->name.termedBuf());
+            delByName(e->name);
     }
 
     pos = HttpHeaderInitPos;
@@ -617,7 +657,7 @@ HttpHeader::update(HttpHeader const *fresh)
 
         debugs(55, 7, "Updating header '" << HeadersAttrs[e->id].name << "' in cached entry");
 
-        addEntry(e->clone());
+        addEntry(e->share());
     }
     return true;
 }
@@ -778,7 +818,8 @@ HttpHeader::parse(const char *header_start, const char *header_end)
             }
         }
 
-        if (e->id == HDR_OTHER && stringHasWhitespace(e->name.termedBuf())) {
+        static const CharacterSet WhiteSpace("w_space", w_space);
+        if (e->id == HDR_OTHER && e->name.findFirstOf(WhiteSpace) != SBuf::npos) {
             debugs(55, warnOnError, "WARNING: found whitespace in HTTP header name {" <<
                    getStringPrefix(field_start, field_end) << "}");
 
@@ -838,7 +879,7 @@ HttpHeader::packInto(Packer * p, bool mask_sensitive_info) const
             break;
         }
         if (maskThisEntry) {
-            packerAppend(p, e->name.rawBuf(), e->name.size());
+            packerAppend(p, e->name.rawContent(), e->name.length());
             packerAppend(p, ": ** NOT DISPLAYED **\r\n", 23);
         } else {
             e->packInto(p);
@@ -850,6 +891,102 @@ HttpHeader::packInto(Packer * p, bool mask_sensitive_info) const
     /* Cache-Control */
 }
 
+/* HttpHeaderImage */
+
+HttpHeaderImage::HttpHeaderImage(): source(NULL), sourceChanges(0), image(NULL)
+{
+}
+
+HttpHeaderImage::~HttpHeaderImage()
+{
+    clear();
+}
+
+void
+HttpHeaderImage::clear()
+{
+    source = NULL;
+    sourceChanges = 0;
+    delete image;
+    image = NULL;
+    fields.clear();
+    offsets.clear();
+}
+
+void
+HttpHeaderImage::packInto(Packer *p, const HttpHeader &hdr, const HttpHeader &src)
+{
+    if (source != &src || sourceChanges != src.changeCount()) {
+        // do not spend time on an image that may never be reused
+        clear();
+        source = &src;
+        sourceChanges = src.changeCount();
+        hdr.packInto(p);
+        return;
+    }
+
+    if (!image)
+        build(src);
+
+    // shared fields keep their source order, but some may be deleted
+    size_t runStart = 0; // the first image field of the current run
+    size_t runEnd = 0; // the image field after the current run
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (const HttpHeaderEntry *e = hdr.getEntry(&pos)) {
+        if (runEnd < fields.size() && fields[runEnd] == e) {
+            ++runEnd;
+            continue;
+        }
+
+        packRun(p, runStart, runEnd);
+
+        size_t found = runEnd;
+        while (found < fields.size() && fields[found] != e)
+            ++found;
+
+        if (found < fields.size()) {
+            runStart = found;
+            runEnd = found + 1;
+        } else {
+            e->packInto(p); // a field added or changed after cloning
+            runStart = runEnd;
+        }
+    }
+    packRun(p, runStart, runEnd);
+}
+
+/// packs source fields and remembers where each of them starts
+void
+HttpHeaderImage::build(const HttpHeader &src)
+{
+    image = new MemBuf;
+    image->init();
+    Packer packer;
+    packerToMemInit(&packer, image);
+
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (const HttpHeaderEntry *e = src.getEntry(&pos)) {
+        fields.push_back(e);
+        offsets.push_back(image->contentSize());
+        e->packInto(&packer);
+    }
+    offsets.push_back(image->contentSize());
+    packerClean(&packer);
+
+    ++HeaderImageBuiltCount;
+    debugs(55, 7, "packed " << fields.size() << " fields of " << &src);
+}
+
+/// copies packed fields [first, end) from the image
+void
+HttpHeaderImage::packRun(Packer *p, const size_t first, const size_t end) const
+{
+    if (first >= end)
+        return;
+    packerAppend(p, image->content() + offsets[first], offsets[end] - offsets[first]);
+    HeaderImageFieldCount += end - first;
+}
+
 /* returns next valid entry */
 HttpHeaderEntry *
 HttpHeader::getEntry(HttpHeaderPos * pos) const
@@ -878,21 +1015,16 @@ HttpHeader::findEntry(http_hdr_type id) const
     assert_eid(id);
     assert(!CBIT_TEST(ListHeadersMask, id));
 
-    /* check mask first */
-
-    if (!CBIT_TEST(mask, id))
+    HttpHeaderPos last = HttpHeaderInitPos;
+    if (!indexedRange(id, pos, last))
         return NULL;
 
-    /* looks like we must have it, do linear search */
-    while ((e = getEntry(&pos))) {
-        if (e->id == id)
+    for (; pos <= last; ++pos) {
+        if ((e = entries[pos]) && e->id == id)
             return e;
     }
 
-    /* hm.. we thought it was there, but it was not found */
-    assert(0);
-
-    return NULL;        /* not reached */
+    return NULL;
 }
 
 /*
@@ -903,23 +1035,19 @@ HttpHeader::findLastEntry(http_hdr_type id) const
 {
     HttpHeaderPos pos = HttpHeaderInitPos;
     HttpHeaderEntry *e;
-    HttpHeaderEntry *result = NULL;
     assert_eid(id);
     assert(!CBIT_TEST(ListHeadersMask, id));
 
-    /* check mask first */
-
-    if (!CBIT_TEST(mask, id))
+    HttpHeaderPos first = HttpHeaderInitPos;
+    if (!indexedRange(id, first, pos))
         return NULL;
 
-    /* looks like we must have it, do linear search */
-    while ((e = getEntry(&pos))) {
-        if (e->id == id)
-            result = e;
+    for (; pos >= first; --pos) {
+        if ((e = entries[pos]) && e->id == id)
+            return e;
     }
 
-    assert(result);     /* must be there! */
-    return result;
+    return NULL;
 }
 
 /*
@@ -927,15 +1055,32 @@ HttpHeader::findLastEntry(http_hdr_type id) const
  */
 int
 HttpHeader::delByName(const char *name)
+{
+    return delByName(name, strlen(name));
+}
+
+int
+HttpHeader::delByName(const SBuf &name)
+{
+    return delByName(name.rawContent(), name.length());
+}
+
+int
+HttpHeader::delByName(const char *name, const size_t nameLen)
 {
     int count = 0;
     HttpHeaderPos pos = HttpHeaderInitPos;
     HttpHeaderEntry *e;
+    debugs(55, 9, "deleting '" << std::string(name, nameLen) << "' fields in hdr " << this);
+
+    // custom fields are often absent; the filter quickly confirms that
+    if (!mayHaveOtherName(name, nameLen) && httpHeaderIdByNameDef(name, nameLen) == HDR_BAD_HDR)
+        return 0;
+
     httpHeaderMaskInit(&mask, 0);   /* temporal inconsistency */
-    debugs(55, 9, "deleting '" << name << "' fields in hdr " << this);
 
     while ((e = getEntry(&pos))) {
-        if (!e->name.caseCmp(name))
+        if (FieldNameIs(e->name, name, nameLen))
             delAt(pos, count);
         else
             CBIT_SET(mask, e->id);
@@ -955,11 +1100,12 @@ HttpHeader::delById(http_hdr_type id)
     assert_eid(id);
     assert(id != HDR_OTHER);        /* does not make sense */
 
-    if (!CBIT_TEST(mask, id))
+    HttpHeaderPos last = HttpHeaderInitPos;
+    if (!indexedRange(id, pos, last))
         return 0;
 
-    while ((e = getEntry(&pos))) {
-        if (e->id == id)
+    for (; pos <= last; ++pos) {
+        if ((e = entries[pos]) && e->id == id)
             delAt(pos, count);
     }
 
@@ -981,13 +1127,31 @@ HttpHeader::delAt(HttpHeaderPos pos, int &headers_deleted)
     assert(pos >= HttpHeaderInitPos && pos < static_cast<ssize_t>(entries.size()));
     e = static_cast<HttpHeaderEntry*>(entries[pos]);
     entries[pos] = NULL;
+    unindexEntry(e, pos);
+    ++changeCount_;
     /* decrement header length, allow for ": " and crlf */
-    len -= e->name.size() + 2 + e->value.size() + 2;
+    len -= e->name.length() + 2 + e->value.size() + 2;
     assert(len >= 0);
-    delete e;
+    HttpHeaderEntry::Release(e);
     ++headers_deleted;
 }
 
+HttpHeaderEntry *
+HttpHeader::writeableEntry(const HttpHeaderPos pos)
+{
+    assert(pos >= 0 && pos < static_cast<ssize_t>(entries.size()));
+    HttpHeaderEntry *e = entries[pos];
+    assert(e);
+    ++changeCount_; // the caller may change the entry
+    if (e->shared()) {
+        entries[pos] = e->clone();
+        HttpHeaderEntry::Release(e);
+        e = entries[pos];
+        ++HeaderEntryCopiedCount;
+    }
+    return e;
+}
+
 /*
  * Compacts the header storage
  */
@@ -998,6 +1162,8 @@ HttpHeader::compact()
     std::vector<HttpHeaderEntry *>::iterator newend;
     newend = std::remove(entries.begin(), entries.end(), static_cast<HttpHeaderEntry *>(NULL));
     entries.resize(newend-entries.begin());
+    rebuildIndex();
+    ++changeCount_;
 }
 
 /*
@@ -1012,6 +1178,7 @@ HttpHeader::refreshMask()
     while (HttpHeaderEntry *e = getEntry(&pos)) {
         CBIT_SET(mask, e->id);
     }
+    rebuildIndex();
 }
 
 /* appends an entry;
@@ -1022,19 +1189,21 @@ HttpHeader::addEntry(HttpHeaderEntry * e)
 {
     assert(e);
     assert_eid(e->id);
-    assert(e->name.size());
+    assert(e->name.length());
 
     debugs(55, 7, this << " adding entry: " << e->id << " at " << entries.size());
 
     if (CBIT_TEST(mask, e->id))
         ++ Headers[e->id].stat.repCount;
-    else
-        CBIT_SET(mask, e->id);
+
+    indexEntry(e, entries.size());
+    CBIT_SET(mask, e->id);
 
     entries.push_back(e);
+    ++changeCount_;
 
     /* increment header length, allow for ": " and crlf */
-    len += e->name.size() + 2 + e->value.size() + 2;
+    len += e->name.length() + 2 + e->value.size() + 2;
 }
 
 /* inserts an entry;
@@ -1054,9 +1223,144 @@ HttpHeader::insertEntry(HttpHeaderEntry * e)
         CBIT_SET(mask, e->id);
 
     entries.insert(entries.begin(),e);
+    rebuildIndex(); // all positions have shifted
+    ++changeCount_;
 
     /* increment header length, allow for ": " and crlf */
-    len += e->name.size() + 2 + e->value.size() + 2;
+    len += e->name.length() + 2 + e->value.size() + 2;
+}
+
+/// Sets [first, last] to the positions that may hold id entries.
+/// Returns false if there are no such entries.
+bool
+HttpHeader::indexedRange(const http_hdr_type id, HttpHeaderPos &first, HttpHeaderPos &last) const
+{
+    if (!CBIT_TEST(mask, id))
+        return false;
+
+    if (indexOverflow) {
+        first = 0;
+        last = static_cast<HttpHeaderPos>(entries.size()) - 1;
+        return last >= first;
+    }
+
+    if (!firstPos[id])
+        return false; // deleted by delAt() but still in the mask
+
+    first = firstPos[id] - 1;
+    last = lastPos[id] - 1;
+    return true;
+}
+
+/// Adds the entry that will be stored at pos to the index.
+/// Entries with the same id must be indexed in their position order.
+void
+HttpHeader::indexEntry(const HttpHeaderEntry *e, const HttpHeaderPos pos)
+{
+    if (e->id == HDR_OTHER)
+        noteOtherName(e->name);
+
+    if (indexOverflow)
+        return;
+
+    if (pos >= std::numeric_limits<uint16_t>::max()) {
+        debugs(55, 3, this << " stops indexing at " << pos << " entries");
+        indexOverflow = true;
+        return;
+    }
+
+    const uint16_t stored = static_cast<uint16_t>(pos + 1);
+    if (!CBIT_TEST(mask, e->id) || !firstPos[e->id])
+        firstPos[e->id] = stored;
+    lastPos[e->id] = stored;
+}
+
+/// removes the entry deleted from pos from the index
+void
+HttpHeader::unindexEntry(const HttpHeaderEntry *e, const HttpHeaderPos pos)
+{
+    if (indexOverflow)
+        return;
+
+    const http_hdr_type id = e->id;
+    HttpHeaderPos first = firstPos[id] - 1;
+    HttpHeaderPos last = lastPos[id] - 1;
+    assert(first <= pos && pos <= last);
+
+    if (pos == first) {
+        while (first <= last && (!entries[first] || entries[first]->id != id))
+            ++first;
+    }
+    if (pos == last) {
+        while (last >= first && (!entries[last] || entries[last]->id != id))
+            --last;
+    }
+
+    if (first > last) {
+        firstPos[id] = lastPos[id] = 0;
+    } else {
+        firstPos[id] = static_cast<uint16_t>(first + 1);
+        lastPos[id] = static_cast<uint16_t>(last + 1);
+    }
+}
+
+/// Reindexes all entries. Required after their positions change.
+void
+HttpHeader::rebuildIndex()
+{
+    indexOverflow = false;
+    memset(otherNames, 0, sizeof(otherNames));
+    HttpHeaderMask indexed;
+    httpHeaderMaskInit(&indexed, 0);
+    for (HttpHeaderPos pos = 0; pos < static_cast<HttpHeaderPos>(entries.size()); ++pos) {
+        if (const HttpHeaderEntry *e = entries[pos]) {
+            if (e->id == HDR_OTHER)
+                noteOtherName(e->name);
+            if (pos >= std::numeric_limits<uint16_t>::max()) {
+                indexOverflow = true;
+                continue;
+            }
+            if (!CBIT_TEST(indexed, e->id)) {
+                CBIT_SET(indexed, e->id);
+                firstPos[e->id] = static_cast<uint16_t>(pos + 1);
+            }
+            lastPos[e->id] = static_cast<uint16_t>(pos + 1);
+        }
+    }
+
+    // forget ids that stay in the mask until refreshMask()
+    for (int id = 0; id < HDR_ENUM_END; ++id) {
+        if (CBIT_TEST(mask, id) && !CBIT_TEST(indexed, id))
+            firstPos[id] = lastPos[id] = 0;
+    }
+}
+
+/// adds a custom field name to the otherNames filter
+void
+HttpHeader::noteOtherName(const SBuf &name)
+{
+    const unsigned int bit = OtherNameHash(name.rawContent(), name.length()) % 256;
+    otherNames[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+}
+
+/// whether a custom field with the given name may be present
+bool
+HttpHeader::mayHaveOtherName(const char *name, const size_t nameLen) const
+{
+    const unsigned int bit = OtherNameHash(name, nameLen) % 256;
+    return (otherNames[bit / 64] & (static_cast<uint64_t>(1) << (bit % 64))) != 0;
+}
+
+/// a case-insensitive hash of a custom field name
+unsigned int
+HttpHeader::OtherNameHash(const char *name, const size_t nameLen)
+{
+    uint32_t hash = 2166136261U; // FNV-1a
+    for (size_t i = 0; i < nameLen; ++i) {
+        hash ^= static_cast<unsigned char>(xtolower(name[i]));
+        hash *= 16777619U;
+    }
+    return hash;
 }
 
 bool
@@ -1068,11 +1372,12 @@ HttpHeader::getList(http_hdr_type id, String *s) const
     /* only fields from ListHeaders array can be "listed" */
     assert(CBIT_TEST(ListHeadersMask, id));
 
-    if (!CBIT_TEST(mask, id))
+    HttpHeaderPos last = HttpHeaderInitPos;
+    if (!indexedRange(id, pos, last))
         return false;
 
-    while ((e = getEntry(&pos))) {
-        if (e->id == id)
+    for (; pos <= last; ++pos) {
+        if ((e = entries[pos]) && e->id == id)
             strListAdd(s, e->value.termedBuf(), ',');
     }
 
@@ -1100,13 +1405,14 @@ HttpHeader::getList(http_hdr_type id) const
     /* only fields from ListHeaders array can be "listed" */
     assert(CBIT_TEST(ListHeadersMask, id));
 
-    if (!CBIT_TEST(mask, id))
+    HttpHeaderPos last = HttpHeaderInitPos;
+    if (!indexedRange(id, pos, last))
         return String();
 
     String s;
 
-    while ((e = getEntry(&pos))) {
-        if (e->id == id)
+    for (; pos <= last; ++pos) {
+        if ((e = entries[pos]) && e->id == id)
             strListAdd(&s, e->value.termedBuf(), ',');
     }
 
@@ -1151,17 +1457,37 @@ HttpHeader::getByName(const char *name) const
     return result;
 }
 
+String
+HttpHeader::getByName(const SBuf &name) const
+{
+    String result;
+    // ignore presence: return undefined string if an empty header is present
+    (void)getByNameIfPresent(name, result);
+    return result;
+}
+
 bool
 HttpHeader::getByNameIfPresent(const char *name, String &result) const
+{
+    assert(name);
+    return getByNameIfPresent(name, strlen(name), result);
+}
+
+bool
+HttpHeader::getByNameIfPresent(const SBuf &name, String &result) const
+{
+    return getByNameIfPresent(name.rawContent(), name.length(), result);
+}
+
+bool
+HttpHeader::getByNameIfPresent(const char *name, const size_t nameLen, String &result) const
 {
     http_hdr_type id;
     HttpHeaderPos pos = HttpHeaderInitPos;
     HttpHeaderEntry *e;
 
-    assert(name);
-
     /* First try the quick path */
-    id = httpHeaderIdByNameDef(name, strlen(name));
+    id = httpHeaderIdByNameDef(name, nameLen);
 
     if (id != -1) {
         if (!has(id))
@@ -1170,10 +1496,14 @@ HttpHeader::getByNameIfPresent(const char *name, String &result) const
         return true;
     }
 
-    /* Sorry, an unknown header name. Do linear search */
+    /* Sorry, an unknown header name. Search custom fields */
+    HttpHeaderPos last = HttpHeaderInitPos;
+    if (!mayHaveOtherName(name, nameLen) || !indexedRange(HDR_OTHER, pos, last))
+        return false;
+
     bool found = false;
-    while ((e = getEntry(&pos))) {
-        if (e->id == HDR_OTHER && e->name.caseCmp(name) == 0) {
+    for (; pos <= last; ++pos) {
+        if ((e = entries[pos]) && e->id == HDR_OTHER && FieldNameIs(e->name, name, nameLen)) {
             found = true;
             strListAdd(&result, e->value.termedBuf(), ',');
         }
@@ -1634,11 +1964,31 @@ HttpHeaderEntry::HttpHeaderEntry(http_hdr_type anId, const char *aName, const ch
     id = anId;
 
     if (id != HDR_OTHER)
-        name = Headers[id].name;
+        name = KnownFieldName(id);
     else
         name = aName;
 
     value = aValue;
+    extraHolders = 0;
+
+    ++ Headers[id].stat.aliveCount;
+
+    debugs(55, 9, "created HttpHeaderEntry " << this << ": '" << name << " : " << value );
+}
+
+HttpHeaderEntry::HttpHeaderEntry(http_hdr_type anId, const SBuf &aName, const char *aValue, const int valueLen)
+{
+    assert_eid(anId);
+    id = anId;
+
+    if (id != HDR_OTHER)
+        name = KnownFieldName(id);
+    else
+        name = aName;
+
+    if (aValue)
+        value.limitInit(aValue, valueLen);
+    extraHolders = 0;
 
     ++ Headers[id].stat.aliveCount;
 
@@ -1649,10 +1999,6 @@ HttpHeaderEntry::~HttpHeaderEntry()
 {
     assert_eid(id);
     debugs(55, 9, "destroying entry " << this << ": '" << name << ": " << value << "'");
-    /* clean name if needed */
-
-    if (id == HDR_OTHER)
-        name.clean();
 
     value.clean();
 
@@ -1704,20 +2050,13 @@ HttpHeaderEntry::parse(const char *field_start, const char *field_end)
     /* is it a "known" field? */
     http_hdr_type id = httpHeaderIdByName(field_start, name_len, Headers, HDR_ENUM_END);
 
-    String name;
-
-    String value;
-
     if (id < 0)
         id = HDR_OTHER;
 
     assert_eid(id);
 
     /* set field name */
-    if (id == HDR_OTHER)
-        name.limitInit(field_start, name_len);
-    else
-        name = Headers[id].name;
+    const SBuf name = id == HDR_OTHER ? SBuf(field_start, name_len) : KnownFieldName(id);
 
     /* trim field value */
     while (value_start < field_end && xisspace(*value_start))
@@ -1729,34 +2068,45 @@ HttpHeaderEntry::parse(const char *field_start, const char *field_end)
     if (field_end - value_start > 65534) {
         /* String must be LESS THAN 64K and it adds a terminating NULL */
         debugs(55, DBG_IMPORTANT, "WARNING: ignoring '" << name << "' header of " << (field_end - value_start) << " bytes");
-
-        if (id == HDR_OTHER)
-            name.clean();
-
         return NULL;
     }
 
-    /* set field value */
-    value.limitInit(value_start, field_end - value_start);
-
     ++ Headers[id].stat.seenCount;
 
-    debugs(55, 9, "parsed HttpHeaderEntry: '" << name << ": " << value << "'");
-
-    return new HttpHeaderEntry(id, name.termedBuf(), value.termedBuf());
+    HttpHeaderEntry *e = new HttpHeaderEntry(id, name, value_start, field_end - value_start);
+    debugs(55, 9, "parsed HttpHeaderEntry: '" << e->name << ": " << e->value << "'");
+    return e;
 }
 
 HttpHeaderEntry *
 HttpHeaderEntry::clone() const
 {
-    return new HttpHeaderEntry(id, name.termedBuf(), value.termedBuf());
+    return new HttpHeaderEntry(id, name, value.rawBuf(), value.size());
+}
+
+HttpHeaderEntry *
+HttpHeaderEntry::share() const
+{
+    ++extraHolders;
+    ++HeaderEntrySharedCount;
+    return const_cast<HttpHeaderEntry *>(this);
+}
+
+void
+HttpHeaderEntry::Release(HttpHeaderEntry *e)
+{
+    assert(e);
+    if (e->extraHolders > 0)
+        --e->extraHolders;
+    else
+        delete e;
 }
 
 void
 HttpHeaderEntry::packInto(Packer * p) const
 {
     assert(p);
-    packerAppend(p, name.rawBuf(), name.size());
+    packerAppend(p, name.rawContent(), name.length());
     packerAppend(p, ": ", 2);
     packerAppend(p, value.rawBuf(), value.size());
     packerAppend(p, "\r\n", 2);
@@ -1899,6 +2249,10 @@ httpHeaderStoreReport(StoreEntry * e)
                       HttpHeaderStats[hoReply].parsedCount,
                       HttpHeaderStats[0].parsedCount);
     storeAppendPrintf(e, "Hdr Fields Parsed: %d\n", HeaderEntryParsedCount);
+    storeAppendPrintf(e, "Hdr Fields Shared: %d\n", HeaderEntrySharedCount);
+    storeAppendPrintf(e, "Hdr Fields Copied on Write: %d\n", HeaderEntryCopiedCount);
+    storeAppendPrintf(e, "Hdr Images Built: %d\n", HeaderImageBuiltCount);
+    storeAppendPrintf(e, "Hdr Fields Copied from Images: %d\n", HeaderImageFieldCount);
 }
 
 http_hdr_type
@@ -2023,7 +2377,7 @@ HttpHeader::removeConnectionHeaderEntries()
 
         int headers_deleted = 0;
         while ((e = getEntry(&pos))) {
-            if (strListIsMember(&strConnection, e->name.termedBuf(), ','))
+            if (strListIsMember(&strConnection, e->name, ','))
                 delAt(pos, headers_deleted);
         }
         if (headers_deleted)
@@ -12,6 +12,7 @@
 /* because we pass a spec by value */
 #include "HttpHeaderMask.h"
 #include "MemPool.h"
+#include "SBuf.h"
 #include "SquidString.h"
 
 #include <vector>
@@ -181,21 +182,35 @@ typedef ssize_t HttpHeaderPos;
 /* use this and only this to initialize HttpHeaderPos */
 #define HttpHeaderInitPos (-1)
 
+class MemBuf;
+
 class HttpHeaderEntry
 {
 
 public:
     HttpHeaderEntry(http_hdr_type id, const char *name, const char *value);
+    /// creates an entry with a value prefix; known fields ignore the given name
+    HttpHeaderEntry(http_hdr_type id, const SBuf &name, const char *value, const int valueLen);
     ~HttpHeaderEntry();
     static HttpHeaderEntry *parse(const char *field_start, const char *field_end);
     HttpHeaderEntry *clone() const;
+    /// Returns this entry for one more header to hold (instead of a clone).
+    /// Entries held by several headers must not change; see shared().
+    HttpHeaderEntry *share() const;
+    /// whether more than one header holds this entry
+    bool shared() const { return extraHolders > 0; }
+    /// forgets one entry holder, destroying the entry held by nobody else
+    static void Release(HttpHeaderEntry *e);
     void packInto(Packer *p) const;
     int getInt() const;
     int64_t getInt64() const;
     MEMPROXY_CLASS(HttpHeaderEntry);
     http_hdr_type id;
-    String name;
+    SBuf name; ///< known field names share one buffer
     String value;
+
+private:
+    mutable int extraHolders; ///< the number of holders besides the first one
 };
 
 MEMPROXY_CLASS_INLINE(HttpHeaderEntry);
@@ -224,7 +239,10 @@ public:
     void packInto(Packer * p, bool mask_sensitive_info=false) const;
     HttpHeaderEntry *getEntry(HttpHeaderPos * pos) const;
     HttpHeaderEntry *findEntry(http_hdr_type id) const;
+    /// the entry at pos, copied first if it is shared with other headers
+    HttpHeaderEntry *writeableEntry(const HttpHeaderPos pos);
     int delByName(const char *name);
+    int delByName(const SBuf &name);
     int delById(http_hdr_type id);
     void delAt(HttpHeaderPos pos, int &headers_deleted);
     void refreshMask();
@@ -234,9 +252,14 @@ public:
     bool getList(http_hdr_type id, String *s) const;
     String getStrOrList(http_hdr_type id) const;
     bool conflictingContentLength() const { return conflictingContentLength_; }
+    /// changes whenever entries are added, removed, or made writeable
+    uint64_t changeCount() const { return changeCount_; }
     String getByName(const char *name) const;
+    String getByName(const SBuf &name) const;
     /// sets value and returns true iff a [possibly empty] named field is there
     bool getByNameIfPresent(const char *name, String &value) const;
+    bool getByNameIfPresent(const SBuf &name, String &value) const;
+    bool getByNameIfPresent(const char *name, const size_t nameLen, String &value) const;
     String getByNameListMember(const char *name, const char *member, const char separator) const;
     String getListMember(http_hdr_type id, const char *member, const char separator) const;
     int has(http_hdr_type id) const;
@@ -284,7 +307,58 @@ protected:
 
 private:
     HttpHeaderEntry *findLastEntry(http_hdr_type id) const;
+    bool indexedRange(const http_hdr_type id, HttpHeaderPos &first, HttpHeaderPos &last) const;
+    void indexEntry(const HttpHeaderEntry *e, const HttpHeaderPos pos);
+    void unindexEntry(const HttpHeaderEntry *e, const HttpHeaderPos pos);
+    void rebuildIndex();
+    int delByName(const char *name, const size_t nameLen);
+    void noteOtherName(const SBuf &name);
+    bool mayHaveOtherName(const char *name, const size_t nameLen) const;
+    static unsigned int OtherNameHash(const char *name, const size_t nameLen);
+
     bool conflictingContentLength_; ///< found different Content-Length fields
+    uint64_t changeCount_; ///< see changeCount()
+
+    /// Positions (plus one) of the first and the last entries with a given id.
+    /// Meaningful only for ids in the mask; zero if all such entries are gone.
+    uint16_t firstPos[HDR_ENUM_END];
+    uint16_t lastPos[HDR_ENUM_END];
+    bool indexOverflow; ///< too many entries for firstPos and lastPos
+    /// a Bloom filter with one OtherNameHash() bit per HDR_OTHER entry name
+    uint64_t otherNames[4];
+};
+
+/**
+ * Packed fields of a stored header (e.g., a cached reply header) used for
+ * packing other headers that share those fields (e.g., replies to cache
+ * hits) without serializing every shared field again.
+ */
+class HttpHeaderImage
+{
+public:
+    HttpHeaderImage();
+    ~HttpHeaderImage();
+
+    /// Packs hdr like HttpHeader::packInto() does, copying runs of fields
+    /// shared with the source header from the source image. The image is
+    /// built when the same source version is packed for the second time.
+    void packInto(Packer *p, const HttpHeader &hdr, const HttpHeader &source);
+
+    /// forgets the image; required before the source header is destroyed
+    void clear();
+
+private:
+    HttpHeaderImage(const HttpHeaderImage &); // not implemented
+    HttpHeaderImage &operator =(const HttpHeaderImage &); // not implemented
+
+    void build(const HttpHeader &src);
+    void packRun(Packer *p, const size_t first, const size_t end) const;
+
+    const HttpHeader *source; ///< the last header given to packInto()
+    uint64_t sourceChanges; ///< source->changeCount() when we saw it
+    MemBuf *image; ///< packed source fields; nil until the source is reused
+    std::vector<const HttpHeaderEntry *> fields; ///< source fields in image order
+    std::vector<size_t> offsets; ///< field offsets in the image plus its size
 };
 
 int httpHeaderParseQuotedString(const char *start, const int len, String *val);
@@ -313,12 +313,13 @@ httpHeaderQuoteString(const char *raw)
  * \retval 1    Header has no access controls to test
  */
 static int
-httpHdrMangle(HttpHeaderEntry * e, HttpRequest * request, int req_or_rep)
+httpHdrMangle(HttpHeader * l, const HttpHeaderPos pos, HttpRequest * request, int req_or_rep)
 {
     int retval;
 
     /* check with anonymizer tables */
     HeaderManglers *hms = NULL;
+    const HttpHeaderEntry *e = l->entries[pos];
     assert(e);
 
     if (ROR_REQUEST == req_or_rep) {
@@ -352,9 +353,9 @@ httpHdrMangle(HttpHeaderEntry * e, HttpRequest * request, int req_or_rep)
     } else {
         /* It was denied, but we have a replacement. Replace the
          * header on the fly, and return that the new header
-         * is allowed.
+         * is allowed. The entry may be shared with the cached reply.
          */
-        e->value = hm->replacement;
+        l->writeableEntry(pos)->value = hm->replacement;
         retval = 1;
     }
 
@@ -370,7 +371,7 @@ httpHdrMangleList(HttpHeader * l, HttpRequest * request, int req_or_rep)
 
     int headers_deleted = 0;
     while ((e = l->getEntry(&p)))
-        if (0 == httpHdrMangle(e, request, req_or_rep))
+        if (0 == httpHdrMangle(l, p, request, req_or_rep))
             l->delAt(p, headers_deleted);
 
     if (headers_deleted)
@@ -500,7 +501,7 @@ HeaderManglers::find(const HttpHeaderEntry &e) const
     if (e.id == HDR_OTHER) {
         // does it have an ACL list configured?
         // Optimize: use a name type that we do not need to convert to here
-        const ManglersByName::const_iterator i = custom.find(e.name.termedBuf());
+        const ManglersByName::const_iterator i = custom.find(e.name.toStdString());
         if (i != custom.end())
             return &i->second;
     }
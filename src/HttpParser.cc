@@ -25,6 +25,11 @@ HttpParser::clear()
     req.u_start = req.u_end = -1;
     req.v_start = req.v_end = -1;
     req.v_maj = req.v_min = 0;
+    lineScan.offset = 0;
+    lineScan.first_whitespace = lineScan.last_whitespace = -1;
+    lineScan.second_word = -1;
+    hdrScanOffset = 0;
+    hdrScanState = 1;
 }
 
 void
@@ -37,28 +42,48 @@ HttpParser::reset(const char *aBuf, int len)
     debugs(74, 5, HERE << "Request buffer is " << buf);
 }
 
+void
+HttpParser::resume(const char *aBuf, int len)
+{
+    // a shrunk buffer cannot hold the message we have been parsing
+    if (state != HTTP_PARSE_MORE || len < bufsiz) {
+        reset(aBuf, len);
+        return;
+    }
+
+    state = HTTP_PARSE_NEW;
+    request_parse_status = Http::scNone;
+    buf = aBuf;
+    bufsiz = len;
+    debugs(74, 5, HERE << "resuming at " << lineScan.offset << '/' << hdrScanOffset << " of " << bufsiz << " bytes");
+}
+
 int
 HttpParser::parseRequestFirstLine()
 {
-    int second_word = -1; // track the suspected URI start
-    int first_whitespace = -1, last_whitespace = -1; // track the first and last SP byte
+    // continue tracking where the previous call stopped, if any
+    int second_word = lineScan.second_word; // track the suspected URI start
+    int first_whitespace = lineScan.first_whitespace; // track the first SP byte
+    int last_whitespace = lineScan.last_whitespace; // track the last SP byte
     int line_end = -1; // tracks the last byte BEFORE terminal \r\n or \n sequence
 
     debugs(74, 5, HERE << "parsing possible request: " << buf);
 
     // Single-pass parse: (provided we have the whole line anyways)
 
-    req.start = 0;
-    if (Config.onoff.relaxed_header_parser) {
-        if (Config.onoff.relaxed_header_parser < 0 && buf[req.start] == ' ')
+    if (req.start < 0) {
+        req.start = 0;
+        if (Config.onoff.relaxed_header_parser < 0 && bufsiz > 0 && buf[req.start] == ' ')
             debugs(74, DBG_IMPORTANT, "WARNING: Invalid HTTP Request: " <<
                    "Whitespace bytes received ahead of method. " <<
                    "Ignored due to relaxed_header_parser.");
+    }
+    if (Config.onoff.relaxed_header_parser) {
         // Be tolerant of prefix spaces (other bytes are valid method values)
         for (; req.start < bufsiz && buf[req.start] == ' '; ++req.start);
     }
     req.end = -1;
-    for (int i = 0; i < bufsiz; ++i) {
+    for (int i = lineScan.offset; i < bufsiz; ++i) {
         // track first and last whitespace (SP only)
         if (buf[i] == ' ') {
             last_whitespace = i;
@@ -109,6 +134,11 @@ HttpParser::parseRequestFirstLine()
         }
     }
     if (req.end == -1) {
+        // the last byte may be a CR waiting for its LF; scan it again
+        lineScan.offset = max(bufsiz - 1, 0);
+        lineScan.first_whitespace = first_whitespace;
+        lineScan.last_whitespace = last_whitespace;
+        lineScan.second_word = second_word;
         debugs(74, 5, "Parser: retval 0: from " << req.start <<
                "->" << req.end << ": needs more data to complete first line.");
         return 0;
@@ -245,6 +275,36 @@ HttpParser::parseRequestFirstLine()
     return 1;
 }
 
+size_t
+HttpParser::findHeadersEnd()
+{
+    // the headersEnd() state machine, resumed at the byte where it stopped;
+    // state 1 means "at the start of a line"
+    while (hdrScanOffset < bufsiz && hdrScanState < 3) {
+        const char c = buf[hdrScanOffset];
+        switch (hdrScanState) {
+        case 0:
+            if (c == '\n')
+                hdrScanState = 1;
+            break;
+        case 1:
+            if (c == '\r')
+                hdrScanState = 2;
+            else if (c == '\n')
+                hdrScanState = 3;
+            else
+                hdrScanState = 0;
+            break;
+        case 2:
+            hdrScanState = (c == '\n') ? 3 : 0;
+            break;
+        }
+        ++hdrScanOffset;
+    }
+
+    return hdrScanState == 3 ? hdrScanOffset : 0;
+}
+
 int
 HttpParserParseReqLine(HttpParser *hmsg)
 {
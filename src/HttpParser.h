@@ -14,6 +14,7 @@
 // Parser states
 #define HTTP_PARSE_NONE   0 // nothing. completely unset state.
 #define HTTP_PARSE_NEW    1 // initialized, but nothing usefully parsed yet.
+#define HTTP_PARSE_MORE   2 // partially parsed, waiting for more bytes of the same message.
 
 /** HTTP protocol parser.
  *
@@ -42,6 +43,12 @@ public:
     /// Reset the parser for use on a new buffer.
     void reset(const char *aBuf, int len);
 
+    /** Continue parsing the same message after more bytes were appended.
+     * The new buffer must start with the bytes given to the previous
+     * reset() or resume() call. Bytes already scanned are not scanned again.
+     */
+    void resume(const char *aBuf, int len);
+
     /**
      * Attempt to parse the first line of a new request message.
      *
@@ -49,8 +56,8 @@ public:
      *  RFC 1945 section 5.1
      *  RFC 2616 section 5.1
      *
-     * Parsing state is stored between calls. However the current implementation
-     * begins parsing from scratch on every call.
+     * Parsing state is stored between calls. After resume(), the search for
+     * the line terminator continues where the previous call stopped.
      * The return value tells you whether the parsing state fields are valid or not.
      *
      * \retval -1  an error occurred. request_parse_status indicates HTTP status result.
@@ -59,6 +66,14 @@ public:
      */
     int parseRequestFirstLine();
 
+    /** Find the end of the mime headers block following the request line.
+     * Like headersEnd(), but resumes where the previous call stopped.
+     *
+     * \retval 0  the headers terminator has not been received yet
+     * \return the request prefix size, including the headers terminator
+     */
+    size_t findHeadersEnd();
+
 public:
     uint8_t state;
     const char *buf;
@@ -82,6 +97,18 @@ public:
      * Http::scNone indicates incomplete parse, Http::scOkay indicates no error.
      */
     Http::StatusCode request_parse_status;
+
+private:
+    /// parseRequestFirstLine() progress kept for resume()
+    struct line_scan {
+        int offset; // the first byte to scan when more data arrives
+        int first_whitespace, last_whitespace; // first and last SP byte
+        int second_word; // the suspected URI start
+    } lineScan;
+
+    /// findHeadersEnd() progress kept for resume()
+    int hdrScanOffset;
+    int hdrScanState;
 };
 
 // Legacy functions
@@ -102,6 +102,22 @@ HttpReply::pack()
     return mb;
 }
 
+MemBuf *
+HttpReply::pack(HttpHeaderImage &image, const HttpReply &stored)
+{
+    MemBuf *mb = new MemBuf;
+    Packer p;
+
+    mb->init();
+    packerToMemInit(&p, mb);
+    sline.packInto(&p);
+    image.packInto(&p, header, stored.header);
+    packerAppend(&p, "\r\n", 2);
+    body.packInto(&p);
+    packerClean(&p);
+    return mb;
+}
+
 HttpReply *
 HttpReply::make304() const
 {
@@ -122,7 +138,7 @@ HttpReply::make304() const
 
     for (t = 0; ImsEntries[t] != HDR_OTHER; ++t)
         if ((e = header.findEntry(ImsEntries[t])))
-            rv->header.addEntry(e->clone());
+            rv->header.addEntry(e->share());
 
     rv->putCc(cache_control);
 
@@ -81,6 +81,11 @@ public:
     /** \return a ready to use mem buffer with a packed reply */
     MemBuf *pack();
 
+    /** \return pack() result, with header fields shared with the stored
+     * reply copied from its image when possible
+     */
+    MemBuf *pack(HttpHeaderImage &image, const HttpReply &stored);
+
     /** construct a 304 reply and return it */
     HttpReply *make304() const;
 
@@ -127,6 +127,7 @@ HttpRequest::clean()
     vary_headers.clear();
     url.clear();
     urlpath.clean();
+    aclResults.clear();
 
     header.clean();
 
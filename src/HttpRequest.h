@@ -9,6 +9,7 @@
 #ifndef SQUID_HTTPREQUEST_H
 #define SQUID_HTTPREQUEST_H
 
+#include "acl/ResultCache.h"
 #include "base/CbcPointer.h"
 #include "Debug.h"
 #include "err_type.h"
@@ -83,6 +84,7 @@ public:
             host_is_numeric = 1;
         }
         safe_free(canonical); // force its re-build
+        aclResults.clear(); // and re-check of host-based ACLs
     };
     inline const char* GetHost(void) const { return host; };
     inline int GetHostIsNumeric(void) const { return host_is_numeric; };
@@ -245,6 +247,9 @@ public:
      */
     CbcPointer<ConnStateData> clientConnectionManager;
 
+    /// results of ACLs that depend on the request URL and method only
+    Acl::ResultCache aclResults;
+
     /// forgets about the cached Range header (for a reason)
     void ignoreRange(const char *reason);
     int64_t getRangeOffsetLimit(); /* the result of this function gets cached in rangeOffsetLimit */
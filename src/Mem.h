@@ -32,6 +32,7 @@ public:
     static void CleanIdlePools(void *unused);
     static void Report(std::ostream &);
     static void PoolReport(const MemPoolStats * mp_st, const MemPoolMeter * AllMeter, std::ostream &);
+    static void SlabClassReport(std::ostream &);
 
 protected:
     static void RegisterWithCacheManager(void);
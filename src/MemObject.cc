@@ -92,7 +92,7 @@ MemObject::setUris(char const *aStoreId, char const *aLogUri, const HttpRequestM
 #endif
 }
 
-MemObject::MemObject(): smpCollapsed(false)
+MemObject::MemObject(): smpCollapsed(false), headerImage_(NULL)
 {
     debugs(20, 3, HERE << "new MemObject " << this);
     _reply = new HttpReply;
@@ -131,6 +131,8 @@ MemObject::~MemObject()
 
 #endif
 
+    delete headerImage_; // before _reply, the image source, is gone
+
     HTTPMSGUNLOCK(_reply);
 
     HTTPMSGUNLOCK(request);
@@ -187,11 +189,21 @@ MemObject::getReply() const
 void
 MemObject::replaceHttpReply(HttpReply *newrep)
 {
+    if (headerImage_)
+        headerImage_->clear();
     HTTPMSGUNLOCK(_reply);
     _reply = newrep;
     HTTPMSGLOCK(_reply);
 }
 
+HttpHeaderImage &
+MemObject::headerImage()
+{
+    if (!headerImage_)
+        headerImage_ = new HttpHeaderImage;
+    return *headerImage_;
+}
+
 struct LowestMemReader : public unary_function<store_client, void> {
     LowestMemReader(int64_t seed):current(seed) {}
 
@@ -27,6 +27,7 @@ typedef void STMCB (void *data, StoreIOBuffer wroteBuffer);
 class store_client;
 class HttpRequest;
 class HttpReply;
+class HttpHeaderImage;
 
 class MemObject
 {
@@ -49,6 +50,8 @@ public:
     void unlinkRequest();
     HttpReply const *getReply() const;
     void replaceHttpReply(HttpReply *newrep);
+    /// packed stored reply header fields for packing replies to hits
+    HttpHeaderImage &headerImage();
     void stat (MemBuf * mb) const;
     int64_t endOffset () const;
     void markEndOfReplyHeaders(); ///< sets _reply->hdr_sz to endOffset()
@@ -175,6 +178,7 @@ public:
 
 private:
     HttpReply *_reply;
+    HttpHeaderImage *headerImage_; ///< lazily created; see headerImage()
 
     mutable String storeId_; ///< StoreId for our entry (usually request URI)
     mutable String logUri_;  ///< URI used for logging (usually request URI)
@@ -73,6 +73,7 @@ MemStore::init()
     Must(!map);
     map = new MemStoreMap(MapLabel);
     map->cleaner = this;
+    map->evictionPolicy(static_cast<Ipc::StoreMap::EvictionPolicy>(Config.memEviction));
 }
 
 void
@@ -123,6 +124,10 @@ MemStore::stat(StoreEntry &e) const
                 stats.dump(e);
             }
         }
+
+        storeAppendPrintf(&e, "Eviction policy: %s\n",
+                          Ipc::StoreMap::EvictionPolicyName(map->evictionPolicy()));
+        map->probeStats().dump(e);
     }
 }
 
@@ -40,7 +40,8 @@ SBufStats::SBufStats()
       assignFast(0), clear(0), append(0), toStream(0), setChar(0),
       getChar(0), compareSlow(0), compareFast(0), copyOut(0),
       rawAccess(0), nulTerminate(0), chop(0), trim(0), find(0), scanf(0),
-      caseChange(0), cowFast(0), cowSlow(0), live(0)
+      caseChange(0), cowFast(0), cowSlow(0), bytesCopied(0), bytesShared(0),
+      live(0)
 {}
 
 SBufStats&
@@ -68,6 +69,8 @@ SBufStats::operator +=(const SBufStats& ss)
     caseChange += ss.caseChange;
     cowFast += ss.cowFast;
     cowSlow += ss.cowSlow;
+    bytesCopied += ss.bytesCopied;
+    bytesShared += ss.bytesShared;
     live += ss.live;
 
     return *this;
@@ -87,6 +90,7 @@ SBuf::SBuf(const SBuf &S)
     debugs(24, 8, id << " created from id " << S.id);
     ++stats.alloc;
     ++stats.allocCopy;
+    stats.bytesShared += len_;
     ++stats.live;
 }
 
@@ -143,6 +147,7 @@ SBuf::assign(const SBuf &S)
     store_ = S.store_;
     off_ = S.off_;
     len_ = S.len_;
+    stats.bytesShared += len_;
     return *this;
 }
 
@@ -860,6 +865,8 @@ SBufStats::dump(std::ostream& os) const
        "\ncase-change ops: " << caseChange <<
        "\nCOW not actually requiring a copy: " << cowFast <<
        "\nCOW: " << cowSlow <<
+       "\nbytes copied: " << bytesCopied <<
+       "\nbytes shared without copying: " << bytesShared <<
        "\naverage store share factor: " <<
        (ststats.live != 0 ? static_cast<float>(live)/ststats.live : 0) <<
        std::endl;
@@ -932,6 +939,7 @@ SBuf::reAlloc(size_type newsize)
     store_ = newbuf;
     off_ = 0;
     ++stats.cowSlow;
+    stats.bytesCopied += length();
     debugs(24, 7, id << " new store capacity: " << store_->capacity);
 }
 
@@ -942,6 +950,7 @@ SBuf::lowAppend(const char * memArea, size_type areaSize)
     store_->append(memArea, areaSize);
     len_ += areaSize;
     ++stats.append;
+    stats.bytesCopied += areaSize;
     return *this;
 }
 
@@ -65,6 +65,8 @@ public:
     uint64_t caseChange; ///<number of toUpper and toLower operations
     uint64_t cowFast; ///<number of cow operations not actually requiring a copy
     uint64_t cowSlow; ///<number of cow operations requiring a copy
+    uint64_t bytesCopied; ///<bytes copied into SBuf stores by appends and COW
+    uint64_t bytesShared; ///<bytes made available by copies and assignments without copying
     uint64_t live;  ///<number of currently-allocated SBuf
 
     ///Dump statistics to an ostream.
@@ -12,11 +12,13 @@
 #include "mgr/Registration.h"
 #include "SBufDetailedStats.h"
 #include "SBufStatsAction.h"
+#include "StatCounters.h"
 #include "StoreEntryStream.h"
 
 SBufStatsAction::SBufStatsAction(const Mgr::CommandPointer &cmd_):
-    Action(cmd_)
-{ } //default constructor is OK for data member
+    Action(cmd_),
+    requests(0)
+{ } //default constructor is OK for other data members
 
 SBufStatsAction::Pointer
 SBufStatsAction::Create(const Mgr::CommandPointer &cmd)
@@ -28,6 +30,7 @@ void
 SBufStatsAction::add(const Mgr::Action& action)
 {
     sbdata += dynamic_cast<const SBufStatsAction&>(action).sbdata;
+    requests += dynamic_cast<const SBufStatsAction&>(action).requests;
     mbdata += dynamic_cast<const SBufStatsAction&>(action).mbdata;
     sbsizesatdestruct += dynamic_cast<const SBufStatsAction&>(action).sbsizesatdestruct;
     mbsizesatdestruct += dynamic_cast<const SBufStatsAction&>(action).mbsizesatdestruct;
@@ -37,6 +40,7 @@ void
 SBufStatsAction::collect()
 {
     sbdata = SBuf::GetStats();
+    requests = statCounter.client_http.requests;
     mbdata = MemBlob::GetStats();
     sbsizesatdestruct = collectSBufDestructTimeStats();
     mbsizesatdestruct = collectMemBlobDestructTimeStats();
@@ -58,6 +62,12 @@ SBufStatsAction::dump(StoreEntry* entry)
         "should not be relied upon, they are bound to change as "
         "the SBuf feature is evolved\n";
     sbdata.dump(ses);
+    if (requests) {
+        ses << "bytes copied per client request: " <<
+            static_cast<double>(sbdata.bytesCopied)/requests <<
+            "\nbytes shared per client request: " <<
+            static_cast<double>(sbdata.bytesShared)/requests << "\n";
+    }
     mbdata.dump(ses);
     ses << "\n";
     ses << "SBuf size distribution at destruct time:\n";
@@ -71,6 +81,7 @@ SBufStatsAction::pack(Ipc::TypedMsgHdr& msg) const
 {
     msg.setType(Ipc::mtCacheMgrResponse);
     msg.putPod(sbdata);
+    msg.putPod(requests);
     msg.putPod(mbdata);
 }
 
@@ -79,6 +90,7 @@ SBufStatsAction::unpack(const Ipc::TypedMsgHdr& msg)
 {
     msg.checkType(Ipc::mtCacheMgrResponse);
     msg.getPod(sbdata);
+    msg.getPod(requests);
     msg.getPod(mbdata);
 }
 
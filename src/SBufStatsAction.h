@@ -36,6 +36,7 @@ private:
     virtual void unpack(const Ipc::TypedMsgHdr& msg);
 
     SBufStats sbdata;
+    uint64_t requests; ///< client HTTP requests, for per-request averages
     MemBlobStats mbdata;
     StatHist sbsizesatdestruct;
     StatHist mbsizesatdestruct;
@@ -62,6 +62,7 @@ public:
     } Swap;
 
     YesNoNone memShared; ///< whether the memory cache is shared among workers
+    int memEviction; ///< Ipc::StoreMap::EvictionPolicy of the shared memory cache
     size_t memMaxSize;
 
     struct {
@@ -100,6 +101,7 @@ public:
         int mcast_icp_query;    /* msec */
         time_msec_t idns_retransmit;
         time_msec_t idns_query;
+        time_msec_t happyEyeballsConnect;
     } Timeout;
     size_t maxRequestHeaderSize;
     int64_t maxRequestBodySize;
@@ -327,6 +329,8 @@ public:
         int client_dst_passthru;
         int dns_mdns;
         int dns_aaaa;
+        int regex_prefilter;
+        int dns_cache_shared;
     } onoff;
 
     int pipeline_max_prefetch;
@@ -537,6 +541,11 @@ public:
         ssize_t packet_max; ///< maximum size EDNS advertised for DNS replies.
     } dns;
 
+    struct {
+        int idleLimit; ///< maximum idle connections per server pool; 0 means no limit
+        int idleLimitPerDestination; ///< maximum idle connections per destination; 0 means no limit
+    } pconn;
+
 };
 
 extern SquidConfig Config;
@@ -42,6 +42,8 @@ public:
         kb_t kbytes_in;
         kb_t kbytes_out;
         kb_t hit_kbytes_out;
+        int sendfile_writes; ///< disk hit body parts sent by Comm::SendFile()
+        kb_t sendfile_kbytes_out;
         StatHist missSvcTime;
         StatHist nearMissSvcTime;
         StatHist nearHitSvcTime;
@@ -143,6 +145,7 @@ public:
             int closes;
             int reads;
             int writes;
+            int sendfiles;
             int recvfroms;
             int sendtos;
         } sock;
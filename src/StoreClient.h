@@ -15,6 +15,7 @@
 
 typedef void STCB(void *, StoreIOBuffer);   /* store callback */
 
+class mem_node;
 class StoreEntry;
 
 class StoreClient
@@ -61,6 +62,9 @@ public:
         bool disk_io_pending;
         bool store_copying;
         bool copy_event_pending;
+        /// in-memory data may be delivered in place, one page at a time;
+        /// it stays valid until the next copy() or our destruction
+        bool lend_pages;
     } flags;
 
 #if USE_DELAY_POOLS
@@ -81,9 +85,11 @@ private:
     void scheduleRead();
     bool startSwapin();
     bool unpackHeader(char const *buf, ssize_t len);
+    void returnLentPage();
 
     int type;
     bool object_ok;
+    mem_node *lentPage; ///< pinned page our last callback pointed into
 
     /* Until we finish stuffing code into store_client */
 
@@ -10,6 +10,7 @@
 
 #include "squid.h"
 #include "base/TextException.h"
+#include "SBuf.h"
 #include "SquidString.h"
 #include "StrList.h"
 
@@ -49,6 +50,23 @@ strListIsMember(const String * list, const char *m, char del)
     return 0;
 }
 
+/** returns true iff "m" is a member of the list */
+int
+strListIsMember(const String * list, const SBuf &m, char del)
+{
+    const char *pos = NULL;
+    const char *item;
+    int ilen = 0;
+
+    assert(list);
+    const int mlen = m.length();
+    while (strListGetItem(list, del, &item, &ilen, &pos)) {
+        if (mlen == ilen && !strncasecmp(item, m.rawContent(), ilen))
+            return 1;
+    }
+    return 0;
+}
+
 /** returns true iff "s" is a substring of a member of the list */
 int
 strListIsSubstr(const String * list, const char *s, char del)
@@ -11,10 +11,12 @@
 #ifndef SQUID_STRLIST_H_
 #define SQUID_STRLIST_H_
 
+class SBuf;
 class String;
 
 void strListAdd(String * str, const char *item, char del);
 int strListIsMember(const String * str, const char *item, char del);
+int strListIsMember(const String * str, const SBuf &item, char del);
 int strListIsSubstr(const String * list, const char *s, char del);
 int strListGetItem(const String * str, char del, const char **item, int *ilen, const char **pos);
 
@@ -47,6 +47,12 @@ SwapDir::doubleCheck(StoreEntry &)
     return false;
 }
 
+int
+SwapDir::openContiguous(const StoreEntry &)
+{
+    return -1;
+}
+
 void
 SwapDir::unlink(StoreEntry &) {}
 
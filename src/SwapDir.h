@@ -218,6 +218,12 @@ public:
     virtual void sync();    /* Sync the store prior to shutdown */
     virtual StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STFNCB *, StoreIOState::STIOCB *, void *) = 0;
     virtual StoreIOState::Pointer openStoreIO(StoreEntry &, StoreIOState::STFNCB *, StoreIOState::STIOCB *, void *) = 0;
+    /// Opens the file holding the entry if the whole stored entry (swap
+    /// metadata followed by the object) is a contiguous run of its bytes,
+    /// so that it can be sent with sendfile(2). Called from the main loop;
+    /// the caller closes the descriptor with file_close().
+    /// \returns the open file descriptor or a negative value
+    virtual int openContiguous(const StoreEntry &);
     virtual void unlink (StoreEntry &);
     bool canLog(StoreEntry const &e)const;
     virtual void openLog();
@@ -87,6 +87,7 @@ Transients::stat(StoreEntry &e) const
             storeAppendPrintf(&e, "Current entries: %" PRId64 " %.2f%%\n",
                               currentCount(), (100.0 * currentCount() / limit));
         }
+        map->probeStats().dump(e);
     }
 }
 
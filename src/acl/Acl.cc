@@ -150,8 +150,17 @@ ACL::matches(ACLChecklist *checklist) const
         debugs(28, DBG_IMPORTANT, "WARNING: " << name << " ACL is used in " <<
                "context without an HTTP response. Assuming mismatch.");
     } else {
-        // have to cast because old match() API is missing const
-        result = const_cast<ACL*>(this)->match(checklist);
+        const Acl::ResultScope scope = resultScope();
+        Acl::ResultCache *cache = scope == Acl::rsCheck ? NULL : checklist->resultCache(scope);
+        if (!cache || !cache->find(this, scope, result)) {
+            const unsigned asyncAttempts = checklist->asyncAttempts();
+            // have to cast because old match() API is missing const
+            result = const_cast<ACL*>(this)->match(checklist);
+            // results of failed or pending lookups may change
+            if (cache && (result == 0 || result == 1) &&
+                    checklist->asyncAttempts() == asyncAttempts && !checklist->finished())
+                cache->add(this, result);
+        }
     }
 
     const char *extra = checklist->asyncInProgress() ? " async" : "";
@@ -375,6 +384,12 @@ ACL::requiresRequest() const
     return false;
 }
 
+Acl::ResultScope
+ACL::resultScope() const
+{
+    return Acl::rsCheck;
+}
+
 /*********************/
 /* Destroy functions */
 /*********************/
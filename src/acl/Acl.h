@@ -10,6 +10,7 @@
 #define SQUID_ACL_H
 
 #include "acl/forward.h"
+#include "acl/ResultCache.h"
 #include "cbdata.h"
 #include "defines.h"
 #include "dlink.h"
@@ -148,6 +149,8 @@ private:
     virtual bool requiresRequest() const;
     /// whether our (i.e. shallow) match() requires checklist to have a reply
     virtual bool requiresReply() const;
+    /// for how long our match() result may be reused without calling match()
+    virtual Acl::ResultScope resultScope() const;
 };
 
 /// \ingroup ACLAPI
@@ -118,6 +118,8 @@ ACLChecklist::goAsync(AsyncState *state)
     assert(!asyncInProgress());
     assert(matchLoc_.parent);
 
+    ++asyncAttempts_; // the ACL result depends on this lookup
+
     // TODO: add a once-in-a-while WARNING about fast directive using slow ACL?
     if (!asyncCaller_) {
         debugs(28, 2, this << " a fast-only directive uses a slow ACL!");
@@ -184,7 +186,8 @@ ACLChecklist::ACLChecklist() :
     allow_(ACCESS_DENIED),
     asyncStage_(asyncNone),
     state_(NullState::Instance()),
-    asyncLoopDepth_(0)
+    asyncLoopDepth_(0),
+    asyncAttempts_(0)
 {
 }
 
@@ -164,6 +164,12 @@ public:
     virtual bool hasRequest() const = 0;
     virtual bool hasReply() const = 0;
 
+    /// where to remember ACL results valid for the given scope, if anywhere
+    virtual Acl::ResultCache *resultCache(const Acl::ResultScope) { return NULL; }
+
+    /// the number of goAsync() calls so far, successful or not
+    unsigned asyncAttempts() const { return asyncAttempts_; }
+
 private:
     /// Calls non-blocking check callback with the answer and destroys self.
     void checkCallback(allow_t answer);
@@ -218,6 +224,7 @@ private: /* internal methods */
     Breadcrumb matchLoc_; ///< location of the node running matches() now
     Breadcrumb asyncLoc_; ///< currentNode_ that called goAsync()
     unsigned asyncLoopDepth_; ///< how many times the current async state has resumed
+    unsigned asyncAttempts_; ///< how many times an ACL tried to go async
 
     bool callerGone();
 
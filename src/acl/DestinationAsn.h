@@ -20,6 +20,7 @@ class ACLDestinationASNStrategy : public ACLStrategy<Ip::Address>
 public:
     virtual int match (ACLData<MatchType> * &, ACLFilledChecklist *, ACLFlags &);
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     static ACLDestinationASNStrategy *Instance();
 
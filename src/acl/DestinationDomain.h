@@ -22,6 +22,7 @@ public:
     virtual int match (ACLData<MatchType> * &, ACLFilledChecklist *, ACLFlags &);
     static ACLDestinationDomainStrategy *Instance();
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     /**
      * Not implemented to prevent copies of the instance.
@@ -33,6 +33,7 @@ public:
     ACLDestinationIP(): ACLIP(ACLDestinationIP::SupportedFlags) {}
     virtual char const *typeString() const;
     virtual int match(ACLChecklist *checklist);
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     virtual ACL *clone()const;
 
@@ -11,7 +11,7 @@
 
 #include "acl/Acl.h"
 #include "acl/Data.h"
-#include "splay.h"
+#include "acl/DomainIndex.h"
 
 /// \ingroup ACLAPI
 class ACLDomainData : public ACLData<char const *>
@@ -20,6 +20,7 @@ class ACLDomainData : public ACLData<char const *>
 public:
     MEMPROXY_CLASS(ACLDomainData);
 
+    ACLDomainData(): domains(NULL) {}
     virtual ~ACLDomainData();
     virtual bool match(char const *);
     virtual SBufList dump() const;
@@ -27,7 +28,7 @@ public:
     bool empty() const;
     virtual ACLData<char const *> *clone() const;
 
-    Splay<char *> *domains;
+    Acl::DomainIndex *domains;
 };
 
 MEMPROXY_CLASS_INLINE(ACLDomainData);
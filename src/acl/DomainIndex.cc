@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 28    Access Control */
+
+#include "squid.h"
+#include "acl/Acl.h"
+#include "acl/DomainIndex.h"
+#include "base/RunnersRegistry.h"
+#include "Debug.h"
+#include "globals.h"
+#include "mgr/Registration.h"
+#include "SquidTime.h"
+#include "Store.h"
+
+#include <set>
+
+/// lookup counters shared by all indexes
+static struct {
+    uint64_t lookups;
+    uint64_t matches;
+    uint64_t probes; ///< labels looked up
+} TheStats;
+
+typedef std::set<const Acl::DomainIndex *> DomainIndexes;
+
+/// all live indexes, for cache manager reports
+static DomainIndexes &
+TheIndexes()
+{
+    static DomainIndexes *indexes = new DomainIndexes;
+    return *indexes;
+}
+
+/// \returns the start of the rightmost label of [name, end)
+static const char *
+LabelStart(const char *name, const char *end)
+{
+    while (end > name && end[-1] != '.')
+        --end;
+    return end;
+}
+
+/// FNV-1a hash of the parent node and case-folded label
+static uint32_t
+HashLabel(uint32_t parent, const char *label, size_t len)
+{
+    uint32_t hash = 2166136261U;
+    for (int i = 0; i < 4; ++i, parent >>= 8) {
+        hash ^= parent & 0xFF;
+        hash *= 16777619U;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<unsigned char>(xtolower(label[i]));
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+Acl::DomainIndex::DomainIndex()
+{
+    nodes_.push_back(Node(0, 0, 0));
+    TheIndexes().insert(this);
+}
+
+Acl::DomainIndex::~DomainIndex()
+{
+    TheIndexes().erase(this);
+}
+
+uint32_t
+Acl::DomainIndex::find(uint32_t parent, const char *label, size_t len) const
+{
+    if (slots_.empty())
+        return 0;
+
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = HashLabel(parent, label, len) & mask; ; i = (i + 1) & mask) {
+        const uint32_t id = slots_[i];
+        if (!id)
+            return 0;
+
+        const Node &node = nodes_[id];
+        if (node.parent == parent && node.labelLen == len &&
+                strncasecmp(labelOf(node), label, len) == 0)
+            return id;
+    }
+}
+
+uint32_t
+Acl::DomainIndex::findOrAdd(uint32_t parent, const char *label, size_t len)
+{
+    if (const uint32_t id = find(parent, label, len))
+        return id;
+
+    // keep the load factor under one half
+    if ((nodes_.size() + 1) * 2 > slots_.size())
+        rehash(max(slots_.size() * 2, static_cast<size_t>(64)));
+
+    const uint32_t id = nodes_.size();
+    nodes_.push_back(Node(parent, labels_.size(), len));
+    for (size_t i = 0; i < len; ++i)
+        labels_.push_back(xtolower(label[i]));
+
+    const size_t mask = slots_.size() - 1;
+    size_t i = HashLabel(parent, label, len) & mask;
+    while (slots_[i])
+        i = (i + 1) & mask;
+    slots_[i] = id;
+    return id;
+}
+
+void
+Acl::DomainIndex::rehash(size_t slotCount)
+{
+    slots_.assign(slotCount, 0);
+    const size_t mask = slotCount - 1;
+    for (uint32_t id = 1; id < nodes_.size(); ++id) {
+        const Node &node = nodes_[id];
+        size_t i = HashLabel(node.parent, labelOf(node), node.labelLen) & mask;
+        while (slots_[i])
+            i = (i + 1) & mask;
+        slots_[i] = id;
+    }
+}
+
+const char *
+Acl::DomainIndex::labelOf(const Node &node) const
+{
+    return labels_.empty() ? "" : &labels_[0] + node.label;
+}
+
+/// the domain name ending at the given node, without a leading dot
+std::string
+Acl::DomainIndex::name(uint32_t node) const
+{
+    std::string result;
+    for (; node; node = nodes_[node].parent) {
+        const Node &n = nodes_[node];
+        result.append(labelOf(n), n.labelLen);
+        if (n.parent)
+            result += '.';
+    }
+    return result;
+}
+
+void
+Acl::DomainIndex::add(const char *domain)
+{
+    const bool wildcard = (*domain == '.');
+    const char *name = wildcard ? domain + 1 : domain;
+
+    const char *nameEnd = name + strlen(name);
+    if (name == nameEnd) {
+        debugs(28, DBG_IMPORTANT, "WARNING: Ignoring '" << domain << "' in the ACL named '" << AclMatchedName << "'. It has no labels.");
+        return;
+    }
+
+    // look for earlier entries that make this one redundant
+    uint32_t node = 0;
+    for (const char *labelEnd = nameEnd; ; ) {
+        const char *label = LabelStart(name, labelEnd);
+        if (labelEnd - label > 0xFFFF) {
+            debugs(28, DBG_IMPORTANT, "WARNING: Ignoring '" << domain << "' in the ACL named '" << AclMatchedName << "'. Its labels are too long.");
+            return;
+        }
+
+        if (!(node = find(node, label, labelEnd - label)))
+            break;
+
+        const uint8_t flags = nodes_[node].flags;
+        if (label == name) {
+            if ((flags & nodeWildcard) && !wildcard) {
+                debugs(28, DBG_IMPORTANT, "WARNING: '" << domain << "' is a subdomain of '." << name << "'");
+                debugs(28, DBG_IMPORTANT, "WARNING: You should remove '" << domain << "' from the ACL named '" << AclMatchedName << "'");
+                return;
+            }
+            if ((flags & nodeWildcard) || (!wildcard && (flags & nodeExact))) {
+                debugs(28, 2, "WARNING: '" << domain << "' is duplicated in the list.");
+                debugs(28, 2, "WARNING: You should remove one '" << domain << "' from the ACL named '" << AclMatchedName << "'");
+                return;
+            }
+            break;
+        }
+
+        if (flags & nodeWildcard) {
+            debugs(28, DBG_IMPORTANT, "WARNING: '" << domain << "' is a subdomain of '." << this->name(node) << "'");
+            debugs(28, DBG_IMPORTANT, "WARNING: You should remove '" << domain << "' from the ACL named '" << AclMatchedName << "'");
+            return;
+        }
+
+        labelEnd = label - 1;
+    }
+
+    node = 0;
+    for (const char *labelEnd = nameEnd; ; ) {
+        const char *label = LabelStart(name, labelEnd);
+        const uint32_t parent = node;
+        node = findOrAdd(parent, label, labelEnd - label);
+        if (label == name)
+            break;
+        nodes_[node].flags |= nodeParent;
+        labelEnd = label - 1;
+    }
+
+    Node &entry = nodes_[node];
+    if (!(entry.flags & (nodeExact | nodeWildcard)))
+        entries_.push_back(node);
+
+    if (!wildcard) {
+        entry.flags |= nodeExact;
+        return;
+    }
+
+    if (entry.flags & nodeExact) {
+        debugs(28, DBG_IMPORTANT, "WARNING: '" << name << "' is a subdomain of '" << domain << "'");
+        debugs(28, DBG_IMPORTANT, "WARNING: You should remove '" << name << "' from the ACL named '" << AclMatchedName << "'");
+        entry.flags &= ~nodeExact;
+    }
+    if (entry.flags & nodeParent) {
+        debugs(28, DBG_IMPORTANT, "WARNING: '" << domain << "' covers subdomains listed before it");
+        debugs(28, DBG_IMPORTANT, "WARNING: You should remove those subdomains from the ACL named '" << AclMatchedName << "'");
+    }
+    entry.flags |= nodeWildcard;
+}
+
+bool
+Acl::DomainIndex::match(const char *host, const bool honorWildcards) const
+{
+    ++TheStats.lookups;
+
+    while (*host == '.')
+        ++host;
+
+    bool matched = false;
+    uint32_t node = 0;
+    for (const char *labelEnd = host + strlen(host); *host; ) {
+        const char *label = LabelStart(host, labelEnd);
+        const bool leftmost = (label == host);
+
+        // "*.example.com" matches any name below example.com
+        if (leftmost && honorWildcards && node && labelEnd - label == 1 && *label == '*' &&
+                (nodes_[node].flags & nodeParent)) {
+            matched = true;
+            break;
+        }
+
+        ++TheStats.probes;
+        if (!(node = find(node, label, labelEnd - label)))
+            break;
+
+        const uint8_t flags = nodes_[node].flags;
+        if (leftmost) {
+            matched = (flags & (nodeExact | nodeWildcard));
+            break;
+        }
+
+        if (flags & nodeWildcard) {
+            matched = true;
+            break;
+        }
+
+        labelEnd = label - 1;
+    }
+
+    if (matched)
+        ++TheStats.matches;
+    return matched;
+}
+
+SBufList
+Acl::DomainIndex::dump() const
+{
+    SBufList sl;
+    for (std::vector<uint32_t>::const_iterator i = entries_.begin(); i != entries_.end(); ++i) {
+        const uint8_t flags = nodes_[*i].flags;
+        if (flags & nodeWildcard)
+            sl.push_back(SBuf(".").append(SBuf(name(*i))));
+        else if (flags & nodeExact)
+            sl.push_back(SBuf(name(*i)));
+    }
+    return sl;
+}
+
+size_t
+Acl::DomainIndex::memoryUsed() const
+{
+    return sizeof(*this) +
+           nodes_.capacity() * sizeof(Node) +
+           labels_.capacity() +
+           slots_.capacity() * sizeof(uint32_t) +
+           entries_.capacity() * sizeof(uint32_t);
+}
+
+void
+Acl::DomainIndex::Stats(StoreEntry *e)
+{
+    const DomainIndexes &indexes = TheIndexes();
+    size_t entries = 0;
+    size_t nodes = 0;
+    size_t bytes = 0;
+    for (DomainIndexes::const_iterator i = indexes.begin(); i != indexes.end(); ++i) {
+        entries += (*i)->entries_.size();
+        nodes += (*i)->nodes_.size();
+        bytes += (*i)->memoryUsed();
+    }
+
+    storeAppendPrintf(e, "Domain ACL indexes:\t%" PRIuSIZE "\n", indexes.size());
+    storeAppendPrintf(e, "Domains:\t%" PRIuSIZE "\n", entries);
+    storeAppendPrintf(e, "Trie nodes:\t%" PRIuSIZE "\n", nodes);
+    storeAppendPrintf(e, "Memory:\t%" PRIuSIZE " bytes (%.1f per domain)\n",
+                      bytes, entries ? static_cast<double>(bytes) / entries : 0.0);
+
+    const double uptime = tvSubDsec(squid_start, current_time);
+    storeAppendPrintf(e, "\nLookups:\t%" PRIu64 " (%.1f/sec)\n",
+                      TheStats.lookups, uptime > 0 ? TheStats.lookups / uptime : 0.0);
+    storeAppendPrintf(e, "Matches:\t%" PRIu64 "\n", TheStats.matches);
+    storeAppendPrintf(e, "Labels probed per lookup:\t%.2f\n",
+                      TheStats.lookups ? static_cast<double>(TheStats.probes) / TheStats.lookups : 0.0);
+}
+
+/// registers the domain ACL index report
+class DomainIndexRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    virtual void useConfig();
+};
+RunnerRegistrationEntry(DomainIndexRr);
+
+void
+DomainIndexRr::useConfig()
+{
+    Mgr::RegisterAction("acl_domains", "Domain ACL Index Statistics", &Acl::DomainIndex::Stats, 0, 1);
+}
+
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_ACL_DOMAININDEX_H
+#define SQUID_ACL_DOMAININDEX_H
+
+#include "SBufList.h"
+
+#include <string>
+#include <vector>
+
+class StoreEntry;
+
+namespace Acl
+{
+
+/**
+ * Domain names and .domain wildcards of dstdomain, srcdomain, and
+ * ssl::server_name ACLs, stored as a trie of labels read right to left.
+ * Instead of per-node child containers, every node is found by hashing its
+ * parent node and label, so matching a host costs one hash probe per label.
+ * Labels are kept in a single character arena.
+ */
+class DomainIndex
+{
+public:
+    DomainIndex();
+    ~DomainIndex();
+
+    /// adds a domain name; a leading dot makes it match subdomains as well
+    void add(const char *domain);
+
+    /// whether the host matches an added domain as matchDomainName() does;
+    /// honorWildcards makes a leading "*." host label match deeper entries
+    bool match(const char *host, const bool honorWildcards = false) const;
+
+    bool empty() const { return entries_.empty(); }
+
+    /// added domains, in the order they were added
+    SBufList dump() const;
+
+    /// reports memory use and lookup counts of all indexes
+    static void Stats(StoreEntry *e);
+
+private:
+    DomainIndex(const DomainIndex &); // not implemented
+    DomainIndex &operator =(const DomainIndex &); // not implemented
+
+    enum {
+        nodeExact = 1 << 0, ///< an added domain name ends here
+        nodeWildcard = 1 << 1, ///< an added .domain ends here
+        nodeParent = 1 << 2 ///< longer names go through here
+    };
+
+    /// a trie node: one label of one or more added domain names
+    class Node
+    {
+    public:
+        Node(uint32_t aParent, uint32_t aLabel, uint16_t aLen):
+            parent(aParent), label(aLabel), labelLen(aLen), flags(0) {}
+
+        uint32_t parent; ///< the node of the label on our right
+        uint32_t label; ///< labels_ offset of our lowercase label
+        uint16_t labelLen;
+        uint8_t flags;
+    };
+
+    uint32_t find(uint32_t parent, const char *label, size_t len) const;
+    uint32_t findOrAdd(uint32_t parent, const char *label, size_t len);
+    void rehash(size_t slotCount);
+    const char *labelOf(const Node &node) const;
+    std::string name(uint32_t node) const;
+    size_t memoryUsed() const;
+
+    std::vector<Node> nodes_; ///< nodes_[0] is the root (the empty suffix)
+    std::vector<char> labels_; ///< the label arena
+    std::vector<uint32_t> slots_; ///< open addressing hash of nodes_ ids
+    std::vector<uint32_t> entries_; ///< nodes of added domains, in order
+};
+
+} // namespace Acl
+
+#endif /* SQUID_ACL_DOMAININDEX_H */
+
@@ -29,6 +29,7 @@ public:
 
     virtual char const *typeString() const;
     virtual void parse();
+    virtual void prepareForUse() { data->prepareForUse(); }
 
     virtual int match(ACLChecklist *checklist);
     virtual SBufList dump() const;
@@ -81,6 +81,28 @@ ACLFilledChecklist::conn(ConnStateData *aConn)
     conn_ = cbdataReference(aConn);
 }
 
+Acl::ResultCache *
+ACLFilledChecklist::resultCache(const Acl::ResultScope scope)
+{
+    switch (scope) {
+    case Acl::rsTransaction:
+        return request ? &request->aclResults : NULL;
+
+    case Acl::rsConnection: {
+        // the checklist addresses may differ from the connection ones, e.g.,
+        // when they come from X-Forwarded-For
+        ConnStateData *c = conn();
+        if (c && c->clientConnection != NULL &&
+                src_addr == c->clientConnection->remote && my_addr == c->clientConnection->local)
+            return &c->aclResults;
+        return NULL;
+    }
+
+    default:
+        return NULL;
+    }
+}
+
 int
 ACLFilledChecklist::fd() const
 {
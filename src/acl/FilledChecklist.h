@@ -58,6 +58,7 @@ public:
     // ACLChecklist API
     virtual bool hasRequest() const { return request != NULL; }
     virtual bool hasReply() const { return reply != NULL; }
+    virtual Acl::ResultCache *resultCache(const Acl::ResultScope scope);
 
 public:
     Ip::Address src_addr;
@@ -33,6 +33,7 @@ public:
     virtual bool match(HttpHeader* hdr);
     virtual SBufList dump() const;
     virtual void parse();
+    virtual void prepareForUse() { regex_rule->prepareForUse(); }
     virtual bool empty() const;
     virtual ACLData<HttpHeader*> *clone() const;
 
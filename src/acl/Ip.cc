@@ -81,9 +81,10 @@ acl_ip_data::toSBuf() const
  * matching checks.  The first argument (p) is a "host" address,
  * i.e.  the IP address of a cache client.  The second argument (q)
  * is an entry in some address-based access control element.  This
- * function is called via ACLIP::match() and the splay library.
+ * function is called via ACLIP::match() for irregular entries only;
+ * the others are looked up in the ACLIP::data tree.
  */
-int
+static int
 aclIpAddrNetworkCompare(acl_ip_data * const &p, acl_ip_data * const &q)
 {
     Ip::Address A = p->addr1;
@@ -107,43 +108,47 @@ aclIpAddrNetworkCompare(acl_ip_data * const &p, acl_ip_data * const &q)
     }
 }
 
-/*
- * acl_ip_data::NetworkCompare - Compare two acl_ip_data entries.  Strictly
- * used by the splay insertion routine.  It emits a warning if it
- * detects a "collision" or overlap that would confuse the splay
- * sorting algorithm.  Much like aclDomainCompare.
- * The first argument (p) is a "host" address, i.e. the IP address of a cache client.
- * The second argument (b) is a "network" address that might have a subnet and/or range.
- * We mask the host address bits with the network subnet mask.
+/**
+ * Adds the addresses matching an entry to the tree.
+ * The entry matches addresses that equal addr1 (or fall into the addr1-addr2
+ * range) after masking. With a CIDR mask and addr1 and addr2 bits outside
+ * the mask cleared, those addresses form a range the tree can hold.
+ *
+ * \retval true   the entry is in the tree (or matches nothing)
+ * \retval false  the entry needs aclIpAddrNetworkCompare() checks
  */
-int
-acl_ip_data::NetworkCompare(acl_ip_data * const & a, acl_ip_data * const &b)
+static bool
+aclIpAddToTree(Acl::IpTree &tree, const acl_ip_data &q, bool &added)
 {
-    int ret;
-    bool bina = true;
-    ret = aclIpAddrNetworkCompare(b, a);
-
-    if (ret != 0) {
-        bina = false;
-        ret = aclIpAddrNetworkCompare(a, b);
+    struct in6_addr mask;
+    q.mask.getInAddr(mask);
+    unsigned int prefixLen = 0;
+    while (prefixLen < 128 && (mask.s6_addr[prefixLen / 8] & (0x80 >> (prefixLen % 8))))
+        ++prefixLen;
+
+    struct in6_addr first;
+    q.addr1.getInAddr(first);
+    struct in6_addr last;
+    if (q.addr2.isAnyAddr())
+        last = first;
+    else
+        q.addr2.getInAddr(last);
+
+    for (unsigned int bit = prefixLen; bit < 128; ++bit) {
+        const uint8_t bitMask = 0x80 >> (bit % 8);
+        if ((mask.s6_addr[bit / 8] | first.s6_addr[bit / 8] | last.s6_addr[bit / 8]) & bitMask)
+            return false;
+        last.s6_addr[bit / 8] |= bitMask; // all addresses of the last masked value
     }
 
-    if (ret == 0) {
-        char buf_n1[3*(MAX_IPSTRLEN+1)];
-        char buf_n2[3*(MAX_IPSTRLEN+1)];
-        if (bina) {
-            b->toStr(buf_n1, 3*(MAX_IPSTRLEN+1));
-            a->toStr(buf_n2, 3*(MAX_IPSTRLEN+1));
-        } else {
-            a->toStr(buf_n1, 3*(MAX_IPSTRLEN+1));
-            b->toStr(buf_n2, 3*(MAX_IPSTRLEN+1));
-        }
-        debugs(28, DBG_CRITICAL, "WARNING: (" << (bina?'B':'A') << ") '" << buf_n1 << "' is a subnetwork of (" << (bina?'A':'B') << ") '" << buf_n2 << "'");
-        debugs(28, DBG_CRITICAL, "WARNING: because of this '" << (bina?buf_n2:buf_n1) << "' is ignored to keep splay tree searching predictable");
-        debugs(28, DBG_CRITICAL, "WARNING: You should probably remove '" << buf_n1 << "' from the ACL named '" << AclMatchedName << "'");
+    if (memcmp(&last, &first, sizeof(last)) < 0) {
+        debugs(28, 2, "range " << q.toSBuf() << " matches no addresses");
+        added = true;
+        return true;
     }
 
-    return ret;
+    added = tree.addRange(first, last);
+    return true;
 }
 
 /**
@@ -474,7 +479,7 @@ void
 ACLIP::parse()
 {
     if (data == NULL)
-        data = new IPSplay();
+        data = new Acl::IpTree();
 
     flags.parseFlags();
 
@@ -485,59 +490,74 @@ ACLIP::parse()
             /* pop each result off the list and add it to the data tree individually */
             acl_ip_data *next_node = q->next;
             q->next = NULL;
-            if (!data->find(q,acl_ip_data::NetworkCompare))
-                data->insert(q, acl_ip_data::NetworkCompare);
+            bool added = false;
+            if (!aclIpAddToTree(*data, *q, added)) {
+                debugs(28, 3, "checking " << q->toSBuf() << " separately");
+                irregular.push_back(q);
+                added = true;
+            }
+            if (added) {
+                entries.push_back(q);
+            } else {
+                const SBuf entry = q->toSBuf();
+                debugs(28, DBG_IMPORTANT, "WARNING: '" << entry << "' is covered by earlier entries in the ACL named '" << AclMatchedName << "'");
+                debugs(28, DBG_IMPORTANT, "WARNING: You should remove '" << entry << "' from the ACL named '" << AclMatchedName << "'");
+                delete q;
+            }
             q = next_node;
         }
     }
+
+    debugs(28, 3, data->prefixes() << " prefixes in " << data->nodes() << " nodes, " << irregular.size() << " irregular entries");
 }
 
 ACLIP::~ACLIP()
 {
-    if (data) {
-        data->destroy();
-        delete data;
-    }
+    delete data;
+    for (std::vector<acl_ip_data *>::iterator i = entries.begin(); i != entries.end(); ++i)
+        delete *i;
 }
 
-struct IpAclDumpVisitor {
-    SBufList contents;
-    void operator() (acl_ip_data * const & ip) {
-        contents.push_back(ip->toSBuf());
-    }
-};
-
 SBufList
 ACLIP::dump() const
 {
-    IpAclDumpVisitor visitor;
-    data->visit(visitor);
-    return visitor.contents;
+    SBufList contents;
+    for (std::vector<acl_ip_data *>::const_iterator i = entries.begin(); i != entries.end(); ++i)
+        contents.push_back((*i)->toSBuf());
+    return contents;
 }
 
 bool
 ACLIP::empty() const
 {
-    return data->empty();
+    return entries.empty();
 }
 
 int
 ACLIP::match(Ip::Address &clientip)
 {
-    static acl_ip_data ClientAddress;
-    /*
-     * aclIpAddrNetworkCompare() takes two acl_ip_data pointers as
-     * arguments, so we must create a fake one for the client's IP
-     * address. Since we are scanning for a single IP mask and addr2
-     * MUST be set to empty.
-     */
-    ClientAddress.addr1 = clientip;
-    ClientAddress.addr2.setEmpty();
-    ClientAddress.mask.setEmpty();
-
-    const acl_ip_data * const * result =  data->find(&ClientAddress, aclIpAddrNetworkCompare);
-    debugs(28, 3, "aclIpMatchIp: '" << clientip << "' " << (result ? "found" : "NOT found"));
-    return (result != NULL);
+    struct in6_addr addr;
+    clientip.getInAddr(addr);
+    bool found = data->match(addr);
+
+    if (!found && !irregular.empty()) {
+        /*
+         * aclIpAddrNetworkCompare() takes two acl_ip_data pointers as
+         * arguments, so we must create a fake one for the client's IP
+         * address. Since we are scanning for a single IP mask and addr2
+         * MUST be set to empty.
+         */
+        acl_ip_data ClientAddress;
+        ClientAddress.addr1 = clientip;
+        ClientAddress.addr2.setEmpty();
+        ClientAddress.mask.setEmpty();
+        acl_ip_data *client = &ClientAddress;
+        for (std::vector<acl_ip_data *>::const_iterator i = irregular.begin(); !found && i != irregular.end(); ++i)
+            found = (aclIpAddrNetworkCompare(client, *i) == 0);
+    }
+
+    debugs(28, 3, "aclIpMatchIp: '" << clientip << "' " << (found ? "found" : "NOT found"));
+    return found;
 }
 
 acl_ip_data::acl_ip_data() :addr1(), addr2(), mask(), next (NULL) {}
@@ -11,8 +11,10 @@
 
 #include "acl/Acl.h"
 #include "acl/Data.h"
+#include "acl/IpTree.h"
 #include "ip/Address.h"
-#include "splay.h"
+
+#include <vector>
 
 /// \ingroup ACLAPI
 class acl_ip_data
@@ -21,7 +23,6 @@ class acl_ip_data
 public:
     MEMPROXY_CLASS(acl_ip_data);
     static acl_ip_data *FactoryParse(char const *);
-    static int NetworkCompare(acl_ip_data * const & a, acl_ip_data * const &b);
 
     acl_ip_data ();
 
@@ -57,8 +58,6 @@ public:
 
     ~ACLIP();
 
-    typedef Splay<acl_ip_data *> IPSplay;
-
     virtual char const *typeString() const = 0;
     virtual void parse();
     //    virtual bool isProxyAuth() const {return true;}
@@ -69,7 +68,12 @@ public:
 protected:
 
     int match(Ip::Address &);
-    IPSplay *data;
+
+    /// the addresses of all entries, except irregular ones, as prefixes
+    Acl::IpTree *data;
+    std::vector<acl_ip_data *> entries; ///< parsed entries, for dump()
+    /// entries with non-CIDR masks, which are checked one by one
+    std::vector<acl_ip_data *> irregular;
 
 };
 
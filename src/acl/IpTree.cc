@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 28    Access Control */
+
+#include "squid.h"
+#include "acl/IpTree.h"
+
+typedef Acl::IpTree::Key Key;
+
+static const uint64_t AllOnes = ~static_cast<uint64_t>(0);
+
+/// the first len bits set
+static Key
+MaskOf(unsigned int len)
+{
+    Key mask;
+    mask.hi = len >= 64 ? AllOnes : (len ? AllOnes << (64 - len) : 0);
+    mask.lo = len >= 128 ? AllOnes : (len > 64 ? AllOnes << (128 - len) : 0);
+    return mask;
+}
+
+/// key with all but the first len bits cleared
+static Key
+Truncated(const Key &key, unsigned int len)
+{
+    const Key mask = MaskOf(len);
+    Key result;
+    result.hi = key.hi & mask.hi;
+    result.lo = key.lo & mask.lo;
+    return result;
+}
+
+/// whether the first len bits of a and b are equal
+static inline bool
+SamePrefix(const Key &a, const Key &b, unsigned int len)
+{
+    const Key mask = MaskOf(len);
+    return !((a.hi ^ b.hi) & mask.hi) && !((a.lo ^ b.lo) & mask.lo);
+}
+
+/// the bit at pos, counting from the most significant one
+static inline int
+BitAt(const Key &key, unsigned int pos)
+{
+    return pos < 64 ? (key.hi >> (63 - pos)) & 1 : (key.lo >> (127 - pos)) & 1;
+}
+
+/// the number of leading zero bits in a non-zero word
+static unsigned int
+LeadingZeros(uint64_t word)
+{
+    unsigned int n = 0;
+    for (unsigned int shift = 32; shift; shift >>= 1) {
+        if (!(word >> (64 - shift))) {
+            n += shift;
+            word <<= shift;
+        }
+    }
+    return n;
+}
+
+/// the number of trailing zero bits in a non-zero word
+static unsigned int
+TrailingZeros(uint64_t word)
+{
+    unsigned int n = 0;
+    for (unsigned int shift = 32; shift; shift >>= 1) {
+        if (!(word << (64 - shift))) {
+            n += shift;
+            word >>= shift;
+        }
+    }
+    return n;
+}
+
+/// the length of the longest common prefix of a and b
+static unsigned int
+CommonPrefixLength(const Key &a, const Key &b)
+{
+    if (const uint64_t diff = a.hi ^ b.hi)
+        return LeadingZeros(diff);
+    if (const uint64_t diff = a.lo ^ b.lo)
+        return 64 + LeadingZeros(diff);
+    return 128;
+}
+
+static inline bool
+Less(const Key &a, const Key &b)
+{
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+
+/// a - b, modulo 2^128
+static Key
+Minus(const Key &a, const Key &b)
+{
+    Key result;
+    result.lo = a.lo - b.lo;
+    result.hi = a.hi - b.hi - (a.lo < b.lo);
+    return result;
+}
+
+/// adds 2^bits to key, modulo 2^128
+static void
+AddPowerOfTwo(Key &key, unsigned int bits)
+{
+    if (bits >= 128)
+        key = Key();
+    else if (bits >= 64)
+        key.hi += static_cast<uint64_t>(1) << (bits - 64);
+    else {
+        const uint64_t lo = key.lo + (static_cast<uint64_t>(1) << bits);
+        key.hi += (lo < key.lo);
+        key.lo = lo;
+    }
+}
+
+Acl::IpTree::Key::Key(const struct in6_addr &addr): hi(0), lo(0)
+{
+    for (int i = 0; i < 8; ++i)
+        hi = (hi << 8) | addr.s6_addr[i];
+    for (int i = 8; i < 16; ++i)
+        lo = (lo << 8) | addr.s6_addr[i];
+}
+
+Acl::IpTree::Node::Node(const Key &aKey, uint8_t aLen, bool isTerminal):
+    key(aKey), len(aLen), terminal(isTerminal)
+{
+    child[0] = child[1] = 0;
+}
+
+Acl::IpTree::IpTree(): prefixes_(0)
+{
+    nodes_.push_back(Node(Key(), 0, false));
+}
+
+uint32_t
+Acl::IpTree::addNode(const Key &key, unsigned int len, bool terminal)
+{
+    const uint32_t id = nodes_.size();
+    nodes_.push_back(Node(Truncated(key, len), len, terminal));
+    return id;
+}
+
+bool
+Acl::IpTree::add(const struct in6_addr &addr, unsigned int prefixLen)
+{
+    return add(Key(addr), prefixLen > 128 ? 128 : prefixLen);
+}
+
+bool
+Acl::IpTree::add(const Key &key, unsigned int prefixLen)
+{
+    // invariant: the node prefix is a prefix of the key and is not longer
+    uint32_t id = 0;
+    for (;;) {
+        if (nodes_[id].terminal)
+            return false; // an earlier prefix covers this one
+
+        if (nodes_[id].len == prefixLen) {
+            // the new prefix covers the whole subtree, which lookups now skip
+            std::vector<uint32_t> covered(1, id);
+            while (!covered.empty()) {
+                const Node &node = nodes_[covered.back()];
+                covered.pop_back();
+                if (node.terminal)
+                    --prefixes_;
+                for (int i = 0; i < 2; ++i) {
+                    if (node.child[i])
+                        covered.push_back(node.child[i]);
+                }
+            }
+            Node &node = nodes_[id];
+            node.child[0] = node.child[1] = 0;
+            node.terminal = true;
+            ++prefixes_;
+            return true;
+        }
+
+        const int bit = BitAt(key, nodes_[id].len);
+        const uint32_t childId = nodes_[id].child[bit];
+        if (!childId) {
+            const uint32_t leaf = addNode(key, prefixLen, true);
+            nodes_[id].child[bit] = leaf;
+            ++prefixes_;
+            return true;
+        }
+
+        const Node &child = nodes_[childId];
+        unsigned int common = CommonPrefixLength(key, child.key);
+        if (common >= child.len && child.len <= prefixLen) {
+            id = childId;
+            continue;
+        }
+
+        // the new prefix parts ways with the child prefix or ends inside it
+        if (common > prefixLen)
+            common = prefixLen;
+        const int childBit = BitAt(child.key, common);
+        const uint32_t fork = addNode(key, common, false);
+        nodes_[fork].child[childBit] = childId;
+        nodes_[id].child[bit] = fork;
+        if (common == prefixLen) {
+            id = fork; // covers the child subtree; see above
+            continue;
+        }
+        const uint32_t leaf = addNode(key, prefixLen, true);
+        nodes_[fork].child[!childBit] = leaf;
+        ++prefixes_;
+        return true;
+    }
+}
+
+bool
+Acl::IpTree::addRange(const struct in6_addr &first, const struct in6_addr &last)
+{
+    Key from(first);
+    const Key to(last);
+    if (Less(to, from))
+        return false;
+
+    bool added = false;
+    for (;;) {
+        // the largest aligned block that starts at from and does not pass to
+        unsigned int bits = from.lo ? TrailingZeros(from.lo) :
+                            (from.hi ? 64 + TrailingZeros(from.hi) : 128);
+        const Key span = Minus(to, from); // block size minus one
+        if (span.hi != AllOnes || span.lo != AllOnes) {
+            Key size = span;
+            AddPowerOfTwo(size, 0);
+            const unsigned int fits = 127 - CommonPrefixLength(size, Key());
+            if (fits < bits)
+                bits = fits;
+        }
+
+        added = add(from, 128 - bits) || added;
+
+        AddPowerOfTwo(from, bits);
+        if ((!from.hi && !from.lo) || Less(to, from))
+            break; // wrapped around or done
+    }
+    return added;
+}
+
+bool
+Acl::IpTree::match(const struct in6_addr &addr) const
+{
+    const Key key(addr);
+    const Node *node = &nodes_[0];
+    for (;;) {
+        if (node->terminal)
+            return true;
+        if (node->len >= 128)
+            return false;
+        const uint32_t childId = node->child[BitAt(key, node->len)];
+        if (!childId)
+            return false;
+        node = &nodes_[childId];
+        if (!SamePrefix(key, node->key, node->len))
+            return false;
+    }
+}
+
+size_t
+Acl::IpTree::memoryUsed() const
+{
+    return sizeof(*this) + nodes_.capacity() * sizeof(Node);
+}
+
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_ACL_IPTREE_H
+#define SQUID_ACL_IPTREE_H
+
+#include <vector>
+#if HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+
+namespace Acl
+{
+
+/**
+ * A set of IPv6 address prefixes (IPv4 addresses are IPv4-mapped) stored as
+ * a path-compressed binary trie (a Patricia tree) in one node array.
+ * The set is built at configuration time. Lookups do not modify the
+ * tree, so concurrent readers need no locking.
+ */
+class IpTree
+{
+public:
+    IpTree();
+
+    /// adds all addresses that share the first prefixLen bits with addr
+    /// \returns false if earlier prefixes already covered all of them
+    bool add(const struct in6_addr &addr, unsigned int prefixLen);
+
+    /// adds all addresses from first through last, as a few prefixes
+    /// \returns false if earlier prefixes already covered all of them
+    bool addRange(const struct in6_addr &first, const struct in6_addr &last);
+
+    /// whether one of the added prefixes covers the address
+    bool match(const struct in6_addr &addr) const;
+
+    bool empty() const { return prefixes_ == 0; }
+
+    size_t prefixes() const { return prefixes_; }
+    size_t nodes() const { return nodes_.size(); }
+    size_t memoryUsed() const;
+
+    /// a 128-bit address in host order
+    class Key
+    {
+    public:
+        Key(): hi(0), lo(0) {}
+        explicit Key(const struct in6_addr &addr);
+
+        uint64_t hi; ///< the most significant half
+        uint64_t lo;
+    };
+
+private:
+    /// a trie node: a prefix and the subtrees of longer prefixes under it
+    class Node
+    {
+    public:
+        Node(const Key &aKey, uint8_t aLen, bool isTerminal);
+
+        Key key; ///< the prefix bits; the remaining bits are zero
+        uint32_t child[2]; ///< nodes_ ids of subtrees by the next bit; 0 if none
+        uint8_t len; ///< prefix length (0-128)
+        bool terminal; ///< whether an added prefix ends here
+    };
+
+    bool add(const Key &key, unsigned int prefixLen);
+    uint32_t addNode(const Key &key, unsigned int len, bool terminal);
+
+    std::vector<Node> nodes_; ///< nodes_[0] is the root (the empty prefix)
+    size_t prefixes_; ///< the number of terminal nodes
+};
+
+} // namespace Acl
+
+#endif /* SQUID_ACL_IPTREE_H */
+
@@ -21,6 +21,7 @@ public:
 
     virtual char const *typeString() const;
     virtual int match(ACLChecklist *checklist);
+    virtual Acl::ResultScope resultScope() const {return Acl::rsConnection;}
     virtual ACL *clone()const;
 
 private:
@@ -18,6 +18,7 @@ class ACLLocalPortStrategy : public ACLStrategy<int>
 
 public:
     virtual int match (ACLData<MatchType> * &, ACLFilledChecklist *, ACLFlags &);
+    virtual Acl::ResultScope resultScope() const {return Acl::rsConnection;}
     static ACLLocalPortStrategy *Instance();
     /**
      * Not implemented to prevent copies of the instance.
@@ -16,6 +16,7 @@ class ACLMyPortNameStrategy : public ACLStrategy<const char *>
 
 public:
     virtual int match (ACLData<MatchType> * &, ACLFilledChecklist *, ACLFlags &);
+    virtual Acl::ResultScope resultScope() const {return Acl::rsConnection;}
     static ACLMyPortNameStrategy *Instance();
     /* Not implemented to prevent copies of the instance. */
     /* Not private to prevent brain dead g+++ warnings about
@@ -19,6 +19,7 @@ class ACLProtocolStrategy : public ACLStrategy<AnyP::ProtocolType>
 public:
     virtual int match (ACLData<MatchType> * &, ACLFilledChecklist *, ACLFlags &);
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     static ACLProtocolStrategy *Instance();
     /* Not implemented to prevent copies of the instance. */
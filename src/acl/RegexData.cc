@@ -22,6 +22,7 @@
 #include "Debug.h"
 #include "Mem.h"
 #include "RegexList.h"
+#include "SquidConfig.h"
 #include "wordlist.h"
 
 static void
@@ -50,6 +51,15 @@ ACLRegexData::match(char const *word)
 
     debugs(28, 3, "aclRegexData::match: checking '" << word << "'");
 
+    if (patterns.compiled()) {
+        const int i = patterns.match(word);
+        if (i < 0)
+            return 0;
+
+        debugs(28, 2, "aclRegexData::match: match '" << patterns.pattern(i) << "' found in '" << word << "'");
+        return 1;
+    }
+
     RegexList *first, *prev;
 
     first = data;
@@ -85,10 +95,9 @@ SBufList
 ACLRegexData::dump() const
 {
     SBufList sl;
-    RegexList *temp = data;
     int flags = REG_EXTENDED | REG_NOSUB;
 
-    while (temp != NULL) {
+    for (RegexList *temp = data; temp; temp = temp->next) {
         if (temp->flags != flags) {
             if ((temp->flags&REG_ICASE) != 0) {
                 sl.push_back(SBuf("-i"));
@@ -99,7 +108,21 @@ ACLRegexData::dump() const
         }
 
         sl.push_back(SBuf(temp->pattern));
-        temp = temp->next;
+    }
+    if (data)
+        return sl;
+
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        if (patterns.flags(i) != flags) {
+            if ((patterns.flags(i)&REG_ICASE) != 0) {
+                sl.push_back(SBuf("-i"));
+            } else {
+                sl.push_back(SBuf("+i"));
+            }
+            flags = patterns.flags(i);
+        }
+
+        sl.push_back(SBuf(patterns.pattern(i)));
     }
 
     return sl;
@@ -295,7 +318,7 @@ compileUnoptimisedREs(RegexList **curlist, wordlist * wl)
 }
 
 static void
-aclParseRegexList(RegexList **curlist)
+aclParseRegexList(RegexList **curlist, RegexSet &patterns)
 {
     char *t;
     wordlist *wl = NULL;
@@ -318,19 +341,45 @@ aclParseRegexList(RegexList **curlist)
         compileUnoptimisedREs(curlist, wl);
     }
 
+    // remember the individual expressions for the prefilter and dump()
+    int flags = REG_EXTENDED | REG_NOSUB;
+    for (wordlist *w = wl; w; w = w->next) {
+        if (strcmp(w->key, "-i") == 0)
+            flags |= REG_ICASE;
+        else if (strcmp(w->key, "+i") == 0)
+            flags &= ~REG_ICASE;
+        else
+            patterns.add(w->key, flags);
+    }
+
     wordlistDestroy(&wl);
 }
 
 void
 ACLRegexData::parse()
 {
-    aclParseRegexList(&data);
+    aclParseRegexList(&data, patterns);
+}
+
+void
+ACLRegexData::prepareForUse()
+{
+    // regex_prefilter may be set after the acl lines, so we wait until the
+    // whole configuration is parsed to keep only the representation we use
+    if (Config.onoff.regex_prefilter) {
+        if (!patterns.compiled())
+            patterns.compile();
+        aclDestroyRegexList(data);
+        data = NULL;
+    } else {
+        patterns.clear();
+    }
 }
 
 bool
 ACLRegexData::empty() const
 {
-    return data == NULL;
+    return data == NULL && patterns.size() == 0;
 }
 
 ACLData<char const *> *
@@ -10,6 +10,7 @@
 #define SQUID_ACLREGEXDATA_H
 
 #include "acl/Data.h"
+#include "base/RegexSet.h"
 #include "MemPool.h"
 
 class RegexList;
@@ -20,15 +21,18 @@ class ACLRegexData : public ACLData<char const *>
 public:
     MEMPROXY_CLASS(ACLRegexData);
 
+    ACLRegexData(): data(NULL) {}
     virtual ~ACLRegexData();
     virtual bool match(char const *user);
     virtual SBufList dump() const;
     virtual void parse();
+    virtual void prepareForUse();
     virtual bool empty() const;
     virtual ACLData<char const *> *clone() const;
 
 private:
-    RegexList *data;
+    RegexList *data; ///< combined expressions; freed if patterns are used
+    RegexSet patterns; ///< individual expressions; cleared unless regex_prefilter
 };
 
 MEMPROXY_CLASS_INLINE(ACLRegexData);
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 28    Access Control */
+
+#include "squid.h"
+#include "acl/Acl.h"
+#include "acl/ResultCache.h"
+#include "base/RunnersRegistry.h"
+#include "Debug.h"
+#include "mgr/Registration.h"
+#include "Store.h"
+
+/// the current configuration; cached results of earlier ones are stale
+static unsigned int TheEpoch = 0;
+
+/// lookup counters of all caches, by Acl::ResultScope
+static struct {
+    uint64_t hits;
+    uint64_t misses;
+} TheStats[Acl::rsConnection + 1];
+
+bool
+Acl::ResultCache::find(const ACL *acl, const ResultScope scope, int &result)
+{
+    if (epoch_ != TheEpoch) {
+        clear();
+        epoch_ = TheEpoch;
+    }
+
+    for (std::vector<Result>::const_iterator i = results_.begin(); i != results_.end(); ++i) {
+        if (i->first == acl) {
+            debugs(28, 4, "hit for '" << acl->name << "': " << i->second);
+            ++TheStats[scope].hits;
+            result = i->second;
+            return true;
+        }
+    }
+
+    ++TheStats[scope].misses;
+    return false;
+}
+
+void
+Acl::ResultCache::add(const ACL *acl, const int result)
+{
+    if (epoch_ != TheEpoch) {
+        clear();
+        epoch_ = TheEpoch;
+    }
+
+    debugs(28, 4, "remembering '" << acl->name << "': " << result);
+    results_.push_back(Result(acl, result));
+}
+
+void
+Acl::ResultCache::Invalidate()
+{
+    ++TheEpoch;
+}
+
+void
+Acl::ResultCache::Stats(StoreEntry *e)
+{
+    static const char *Scopes[] = { "checklist", "transaction", "connection" };
+
+    storeAppendPrintf(e, "%-12s %14s %14s %8s\n", "Scope", "Hits", "Misses", "Hit%");
+    for (int scope = rsTransaction; scope <= rsConnection; ++scope) {
+        const uint64_t lookups = TheStats[scope].hits + TheStats[scope].misses;
+        storeAppendPrintf(e, "%-12s %14" PRIu64 " %14" PRIu64 " %7.2f%%\n", Scopes[scope],
+                          TheStats[scope].hits, TheStats[scope].misses,
+                          lookups ? 100.0 * TheStats[scope].hits / lookups : 0.0);
+    }
+}
+
+/// invalidates cached ACL results on reconfiguration and registers their report
+class AclResultCacheRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    virtual void useConfig();
+    virtual void syncConfig();
+};
+RunnerRegistrationEntry(AclResultCacheRr);
+
+void
+AclResultCacheRr::useConfig()
+{
+    Mgr::RegisterAction("acl_results", "ACL Result Cache Statistics", &Acl::ResultCache::Stats, 0, 1);
+}
+
+void
+AclResultCacheRr::syncConfig()
+{
+    // the ACLs that cached results point to are gone
+    Acl::ResultCache::Invalidate();
+}
+
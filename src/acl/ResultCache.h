@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_ACL_RESULTCACHE_H
+#define SQUID_ACL_RESULTCACHE_H
+
+#include <utility>
+#include <vector>
+
+class ACL;
+class StoreEntry;
+
+namespace Acl
+{
+
+/// how long an ACL::match() result stays valid
+typedef enum {
+    rsCheck, ///< the result may differ for the next checklist
+    rsTransaction, ///< the result depends on the request URL and method only
+    rsConnection ///< the result depends on the client connection only
+} ResultScope;
+
+/**
+ * Match results of side-effect-free ACLs, remembered for the remaining
+ * access checks of one transaction (HttpRequest) or client connection
+ * (ConnStateData). Entries are keyed by ACL address; reconfiguration
+ * invalidates all of them.
+ */
+class ResultCache
+{
+public:
+    ResultCache(): epoch_(0) {}
+
+    /// sets the result and returns true if the ACL result is known
+    bool find(const ACL *acl, const ResultScope scope, int &result);
+
+    /// remembers the ACL result
+    void add(const ACL *acl, const int result);
+
+    /// forgets all results, e.g., after their input has changed
+    void clear() { results_.clear(); }
+
+    /// forgets results of all caches (of the previous configuration)
+    static void Invalidate();
+
+    /// reports hit ratios of all caches
+    static void Stats(StoreEntry *e);
+
+private:
+    typedef std::pair<const ACL *, int> Result;
+
+    std::vector<Result> results_;
+    unsigned int epoch_; ///< the configuration the results belong to (see Invalidate())
+};
+
+} // namespace Acl
+
+#endif /* SQUID_ACL_RESULTCACHE_H */
+
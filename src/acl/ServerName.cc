@@ -23,16 +23,6 @@
 #include "ssl/support.h"
 #include "URL.h"
 
-// Compare function for tree search algorithms
-static int
-aclHostDomainCompare( char *const &a, char * const &b)
-{
-    const char *h = static_cast<const char *>(a);
-    const char *d = static_cast<const char *>(b);
-    debugs(28, 7, "Match:" << h << " <>  " << d);
-    return matchDomainName(h, d, mdnHonorWildcards);
-}
-
 bool
 ACLServerNameData::match(const char *host)
 {
@@ -41,19 +31,18 @@ ACLServerNameData::match(const char *host)
 
     debugs(28, 3, "checking '" << host << "'");
 
-    char *h = const_cast<char *>(host);
-    char const * const * result = domains->find(h, aclHostDomainCompare);
+    // certificate names may use "*.example.com" wildcards
+    const bool result = domains->match(host, true);
 
     debugs(28, 3, "'" << host << "' " << (result ? "found" : "NOT found"));
 
-    return (result != NULL);
-
+    return result;
 }
 
 ACLData<char const *> *
 ACLServerNameData::clone() const
 {
-    /* Splay trees don't clone yet. */
+    /* Domain indexes don't clone yet. */
     assert (!domains);
     return new ACLServerNameData;
 }
@@ -32,6 +32,7 @@ public:
     virtual bool requiresRequest() const {return matcher->requiresRequest();}
 
     virtual bool requiresReply() const {return matcher->requiresReply();}
+    virtual Acl::ResultScope resultScope() const {return matcher->resultScope();}
 
     virtual void prepareForUse() { data->prepareForUse();}
 
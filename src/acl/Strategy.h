@@ -25,6 +25,7 @@ public:
     virtual bool requiresRequest() const {return false;}
 
     virtual bool requiresReply() const {return false;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsCheck;}
 
     virtual bool valid() const {return true;}
 
@@ -18,6 +18,7 @@ class ACLUrlStrategy : public ACLStrategy<char const *>
 public:
     virtual int match (ACLData<char const *> * &, ACLFilledChecklist *, ACLFlags &);
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     static ACLUrlStrategy *Instance();
     /* Not implemented to prevent copies of the instance. */
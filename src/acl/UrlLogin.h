@@ -20,6 +20,7 @@ class ACLUrlLoginStrategy : public ACLStrategy<char const *>
 public:
     virtual int match (ACLData<char const *> * &, ACLFilledChecklist *, ACLFlags &);
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     static ACLUrlLoginStrategy *Instance();
     /* Not implemented to prevent copies of the instance. */
@@ -19,6 +19,7 @@ class ACLUrlPathStrategy : public ACLStrategy<char const *>
 public:
     virtual int match (ACLData<char const *> * &, ACLFilledChecklist *, ACLFlags &);
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     static ACLUrlPathStrategy *Instance();
     /* Not implemented to prevent copies of the instance. */
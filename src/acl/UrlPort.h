@@ -17,6 +17,7 @@ class ACLUrlPortStrategy : public ACLStrategy<int>
 public:
     virtual int match (ACLData<MatchType> * &, ACLFilledChecklist *, ACLFlags &);
     virtual bool requiresRequest() const {return true;}
+    virtual Acl::ResultScope resultScope() const {return Acl::rsTransaction;}
 
     static ACLUrlPortStrategy *Instance();
     /* Not implemented to prevent copies of the instance. */
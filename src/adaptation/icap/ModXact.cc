@@ -1554,7 +1554,7 @@ void Adaptation::Icap::ModXact::encapsulateHead(MemBuf &icapBuf, const char *sec
     HttpHeaderPos pos = HttpHeaderInitPos;
     HttpHeaderEntry* p_head_entry = NULL;
     while (NULL != (p_head_entry = head->header.getEntry(&pos)) )
-        headClone->header.addEntry(p_head_entry->clone());
+        headClone->header.addEntry(p_head_entry->share());
 
     // end cloning
 
@@ -47,6 +47,15 @@ public:
     typedef RefCount <AsyncCall> Pointer;
     friend class AsyncCallQueue;
 
+    /// AsyncCallQueue lanes, each with its own per-round dispatch budget
+    typedef enum {
+        laneIo = 0, ///< I/O completions and calls without a specific lane
+        laneAccept, ///< newly accepted connections
+        laneTimer, ///< due events
+        laneBackground, ///< due heavy events (e.g., store rebuild steps)
+        laneEnd
+    } Lane;
+
     AsyncCall(int aDebugSection, int aDebugLevel, const char *aName);
     virtual ~AsyncCall();
 
@@ -78,12 +87,17 @@ public:
     const int debugLevel;
     const InstanceId<AsyncCall> id;
 
+    /// the AsyncCallQueue lane to schedule this call in
+    Lane lane;
+
 protected:
     virtual bool canFire();
 
     virtual void fire() = 0;
 
     AsyncCall::Pointer theNext; // used exclusively by AsyncCallQueue
+    double scheduledAt; ///< when AsyncCallQueue got this call, for wait stats
+    uint64_t scheduledNo; ///< AsyncCallQueue schedule order across all lanes
 
 private:
     const char *isCanceled; // set to the cancelation reason by cancel()
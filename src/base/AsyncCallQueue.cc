@@ -12,10 +12,35 @@
 #include "base/AsyncCall.h"
 #include "base/AsyncCallQueue.h"
 #include "Debug.h"
+#include "SquidTime.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
 
 AsyncCallQueue *AsyncCallQueue::TheInstance = 0;
 
-AsyncCallQueue::AsyncCallQueue(): theHead(NULL), theTail(NULL)
+/// the maximum number of calls fired from each lane per fire() round
+static const size_t LaneBudgets[AsyncCall::laneEnd] = {
+    256, // laneIo
+    64, // laneAccept
+    64, // laneTimer
+    16 // laneBackground
+};
+
+static const char *LaneNames[AsyncCall::laneEnd] = {
+    "io",
+    "accept",
+    "timer",
+    "background"
+};
+
+AsyncCallQueue::Lane::Lane(): head(NULL), tail(NULL),
+    depth(0), maxDepth(0), scheduled(0), fired(0), waitTime(0), maxWaitTime(0)
+{
+}
+
+AsyncCallQueue::AsyncCallQueue(): scheduledCalls(0)
 {
 }
 
@@ -23,40 +48,109 @@ void AsyncCallQueue::schedule(AsyncCall::Pointer &call)
 {
     assert(call != NULL);
     assert(!call->theNext);
-    if (theHead != NULL) { // append
-        assert(!theTail->theNext);
-        theTail->theNext = call;
-        theTail = call;
+    assert(call->lane < AsyncCall::laneEnd);
+    Lane &lane = lanes[call->lane];
+    if (lane.head != NULL) { // append
+        assert(!lane.tail->theNext);
+        lane.tail->theNext = call;
+        lane.tail = call;
     } else { // create queue from cratch
-        theHead = theTail = call;
+        lane.head = lane.tail = call;
     }
+
+    call->scheduledAt = current_dtime;
+    call->scheduledNo = ++scheduledCalls;
+    ++lane.scheduled;
+    if (++lane.depth > lane.maxDepth)
+        lane.maxDepth = lane.depth;
 }
 
-// Fire all scheduled calls; returns true if at least one call was fired.
+// Fire scheduled calls in their schedule order, up to the lane budget of
+// calls from each lane; returns true if at least one call was fired.
 // The calls may be added while the current call is in progress.
 bool
 AsyncCallQueue::fire()
 {
-    const bool made = theHead != NULL;
-    while (theHead != NULL)
-        fireNext();
-    return made;
+    size_t budgets[AsyncCall::laneEnd];
+    std::copy(LaneBudgets, LaneBudgets + AsyncCall::laneEnd, budgets);
+
+    bool made = false;
+    while (true) {
+        // the lane with the earliest scheduled call and some budget left
+        int next = -1;
+        for (int i = 0; i < AsyncCall::laneEnd; ++i) {
+            if (budgets[i] > 0 && lanes[i].head != NULL &&
+                    (next < 0 || lanes[i].head->scheduledNo < lanes[next].head->scheduledNo))
+                next = i;
+        }
+        if (next < 0)
+            return made;
+
+        --budgets[next];
+        fireNext(lanes[next]);
+        made = true;
+    }
+}
+
+bool
+AsyncCallQueue::empty() const
+{
+    for (int i = 0; i < AsyncCall::laneEnd; ++i) {
+        if (lanes[i].head != NULL)
+            return false;
+    }
+    return true;
 }
 
 void
-AsyncCallQueue::fireNext()
+AsyncCallQueue::fireNext(Lane &lane)
 {
-    AsyncCall::Pointer call = theHead;
-    theHead = call->theNext;
+    AsyncCall::Pointer call = lane.head;
+    lane.head = call->theNext;
     call->theNext = NULL;
-    if (theTail == call)
-        theTail = NULL;
+    if (lane.tail == call)
+        lane.tail = NULL;
+
+    --lane.depth;
+    ++lane.fired;
+    const double waited = current_dtime - call->scheduledAt;
+    if (waited > 0) {
+        lane.waitTime += waited;
+        if (waited > lane.maxWaitTime)
+            lane.maxWaitTime = waited;
+    }
 
     debugs(call->debugSection, call->debugLevel, "entering " << *call);
     call->make();
     debugs(call->debugSection, call->debugLevel, "leaving " << *call);
 }
 
+void
+AsyncCallQueue::dump(std::ostream &os) const
+{
+    os << std::left << std::setw(12) << "Lane" << std::right <<
+       std::setw(8) << "Budget" <<
+       std::setw(10) << "Queued" <<
+       std::setw(12) << "Max Queued" <<
+       std::setw(14) << "Scheduled" <<
+       std::setw(14) << "Fired" <<
+       std::setw(16) << "Mean Wait (ms)" <<
+       std::setw(15) << "Max Wait (ms)" << "\n";
+
+    for (int i = 0; i < AsyncCall::laneEnd; ++i) {
+        const Lane &lane = lanes[i];
+        const double meanWait = lane.fired ? lane.waitTime / lane.fired : 0.0;
+        os << std::left << std::setw(12) << LaneNames[i] << std::right <<
+           std::setw(8) << LaneBudgets[i] <<
+           std::setw(10) << lane.depth <<
+           std::setw(12) << lane.maxDepth <<
+           std::setw(14) << lane.scheduled <<
+           std::setw(14) << lane.fired <<
+           std::setw(16) << std::fixed << std::setprecision(3) << (1000 * meanWait) <<
+           std::setw(15) << (1000 * lane.maxWaitTime) << "\n";
+    }
+}
+
 AsyncCallQueue &
 AsyncCallQueue::Instance()
 {
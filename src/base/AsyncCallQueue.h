@@ -11,10 +11,20 @@
 
 #include "base/AsyncCall.h"
 
+#include <iosfwd>
+
 //class AsyncCall;
 
-// The queue of asynchronous calls. All calls are fired during a single main
-// loop iteration until the queue is exhausted
+// The queue of asynchronous calls. Calls wait in per-priority lanes (see
+// AsyncCall::Lane). Each fire() round dispatches calls in the order they were
+// scheduled, but at most a lane budget of calls from every lane. The main
+// loop fires one round per iteration and checks for I/O in between, so a
+// burst of calls in one lane does not delay other lanes or new I/O for long.
+// A call deferred by its lane budget may fire after calls that other lanes
+// scheduled later. Calls within a lane keep their order. The callers that
+// pick a non-default lane tolerate deferral: a deferred EventScheduler call
+// looks like an event that became due later, and a deferred TcpAcceptor call
+// carries an already accepted connection that nothing else refers to yet.
 class AsyncCallQueue
 {
 public:
@@ -24,16 +34,40 @@ public:
     // make this async call when we get a chance
     void schedule(AsyncCall::Pointer &call);
 
-    // fire all scheduled calls; returns true if at least one was fired
+    // fire a bounded number of scheduled calls from each lane;
+    // returns true if at least one was fired
     bool fire();
 
+    /// whether no calls are waiting to be fired
+    bool empty() const;
+
+    /// reports per-lane queue depth and wait time statistics
+    void dump(std::ostream &os) const;
+
 private:
+    /// calls waiting in one lane, with lane statistics
+    class Lane
+    {
+    public:
+        Lane();
+
+        AsyncCall::Pointer head;
+        AsyncCall::Pointer tail;
+
+        size_t depth; ///< number of queued calls
+        size_t maxDepth; ///< the largest depth seen
+        uint64_t scheduled; ///< number of calls ever queued
+        uint64_t fired; ///< number of calls ever dequeued and made
+        double waitTime; ///< total seconds fired calls spent queued
+        double maxWaitTime; ///< the longest time a fired call spent queued
+    };
+
     AsyncCallQueue();
 
-    void fireNext();
+    void fireNext(Lane &lane);
 
-    AsyncCall::Pointer theHead;
-    AsyncCall::Pointer theTail;
+    Lane lanes[AsyncCall::laneEnd];
+    uint64_t scheduledCalls; ///< number of calls ever queued in all lanes
 
     static AsyncCallQueue *TheInstance;
 };
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 21    Regular Expression Sets */
+
+#include "squid.h"
+#include "base/RegexSet.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <queue>
+
+/// shorter literals occur in too many subjects to be worth filtering on
+static const size_t MinLiteralLength = 3;
+
+/// ASCII case folding applied to both literals and subjects
+static inline unsigned char
+Fold(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+/// orders trie edges by their byte
+static bool
+EdgeByteLess(const std::pair<unsigned char, int> &edge, unsigned char c)
+{
+    return edge.first < c;
+}
+
+RegexSet::RegexSet(): compiled_(false)
+{
+}
+
+RegexSet::~RegexSet()
+{
+    uncompile();
+}
+
+void
+RegexSet::clear()
+{
+    uncompile();
+    patterns_.clear();
+}
+
+void
+RegexSet::uncompile()
+{
+    for (size_t i = 0; i < regexes_.size(); ++i) {
+        if (valid_[i])
+            regfree(&regexes_[i]);
+    }
+    regexes_.clear();
+    valid_.clear();
+    nodes_.clear();
+    unfiltered_.clear();
+    compiled_ = false;
+}
+
+void
+RegexSet::add(const char *pattern, int flags)
+{
+    uncompile();
+    patterns_.push_back(std::make_pair(std::string(pattern), flags));
+}
+
+void
+RegexSet::compile()
+{
+    uncompile();
+
+    regexes_.resize(patterns_.size());
+    valid_.resize(patterns_.size(), false);
+    nodes_.push_back(Node());
+
+    for (size_t i = 0; i < patterns_.size(); ++i) {
+        const char *pat = patterns_[i].first.c_str();
+        const int flags = patterns_[i].second;
+
+        const int errcode = regcomp(&regexes_[i], pat, flags);
+        if (errcode != 0) {
+            char errbuf[256];
+            regerror(errcode, &regexes_[i], errbuf, sizeof errbuf);
+            debugs(21, DBG_CRITICAL, "ERROR: invalid regular expression: '" << pat << "': " << errbuf);
+            continue;
+        }
+        valid_[i] = true;
+
+        const std::string literal = RequiredLiteral(pat);
+        bool usable = literal.size() >= MinLiteralLength;
+        // REG_ICASE folding of non-ASCII bytes depends on the locale
+        for (size_t n = 0; usable && (flags & REG_ICASE) && n < literal.size(); ++n)
+            usable = !(literal[n] & 0x80);
+
+        if (usable) {
+            debugs(21, 5, "filtering '" << pat << "' on '" << literal << "'");
+            addLiteral(literal, i);
+        } else {
+            debugs(21, 5, "no literal to filter '" << pat << "' on");
+            unfiltered_.push_back(i);
+        }
+    }
+
+    linkFailures();
+    compiled_ = true;
+
+    debugs(21, 2, patterns_.size() << " patterns, " << unfiltered_.size() <<
+           " unfiltered, " << nodes_.size() << " automaton states");
+}
+
+std::string
+RegexSet::RequiredLiteral(const char *pattern)
+{
+    std::string best;
+    std::string run;
+    int depth = 0; // we skip parenthesized groups; they may be optional
+
+    for (const char *p = pattern; *p; ++p) {
+        bool literal = false;
+        char c = *p;
+
+        switch (c) {
+        case '\\':
+            if (!p[1])
+                break;
+            c = *++p;
+            // escaped letters, digits, and a few symbols are GNU operators
+            literal = !xisalnum(c) && !strchr("<>`'", c);
+            break;
+
+        case '[': {
+            // skip the bracket expression, including a leading ']' or '^]'
+            ++p;
+            if (*p == '^')
+                ++p;
+            if (*p == ']')
+                ++p;
+            while (*p && *p != ']') {
+                if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+                    const char close[3] = { p[1], ']', '\0' };
+                    const char *end = strstr(p + 2, close);
+                    p = end ? end + 1 : p + strlen(p) - 1;
+                }
+                ++p;
+            }
+            if (!*p)
+                --p; // let the loop see the terminator
+            break;
+        }
+
+        case '(':
+            ++depth;
+            break;
+
+        case ')':
+            if (depth > 0)
+                --depth;
+            break;
+
+        case '|':
+            if (depth == 0)
+                return std::string(); // top-level alternatives share nothing
+            break;
+
+        case '*':
+        case '?':
+            // the preceding atom is optional
+            if (depth == 0 && !run.empty())
+                run.erase(run.size() - 1);
+            break;
+
+        case '{':
+            // the preceding atom may repeat zero times; skip the bound
+            if (depth == 0 && !run.empty())
+                run.erase(run.size() - 1);
+            while (p[1] && *p != '}')
+                ++p;
+            break;
+
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            break;
+
+        default:
+            literal = true;
+            break;
+        }
+
+        if (depth > 0)
+            continue;
+
+        if (literal) {
+            run += static_cast<char>(Fold(c));
+            continue;
+        }
+
+        if (run.size() > best.size())
+            best = run;
+        run.clear();
+    }
+
+    if (run.size() > best.size())
+        best = run;
+    return best;
+}
+
+void
+RegexSet::addLiteral(const std::string &literal, int patternIndex)
+{
+    int node = 0;
+    for (std::string::const_iterator i = literal.begin(); i != literal.end(); ++i) {
+        const unsigned char c = *i;
+        std::vector<Node::Edge> &edges = nodes_[node].edges;
+        std::vector<Node::Edge>::iterator e = std::lower_bound(edges.begin(), edges.end(), c, EdgeByteLess);
+        if (e != edges.end() && e->first == c) {
+            node = e->second;
+            continue;
+        }
+        const int next = nodes_.size();
+        edges.insert(e, Node::Edge(c, next));
+        nodes_.push_back(Node()); // invalidates edges
+        node = next;
+    }
+    nodes_[node].outputs.push_back(patternIndex);
+}
+
+/// computes failure and output links breadth-first
+void
+RegexSet::linkFailures()
+{
+    std::queue<int> todo;
+    const std::vector<Node::Edge> &rootEdges = nodes_[0].edges;
+    for (size_t i = 0; i < rootEdges.size(); ++i)
+        todo.push(rootEdges[i].second); // failure and outputLink stay 0
+
+    while (!todo.empty()) {
+        const int parent = todo.front();
+        todo.pop();
+
+        for (size_t i = 0; i < nodes_[parent].edges.size(); ++i) {
+            const unsigned char c = nodes_[parent].edges[i].first;
+            const int node = nodes_[parent].edges[i].second;
+
+            const int failure = step(nodes_[parent].failure, c);
+            nodes_[node].failure = failure;
+            nodes_[node].outputLink = nodes_[failure].outputs.empty() ?
+                                      nodes_[failure].outputLink : failure;
+            todo.push(node);
+        }
+    }
+}
+
+/// \returns the child of node reached by c or 0
+int
+RegexSet::child(int node, unsigned char c) const
+{
+    const std::vector<Node::Edge> &edges = nodes_[node].edges;
+    std::vector<Node::Edge>::const_iterator e = std::lower_bound(edges.begin(), edges.end(), c, EdgeByteLess);
+    return (e != edges.end() && e->first == c) ? e->second : 0;
+}
+
+/// the automaton transition from node on c
+int
+RegexSet::step(int node, unsigned char c) const
+{
+    for (;;) {
+        if (const int next = child(node, c))
+            return next;
+        if (!node)
+            return 0;
+        node = nodes_[node].failure;
+    }
+}
+
+int
+RegexSet::match(const char *subject) const
+{
+    assert(compiled_);
+
+    candidates_.clear();
+    if (nodes_.size() > 1) {
+        int node = 0;
+        for (const char *s = subject; *s; ++s) {
+            node = step(node, Fold(*s));
+            for (int out = nodes_[node].outputs.empty() ? nodes_[node].outputLink : node;
+                    out; out = nodes_[out].outputLink)
+                candidates_.insert(candidates_.end(), nodes_[out].outputs.begin(), nodes_[out].outputs.end());
+        }
+        std::sort(candidates_.begin(), candidates_.end());
+        candidates_.erase(std::unique(candidates_.begin(), candidates_.end()), candidates_.end());
+    }
+
+    // verify both ordered lists in pattern order
+    std::vector<int>::const_iterator c = candidates_.begin();
+    std::vector<int>::const_iterator u = unfiltered_.begin();
+    while (c != candidates_.end() || u != unfiltered_.end()) {
+        int i;
+        if (u == unfiltered_.end() || (c != candidates_.end() && *c < *u))
+            i = *c++;
+        else
+            i = *u++;
+
+        if (valid_[i] && regexec(&regexes_[i], subject, 0, 0, 0) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
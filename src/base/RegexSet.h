@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_BASE_REGEXSET_H
+#define SQUID_BASE_REGEXSET_H
+
+#include "compat/GnuRegex.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * An ordered list of regular expressions searched for the first match.
+ *
+ * Instead of calling regexec() for every pattern, match() makes a single
+ * Aho-Corasick pass over the subject to find the patterns whose required
+ * literal (a string every match must contain) occurs in the subject. Only
+ * those patterns and the patterns without a usable literal are verified
+ * with regexec(), in their original order, so the result is the same as
+ * trying each pattern in turn.
+ */
+class RegexSet
+{
+public:
+    RegexSet();
+    ~RegexSet();
+
+    /// appends a pattern to be compiled with the given regcomp(3) flags
+    void add(const char *pattern, int flags);
+
+    /// compiles the added patterns and builds the literal automaton;
+    /// patterns that fail to compile are reported and never match
+    void compile();
+
+    /// forgets all patterns
+    void clear();
+
+    /// whether compile() has been called since the last add()
+    bool compiled() const { return compiled_; }
+
+    /// \returns the index of the first pattern matching subject or -1
+    /// \pre compiled()
+    int match(const char *subject) const;
+
+    size_t size() const { return patterns_.size(); }
+    const char *pattern(size_t i) const { return patterns_[i].first.c_str(); }
+    int flags(size_t i) const { return patterns_[i].second; }
+
+    /// the number of patterns verified for every subject
+    size_t unfilteredCount() const { return unfiltered_.size(); }
+
+    /// the longest literal that every match of an extended regular
+    /// expression must contain, or an empty string if none can be found
+    static std::string RequiredLiteral(const char *pattern);
+
+private:
+    RegexSet(const RegexSet &); // not implemented
+    RegexSet &operator =(const RegexSet &); // not implemented
+
+    /// an Aho-Corasick trie node
+    class Node
+    {
+    public:
+        Node(): failure(0), outputLink(0) {}
+
+        typedef std::pair<unsigned char, int> Edge;
+        std::vector<Edge> edges; ///< child nodes, ordered by byte
+        int failure; ///< the node of the longest proper suffix
+        int outputLink; ///< the nearest failure-chain node with outputs, or 0
+        std::vector<int> outputs; ///< patterns whose literal ends here
+    };
+
+    void uncompile();
+    void addLiteral(const std::string &literal, int patternIndex);
+    void linkFailures();
+    int child(int node, unsigned char c) const;
+    int step(int node, unsigned char c) const;
+
+    std::vector< std::pair<std::string, int> > patterns_; ///< text and flags
+    std::vector<regex_t> regexes_; ///< compiled patterns_
+    std::vector<bool> valid_; ///< whether the regexes_ entry compiled
+
+    std::vector<Node> nodes_; ///< the trie; nodes_[0] is the root
+    std::vector<int> unfiltered_; ///< ordered patterns without literals
+
+    /// matching patterns found by the last scan; kept to avoid allocations
+    mutable std::vector<int> candidates_;
+
+    bool compiled_;
+};
+
+#endif /* SQUID_BASE_REGEXSET_H */
+
@@ -39,6 +39,7 @@
 #include "ip/QosConfig.h"
 #include "ip/tools.h"
 #include "ipc/Kids.h"
+#include "ipc/StoreMap.h"
 #include "log/Config.h"
 #include "log/CustomLog.h"
 #include "Mem.h"
@@ -3287,6 +3288,33 @@ dump_uri_whitespace(StoreEntry * entry, const char *name, int var)
     storeAppendPrintf(entry, "%s %s\n", name, s);
 }
 
+#define free_storemap_eviction free_int
+
+static void
+parse_storemap_eviction(int *var)
+{
+    char *token = ConfigParser::NextToken();
+
+    if (token == NULL)
+        self_destruct();
+
+    if (!strcmp(token, "clock"))
+        *var = Ipc::StoreMap::epClock;
+    else if (!strcmp(token, "fifo"))
+        *var = Ipc::StoreMap::epFifo;
+    else {
+        debugs(0, DBG_PARSE_NOTE(2), "ERROR: Invalid option '" << token << "': '" << cfg_directive << "' accepts 'clock' and 'fifo'.");
+        self_destruct();
+    }
+}
+
+static void
+dump_storemap_eviction(StoreEntry * entry, const char *name, int var)
+{
+    storeAppendPrintf(entry, "%s %s\n", name,
+                      Ipc::StoreMap::EvictionPolicyName(static_cast<Ipc::StoreMap::EvictionPolicy>(var)));
+}
+
 static void
 free_removalpolicy(RemovalPolicySettings ** settings)
 {
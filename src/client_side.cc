@@ -76,7 +76,9 @@
 #include "comm/Read.h"
 #include "comm/TcpAcceptor.h"
 #include "comm/Write.h"
+#include "compat/cmsg.h"
 #include "CommCalls.h"
+#include "disk.h"
 #include "errorpage.h"
 #include "fd.h"
 #include "fde.h"
@@ -109,6 +111,7 @@
 #include "StatCounters.h"
 #include "StatHist.h"
 #include "Store.h"
+#include "SwapDir.h"
 #include "TimeOrTag.h"
 #include "tools.h"
 #include "URL.h"
@@ -138,6 +141,9 @@
 #include <climits>
 #include <cmath>
 #include <limits>
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #if LINGERING_CLOSE
 #define comm_close comm_lingering_close
@@ -279,6 +285,10 @@ ClientSocketContext::~ClientSocketContext()
     if (connRegistered_)
         deRegisterWithConn();
 
+    // comm_close() finishes any Comm::SendFile() from it before we get here
+    if (bodyFileFd >= 0)
+        file_close(bodyFileFd);
+
     httpRequestFree(http);
 
     /* clean up connection links to us */
@@ -319,6 +329,7 @@ ClientSocketContext::ClientSocketContext(const Comm::ConnectionPointer &aConn, C
     reply(NULL),
     next(NULL),
     writtenToSocket(0),
+    bodyFileFd(-1),
     mayUseConnection_ (false),
     connRegistered_ (false)
 {
@@ -326,6 +337,7 @@ ClientSocketContext::ClientSocketContext(const Comm::ConnectionPointer &aConn, C
     memset (reqbuf, '\0', sizeof (reqbuf));
     flags.deferred = 0;
     flags.parsed_ok = 0;
+    flags.noBodyFile = 0;
     deferredparams.node = NULL;
     deferredparams.rep = NULL;
 }
@@ -1024,12 +1036,14 @@ ClientSocketContext::sendBody(HttpReply * rep, StoreIOBuffer bodyData)
         return;
     }
 
+    if (!multipartRangeRequest()) {
+        writeChunk(bodyData);
+        return;
+    }
+
     MemBuf mb;
     mb.init();
-    if (multipartRangeRequest())
-        packRange(bodyData, &mb);
-    else
-        packChunk(bodyData, mb);
+    packRange(bodyData, &mb);
 
     if (mb.contentSize()) {
         /* write */
@@ -1056,6 +1070,37 @@ ClientSocketContext::packChunk(const StoreIOBuffer &bodyData, MemBuf &mb)
     mb.Printf("\r\n");
 }
 
+/**
+ * Writes bodyData using chunked encoding. The chunk framing and the body
+ * bytes are gathered by the write rather than copied together.
+ * Writes the last-chunk if bodyData is empty.
+ */
+void
+ClientSocketContext::writeChunk(const StoreIOBuffer &bodyData)
+{
+    const uint64_t length =
+        static_cast<uint64_t>(lengthToSend(bodyData.range()));
+    noteSentBodyBytes(length);
+
+    MemBuf framing;
+    framing.init();
+    framing.Printf("%" PRIX64 "\r\n", length);
+    const size_t prefixSize = framing.contentSize();
+    framing.append("\r\n", 2);
+
+    struct iovec iov[3];
+    iov[0].iov_base = framing.content();
+    iov[0].iov_len = prefixSize;
+    iov[1].iov_base = bodyData.data;
+    iov[1].iov_len = length;
+    iov[2].iov_base = framing.content() + prefixSize;
+    iov[2].iov_len = 2;
+
+    AsyncCall::Pointer call = commCbCall(33, 5, "clientWriteComplete",
+                                         CommIoCbPtrFun(clientWriteComplete, this));
+    Comm::Write(clientConnection, iov, 3, call, framing.freeFunc());
+}
+
 /** put terminating boundary for multiparts */
 static void
 clientPackTermBound(String boundary, MemBuf * mb)
@@ -1404,7 +1449,13 @@ ClientSocketContext::sendStartOfMessage(HttpReply * rep, StoreIOBuffer bodyData)
 {
     prepareReply(rep);
     assert (rep);
-    MemBuf *mb = rep->pack();
+    MemBuf *mb = NULL;
+    // hit replies are clones that share most fields with the stored reply
+    StoreEntry *e = http->storeEntry();
+    if (e && e->mem_obj && e->mem_obj->getReply() != rep)
+        mb = rep->pack(e->mem_obj->headerImage(), *e->mem_obj->getReply());
+    else
+        mb = rep->pack();
 
     // dump now, so we dont output any body.
     debugs(11, 2, "HTTP Client " << clientConnection);
@@ -1417,16 +1468,15 @@ ClientSocketContext::sendStartOfMessage(HttpReply * rep, StoreIOBuffer bodyData)
     headersLog(0, 0, http->request->method, rep);
 #endif
 
+    size_t bodyLength = 0; // body bytes written from bodyData after mb
     if (bodyData.data && bodyData.length) {
         if (multipartRangeRequest())
             packRange(bodyData, mb);
         else if (http->request->flags.chunkedReply) {
             packChunk(bodyData, *mb);
         } else {
-            size_t length = lengthToSend(bodyData.range());
-            noteSentBodyBytes (length);
-
-            mb->append(bodyData.data, length);
+            bodyLength = lengthToSend(bodyData.range());
+            noteSentBodyBytes (bodyLength);
         }
     }
 
@@ -1434,7 +1484,15 @@ ClientSocketContext::sendStartOfMessage(HttpReply * rep, StoreIOBuffer bodyData)
     debugs(33,7, HERE << "sendStartOfMessage schedules clientWriteComplete");
     AsyncCall::Pointer call = commCbCall(33, 5, "clientWriteComplete",
                                          CommIoCbPtrFun(clientWriteComplete, this));
-    Comm::Write(clientConnection, mb, call);
+    if (bodyLength) {
+        struct iovec iov[2];
+        iov[0].iov_base = mb->content();
+        iov[0].iov_len = mb->contentSize();
+        iov[1].iov_base = bodyData.data;
+        iov[1].iov_len = bodyLength;
+        Comm::Write(clientConnection, iov, 2, call, mb->freeFunc());
+    } else
+        Comm::Write(clientConnection, mb, call);
     delete mb;
 }
 
@@ -1513,6 +1571,13 @@ clientWriteBodyComplete(const Comm::ConnectionPointer &conn, char *buf, size_t s
     clientWriteComplete(conn, NULL, size, errflag, xerrno, data);
 }
 
+static void
+clientWriteFileComplete(const Comm::ConnectionPointer &conn, char *buf, size_t size, Comm::Flag errflag, int xerrno, void *data)
+{
+    kb_incr(&statCounter.client_http.sendfile_kbytes_out, size);
+    clientWriteBodyComplete(conn, buf, size, errflag, xerrno, data);
+}
+
 void
 ConnStateData::readNextRequest()
 {
@@ -1724,11 +1789,78 @@ ClientSocketContext::getNextRangeOffset() const
     return http->out.offset;
 }
 
+/// the most body bytes a single Comm::SendFile() is asked to send
+static const int64_t MaxSendFileSize = 64*1024*1024;
+
+/**
+ * Sends the next part of a disk hit body straight from the cache file to
+ * the client socket, bypassing the store client and our read buffer.
+ * Only plain bodies qualify: ranges, chunked encoding, stream filters
+ * (e.g., ESI) and TLS need the bytes in userspace.
+ * \returns whether the body bytes are being sent
+ */
+bool
+ClientSocketContext::sendBodyFromFile()
+{
+#if HAVE_SYS_SENDFILE_H
+    StoreEntry *e = http->storeEntry();
+    if (!e || !e->mem_obj || e->store_status != STORE_OK ||
+            e->swap_status != SWAPOUT_DONE || EBIT_TEST(e->flags, ENTRY_ABORTED))
+        return false;
+
+    if (http->request->range || http->request->flags.chunkedReply ||
+            http->client_stream.head->next != http->client_stream.tail)
+        return false;
+
+    if (fd_table[clientConnection->fd].write_method != &default_write_method)
+        return false;
+
+    clientStreamNode *node = static_cast<clientStreamNode *>(http->client_stream.head->data);
+    const clientReplyContext *repContext = dynamic_cast<clientReplyContext *>(node->data.getRaw());
+    if (!repContext || !repContext->flags.headersSent)
+        return false;
+
+    const MemObject *mem = e->mem_obj;
+    const int64_t objectOffset = repContext->headers_sz + http->out.offset;
+    const int64_t length = min(e->objectLen() - objectOffset, MaxSendFileSize);
+    if (length <= 0 || !mem->swap_hdr_sz)
+        return false;
+
+    if (mem->inmem_lo <= objectOffset && objectOffset < mem->endOffset())
+        return false; // the store client will lend us the in-memory bytes
+
+    if (flags.noBodyFile)
+        return false;
+
+    // the file stays open for the following parts of the body
+    if (bodyFileFd < 0) {
+        bodyFileFd = e->store()->openContiguous(*e);
+        if (bodyFileFd < 0) {
+            flags.noBodyFile = 1;
+            return false;
+        }
+    }
+
+    debugs(33, 5, "sending " << length << " body bytes of " << *e << " from FD " << bodyFileFd);
+    ++statCounter.client_http.sendfile_writes;
+    noteSentBodyBytes(length);
+    AsyncCall::Pointer call = commCbCall(33, 5, "clientWriteFileComplete",
+                                         CommIoCbPtrFun(clientWriteFileComplete, this));
+    Comm::SendFile(clientConnection, bodyFileFd, mem->swap_hdr_sz + objectOffset, length, call);
+    return true;
+#else
+    return false;
+#endif
+}
+
 void
 ClientSocketContext::pullData()
 {
     debugs(33, 5, reply << " written " << http->out.size << " into " << clientConnection);
 
+    if (sendBodyFromFile())
+        return;
+
     /* More data will be coming from the stream. */
     StoreIOBuffer readBuffer;
     /* XXX: Next requested byte in the range sequence */
@@ -2211,7 +2343,7 @@ parseHttpRequest(ConnStateData *csd, HttpParser *hp, HttpRequestMethod * method_
 
     /* This call scans the entire request, not just the headers */
     if (hp->req.v_maj > 0) {
-        if ((req_sz = headersEnd(hp->buf, hp->bufsiz)) == 0) {
+        if ((req_sz = hp->findHeadersEnd()) == 0) {
             debugs(33, 5, "Incomplete request, waiting for end of headers");
             return NULL;
         }
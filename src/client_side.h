@@ -11,6 +11,7 @@
 #ifndef SQUID_CLIENTSIDE_H
 #define SQUID_CLIENTSIDE_H
 
+#include "acl/ResultCache.h"
 #include "base/RunnersRegistry.h"
 #include "clientStreamForward.h"
 #include "comm.h"
@@ -88,6 +89,8 @@ public:
         unsigned deferred:1; /* This is a pipelined request waiting for the current object to complete */
 
         unsigned parsed_ok:1; /* Was this parsed correctly? */
+
+        unsigned noBodyFile:1; ///< sendBodyFromFile() could not open the swap file
     } flags;
     bool mayUseConnection() const {return mayUseConnection_;}
 
@@ -107,7 +110,9 @@ public:
 
     DeferredParams deferredparams;
     int64_t writtenToSocket;
+    int bodyFileFd; ///< the open swap file sendBodyFromFile() sends from, or -1
     void pullData();
+    bool sendBodyFromFile();
     int64_t getNextRangeOffset() const;
     bool canPackMoreRanges() const;
     clientStream_status_t socketState();
@@ -140,6 +145,7 @@ protected:
 private:
     void prepareReply(HttpReply * rep);
     void packChunk(const StoreIOBuffer &bodyData, MemBuf &mb);
+    void writeChunk(const StoreIOBuffer &bodyData);
     void packRange(StoreIOBuffer const &, MemBuf * mb);
     void deRegisterWithConn();
     void doClose();
@@ -264,6 +270,9 @@ public:
     /// Squid listening port details where this connection arrived.
     AnyP::PortCfgPointer port;
 
+    /// results of ACLs that depend on the connection details only
+    Acl::ResultCache aclResults;
+
     bool transparent() const;
     bool reading() const;
     void stopReading(); ///< cancels comm_read if it is scheduled
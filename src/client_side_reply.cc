@@ -1777,6 +1777,10 @@ clientGetMoreData(clientStreamNode * aNode, ClientHttpRequest * http)
 
     /* no cbdatareference, this is only used once, and safely */
     if (context->flags.storelogiccomplete) {
+        // the socket writer sends body bytes before asking for more, so
+        // it can use in-memory pages without a copy
+        context->sc->flags.lend_pages = context->flags.headersSent && !next->node.next;
+
         StoreIOBuffer tempBuffer;
         tempBuffer.offset = next->readBuffer.offset + context->headers_sz;
         tempBuffer.length = next->readBuffer.length;
@@ -2185,7 +2189,10 @@ clientReplyContext::sendMoreData (StoreIOBuffer result)
 
     char *buf = next()->readBuffer.data;
 
-    if (buf != result.data) {
+    if (flags.headersSent && sc->flags.lend_pages && result.data) {
+        /* a store page lent to us; pass it on in place */
+        buf = result.data;
+    } else if (buf != result.data) {
         /* we've got to copy some data */
         assert(result.length <= next()->readBuffer.length);
         memcpy(buf, result.data, result.length);
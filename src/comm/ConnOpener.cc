@@ -39,7 +39,10 @@ Comm::ConnOpener::ConnOpener(Comm::ConnectionPointer &c, AsyncCall::Pointer &han
     totalTries_(0),
     failRetries_(0),
     deadline_(squid_curtime + static_cast<time_t>(ctimeout))
-{}
+{
+    startTime_.tv_sec = 0;
+    startTime_.tv_usec = 0;
+}
 
 Comm::ConnOpener::~ConnOpener()
 {
@@ -109,7 +112,11 @@ void
 Comm::ConnOpener::sendAnswer(Comm::Flag errFlag, int xerrno, const char *why)
 {
     // only mark the address good/bad AFTER connect is finished.
-    if (host_ != NULL) {
+    // Attempts abandoned by the initiator (e.g., after losing a connection
+    // race) tell nothing about the address.
+    if (host_ != NULL && callback_ != NULL && !callback_->canceled()) {
+        ipcacheNoteConnect(host_, conn_->remote, errFlag == Comm::OK,
+                           tvSubMsec(startTime_, current_time));
         if (xerrno == 0) // XXX: should not we use errFlag instead?
             ipcacheMarkGoodAddr(host_, conn_->remote);
         else {
@@ -235,6 +242,7 @@ Comm::ConnOpener::start()
     }
 
     conn_->noteStart();
+    startTime_ = current_time;
     if (createFd())
         doConnect();
 }
@@ -77,6 +77,9 @@ private:
     /// if we are not done by then, we will call back with Comm::TIMEOUT
     time_t deadline_;
 
+    /// when start() was called; for connection establishment time stats
+    struct timeval startTime_;
+
     /// handles to calls which we may need to cancel.
     struct Calls {
         AsyncCall::Pointer earlyAbort_;
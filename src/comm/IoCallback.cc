@@ -102,6 +102,10 @@ Comm::IoCallback::reset()
         buf = NULL;
         freefunc = NULL;
     }
+    safe_free(iov);
+    iovcnt = 0;
+    sendingFile = false;
+    fileFd = -1;
     xerrno = 0;
 
 #if USE_DELAY_POOLS
@@ -15,6 +15,7 @@
 #include "typedefs.h"
 
 class SBuf;
+struct iovec;
 
 namespace Comm
 {
@@ -37,6 +38,11 @@ public:
     FREE *freefunc;
     int size;
     int offset;
+    struct iovec *iov; ///< gathered write buffers (or nil); buf is iov[0]
+    int iovcnt;
+    bool sendingFile; ///< writes come from fileFd via sendfile(2)
+    int fileFd; ///< the file to send from; the caller keeps it open
+    int64_t fileOffset; ///< file position of the first byte to write
     Comm::Flag errcode;
     int xerrno;
 #if USE_DELAY_POOLS
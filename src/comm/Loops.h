@@ -39,6 +39,19 @@ Comm::Flag DoSelect(int);
 
 void QuickPollRequired(void);
 
+#if USE_IO_URING
+/// The epoll(2) loop API implementation. The io_uring poll backend uses it
+/// when the running kernel does not support io_uring(7) well enough.
+namespace Epoll
+{
+void SelectLoopInit(void);
+void SetSelect(int, unsigned int, PF *, void *, time_t);
+void ResetSelect(int);
+Comm::Flag DoSelect(int);
+void QuickPollRequired(void);
+} // namespace Epoll
+#endif
+
 /**
  * Max number of UDP messages to receive per call to the UDP receive poller.
  * This is a per-port limit for ICP/HTCP ports.
@@ -49,10 +49,36 @@
 #include <sys/epoll.h>
 #endif
 
+#if USE_IO_URING
+/* ModIoUring.cc implements the Comm loop API and falls back to us */
+#define EPOLL_LOOP Comm::Epoll
+#else
+#define EPOLL_LOOP Comm
+#endif
+
 static int kdpfd;
 static int max_poll_time = 1000;
 
+/**
+ * Maximum number of ready FDs harvested by one epoll_wait(2) call.
+ * Bounding the batch lets queued async calls and timed events run between
+ * batches instead of waiting for every ready FD of a busy loop to be served.
+ * The kernel rotates its ready list, so FDs left over are harvested first
+ * by the next call.
+ */
+#define EPOLL_BATCH_MAX 256
+
 static struct epoll_event *pevents;
+static int pevents_size = 0;
+
+/// whether the last epoll_wait(2) call filled the whole batch
+static bool epoll_backlogged = false;
+
+/* statistics for the comm_epoll_incoming report */
+static StatHist epoll_dispatch_time_hist; ///< usec spent calling handlers per loop
+static StatHist epoll_wait_time_hist; ///< msec spent blocked in epoll_wait(2)
+static uint64_t epoll_full_batches = 0; ///< loops which filled the whole batch
+static uint64_t epoll_zero_waits = 0; ///< loops which skipped waiting due to a backlog
 
 static void commEPollRegisterWithCacheManager(void);
 
@@ -64,9 +90,10 @@ static void commEPollRegisterWithCacheManager(void);
  * the network loop code.
  */
 void
-Comm::SelectLoopInit(void)
+EPOLL_LOOP::SelectLoopInit(void)
 {
-    pevents = (struct epoll_event *) xmalloc(SQUID_MAXFD * sizeof(struct epoll_event));
+    pevents_size = min(SQUID_MAXFD, EPOLL_BATCH_MAX);
+    pevents = (struct epoll_event *) xmalloc(pevents_size * sizeof(struct epoll_event));
 
     if (!pevents) {
         fatalf("comm_select_init: xmalloc() failed: %s\n",xstrerror());
@@ -78,6 +105,9 @@ Comm::SelectLoopInit(void)
         fatalf("comm_select_init: epoll_create(): %s\n",xstrerror());
     }
 
+    epoll_dispatch_time_hist.logInit(100, 0.0, 1000000.0 * 10.0);
+    epoll_wait_time_hist.logInit(100, 0.0, 1000.0 * 10.0);
+
     commEPollRegisterWithCacheManager();
 }
 
@@ -104,7 +134,7 @@ static const char* epolltype_atoi(int x)
  * and deregister interest in a pending IO state for a given FD.
  */
 void
-Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time_t timeout)
+EPOLL_LOOP::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time_t timeout)
 {
     fde *F = &fd_table[fd];
     int epoll_ctl_type = 0;
@@ -182,7 +212,7 @@ Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time
 }
 
 void
-Comm::ResetSelect(int fd)
+EPOLL_LOOP::ResetSelect(int fd)
 {
     fde *F = &fd_table[fd];
     F->epoll_state = 0;
@@ -204,8 +234,15 @@ commIncomingStats(StoreEntry * sentry)
 {
     StatCounters *f = &statCounter;
     storeAppendPrintf(sentry, "Total number of epoll(2) loops: %ld\n", statCounter.select_loops);
+    storeAppendPrintf(sentry, "Maximum events harvested per loop: %d\n", pevents_size);
+    storeAppendPrintf(sentry, "Loops harvesting a full batch: %" PRIu64 "\n", epoll_full_batches);
+    storeAppendPrintf(sentry, "Loops skipping the wait due to backlog: %" PRIu64 "\n", epoll_zero_waits);
     storeAppendPrintf(sentry, "Histogram of returned filedescriptors\n");
     f->select_fds_hist.dump(sentry, statHistIntDumper);
+    storeAppendPrintf(sentry, "Histogram of time blocked in epoll_wait(2) (msec)\n");
+    epoll_wait_time_hist.dump(sentry, NULL);
+    storeAppendPrintf(sentry, "Histogram of time spent calling handlers per loop (usec)\n");
+    epoll_dispatch_time_hist.dump(sentry, NULL);
 }
 
 /**
@@ -217,9 +254,15 @@ commIncomingStats(StoreEntry * sentry)
  * new IO code). This routine handles the stuff we've hidden in
  * comm_setselect and fd_table[] and calls callbacks for IO ready
  * events.
+ *
+ * The msec timeout is the delay until the next scheduled event (see
+ * EventLoop::runOnce()). At most EPOLL_BATCH_MAX FDs are harvested per
+ * call. When the previous call filled its batch, more FDs are probably
+ * ready already, so we poll without blocking to let the main loop dispatch
+ * calls and events between batches.
  */
 Comm::Flag
-Comm::DoSelect(int msec)
+EPOLL_LOOP::DoSelect(int msec)
 {
     int num, i,fd;
     fde *F;
@@ -232,8 +275,15 @@ Comm::DoSelect(int msec)
     if (msec > max_poll_time)
         msec = max_poll_time;
 
+    if (epoll_backlogged && msec > 0) {
+        msec = 0;
+        ++epoll_zero_waits;
+    }
+
+    const struct timeval waitStart = current_time;
+
     for (;;) {
-        num = epoll_wait(kdpfd, pevents, SQUID_MAXFD, msec);
+        num = epoll_wait(kdpfd, pevents, pevents_size, msec);
         ++ statCounter.select_loops;
 
         if (num >= 0)
@@ -252,13 +302,22 @@ Comm::DoSelect(int msec)
     PROF_stop(comm_check_incoming);
     getCurrentTime();
 
+    if (msec > 0)
+        epoll_wait_time_hist.count(tvSubMsec(waitStart, current_time));
+
     statCounter.select_fds_hist.count(num);
 
+    epoll_backlogged = (num == pevents_size);
+    if (epoll_backlogged)
+        ++epoll_full_batches;
+
     if (num == 0)
         return Comm::TIMEOUT;       /* No error.. */
 
     PROF_start(comm_handle_ready_fd);
 
+    const struct timeval dispatchStart = current_time;
+
     for (i = 0, cevents = pevents; i < num; ++i, ++cevents) {
         fd = cevents->data.fd;
         F = &fd_table[fd];
@@ -302,11 +361,14 @@ Comm::DoSelect(int msec)
 
     PROF_stop(comm_handle_ready_fd);
 
+    getCurrentTime();
+    epoll_dispatch_time_hist.count(tvSubUsec(dispatchStart, current_time));
+
     return Comm::OK;
 }
 
 void
-Comm::QuickPollRequired(void)
+EPOLL_LOOP::QuickPollRequired(void)
 {
     max_poll_time = 10;
 }
@@ -0,0 +1,628 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 05    Socket Functions */
+
+/*
+ * Experimental Linux io_uring(7) poll backend for the Comm loop.
+ *
+ * This module only replaces the readiness notification mechanism; it is
+ * not an asynchronous I/O engine. FD readiness is requested with one-shot
+ * IORING_OP_POLL_ADD submissions (and withdrawn with IORING_OP_POLL_REMOVE),
+ * matching the one-shot nature of comm handlers. Interest changes made by
+ * Comm::SetSelect() are only recorded; they are turned into submission
+ * queue entries and handed to the kernel together with the wait for
+ * completions, in a single io_uring_enter(2) call per loop iteration.
+ * Compared to epoll, this saves the epoll_ctl(2) call made for nearly every
+ * interest change on busy connections.
+ *
+ * No read, write, accept, or connect operations are submitted to the ring:
+ * those still go through comm/Read.cc, comm/Write.cc, and friends once the
+ * FD is reported ready.
+ *
+ * When the running kernel lacks io_uring or the features used here
+ * (single mmap rings, non-dropping CQ ring, waiting with a timeout), the
+ * module falls back to the epoll(2) loop at startup.
+ *
+ * XXX Currently not implemented / supported by this module XXX
+ *
+ * - delay pools
+ * - deferred reads
+ */
+
+#include "squid.h"
+
+#if USE_IO_URING
+
+#include "comm/Loops.h"
+#include "fde.h"
+#include "globals.h"
+#include "mgr/Registration.h"
+#include "profiler/Profiler.h"
+#include "SquidTime.h"
+#include "StatCounters.h"
+#include "StatHist.h"
+#include "Store.h"
+
+#include <cerrno>
+#include <vector>
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+#if HAVE_POLL_H
+#include <poll.h>
+#endif
+#include <sys/mman.h>
+#if HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+
+/// number of submission queue entries; the kernel sizes the CQ ring at twice that
+#define URING_ENTRIES 4096
+
+/// user_data of submissions whose completions carry no FD readiness
+#define URING_IGNORED_DATA 0
+
+static int max_poll_time = 1000;
+
+/// whether the io_uring could not be used and we delegate to Comm::Epoll
+static bool useEpoll = false;
+
+/// io_uring shared with the kernel
+static struct {
+    int fd;
+
+    unsigned char *ringMem; ///< mmapped SQ and CQ rings
+    size_t ringMemSize;
+    struct io_uring_sqe *sqes; ///< mmapped submission queue entries
+    size_t sqesSize;
+
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned sqEntries;
+    unsigned sqLocalTail; ///< our tail, published to the kernel before entering
+    unsigned sqToSubmit; ///< entries filled but not yet consumed by the kernel
+
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+} ring;
+
+/// io_uring poll state of an FD
+class UringFdState
+{
+public:
+    UringFdState(): armed(0), armedData(URING_IGNORED_DATA), generation(0), changed(false) {}
+
+    unsigned armed; ///< poll(2) events of the outstanding POLL_ADD or zero
+    uint64_t armedData; ///< user_data of the outstanding POLL_ADD
+    uint32_t generation; ///< bumped whenever an outstanding POLL_ADD is abandoned
+    bool changed; ///< whether the FD is queued in changedFds
+};
+
+static std::vector<UringFdState> fdStates;
+
+/// FDs whose handlers changed since the last submission
+static std::vector<int> changedFds;
+
+/// user_data of abandoned POLL_ADDs that still need to be removed
+static std::vector<uint64_t> staleRequests;
+
+/// FD readiness collected from the CQ ring before calling handlers
+class UringReadyFd
+{
+public:
+    int fd;
+    uint32_t generation;
+    int revents;
+};
+
+static std::vector<UringReadyFd> readyFds;
+
+/* statistics for the comm_io_uring_incoming report */
+static uint64_t uring_enters = 0;
+static uint64_t uring_submitted = 0;
+static uint64_t uring_completions = 0;
+static uint64_t uring_stale_completions = 0;
+static StatHist uring_submitted_hist; ///< SQEs submitted per loop
+
+static void commIoUringRegisterWithCacheManager(void);
+
+static inline uint64_t
+uringRequestData(const int fd, const uint32_t generation)
+{
+    // never URING_IGNORED_DATA because generation is at least 1
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+static int
+uringSetup(unsigned entries, struct io_uring_params *params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+uringEnter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void *arg, size_t argSize)
+{
+    return syscall(__NR_io_uring_enter, ring.fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+/// maps the rings of a successfully set up io_uring
+/// \returns false if the kernel does not support what we need
+static bool
+uringMapRings(const struct io_uring_params &params)
+{
+    const unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & needed) != needed) {
+        debugs(5, DBG_IMPORTANT, "io_uring lacks required features (" << std::hex <<
+               params.features << " instead of " << needed << ")");
+        return false;
+    }
+
+    const size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring.ringMemSize = max(sqSize, cqSize);
+    void *mem = mmap(NULL, ring.ringMemSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ring.fd, IORING_OFF_SQ_RING);
+    if (mem == MAP_FAILED) {
+        debugs(5, DBG_IMPORTANT, "io_uring rings mmap failure: " << xstrerror());
+        return false;
+    }
+    ring.ringMem = static_cast<unsigned char *>(mem);
+
+    ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    mem = mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+               ring.fd, IORING_OFF_SQES);
+    if (mem == MAP_FAILED) {
+        debugs(5, DBG_IMPORTANT, "io_uring SQEs mmap failure: " << xstrerror());
+        munmap(ring.ringMem, ring.ringMemSize);
+        return false;
+    }
+    ring.sqes = static_cast<struct io_uring_sqe *>(mem);
+
+    ring.sqHead = reinterpret_cast<unsigned *>(ring.ringMem + params.sq_off.head);
+    ring.sqTail = reinterpret_cast<unsigned *>(ring.ringMem + params.sq_off.tail);
+    ring.sqMask = reinterpret_cast<unsigned *>(ring.ringMem + params.sq_off.ring_mask);
+    ring.sqArray = reinterpret_cast<unsigned *>(ring.ringMem + params.sq_off.array);
+    ring.sqEntries = params.sq_entries;
+    ring.sqLocalTail = *ring.sqTail;
+    ring.sqToSubmit = 0;
+
+    ring.cqHead = reinterpret_cast<unsigned *>(ring.ringMem + params.cq_off.head);
+    ring.cqTail = reinterpret_cast<unsigned *>(ring.ringMem + params.cq_off.tail);
+    ring.cqMask = reinterpret_cast<unsigned *>(ring.ringMem + params.cq_off.ring_mask);
+    ring.cqes = reinterpret_cast<struct io_uring_cqe *>(ring.ringMem + params.cq_off.cqes);
+    return true;
+}
+
+/// makes filled SQEs visible to the kernel
+static void
+uringPublishSqes()
+{
+    __atomic_store_n(ring.sqTail, ring.sqLocalTail, __ATOMIC_RELEASE);
+}
+
+/// hands all filled SQEs to the kernel without waiting for completions
+static void
+uringSubmitPending()
+{
+    uringPublishSqes();
+    while (ring.sqToSubmit > 0) {
+        const int submitted = uringEnter(ring.sqToSubmit, 0, 0, NULL, 0);
+        ++uring_enters;
+        if (submitted < 0) {
+            if (ignoreErrno(errno))
+                continue;
+            debugs(5, DBG_IMPORTANT, "io_uring_enter(2) submission failure: " << xstrerror());
+            return;
+        }
+        if (!submitted)
+            return; // the kernel is busy; try again during the next loop iteration
+        uring_submitted += submitted;
+        ring.sqToSubmit = ring.sqLocalTail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+    }
+}
+
+/// \returns a cleared SQE to fill or nil if the SQ ring stays full
+static struct io_uring_sqe *
+uringGetSqe()
+{
+    if (ring.sqLocalTail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE) >= ring.sqEntries) {
+        uringSubmitPending();
+        if (ring.sqLocalTail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE) >= ring.sqEntries)
+            return NULL;
+    }
+
+    const unsigned index = ring.sqLocalTail & *ring.sqMask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sqArray[index] = index;
+    ++ring.sqLocalTail;
+    ++ring.sqToSubmit;
+    return sqe;
+}
+
+/// queues removal of the POLL_ADD identified by requestData
+static bool
+uringRemovePoll(const uint64_t requestData)
+{
+    struct io_uring_sqe *sqe = uringGetSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = requestData;
+    sqe->user_data = URING_IGNORED_DATA;
+    return true;
+}
+
+/// forgets the outstanding POLL_ADD of the FD, if any, and any readiness
+/// of the FD already collected by the current Comm::DoSelect() call
+static void
+uringAbandonPoll(const int fd)
+{
+    UringFdState &state = fdStates[fd];
+    // Even without an outstanding poll, the FD may be in readyFds; the
+    // bump stops DoSelect() from calling handlers of a reused FD number.
+    ++state.generation;
+    if (!state.armed)
+        return;
+    staleRequests.push_back(state.armedData);
+    state.armed = 0;
+    state.armedData = URING_IGNORED_DATA;
+}
+
+static void
+uringNoteChange(const int fd)
+{
+    UringFdState &state = fdStates[fd];
+    if (!state.changed) {
+        state.changed = true;
+        changedFds.push_back(fd);
+    }
+}
+
+/// the poll(2) events the FD handlers are currently waiting for
+static unsigned
+uringWantedEvents(const fde &F)
+{
+    if (!F.flags.open)
+        return 0;
+
+    unsigned events = 0;
+    if (F.read_handler) {
+        events |= POLLIN;
+        // Hack to keep the events flowing if there is data immediately ready
+        if (F.flags.read_pending)
+            events |= POLLOUT;
+    }
+    if (F.write_handler)
+        events |= POLLOUT;
+    return events;
+}
+
+/// converts recorded interest changes into POLL_ADD and POLL_REMOVE SQEs
+static void
+uringQueueChanges()
+{
+    while (!staleRequests.empty()) {
+        if (!uringRemovePoll(staleRequests.back()))
+            break; // retry during the next loop iteration
+        staleRequests.pop_back();
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < changedFds.size(); ++i) {
+        const int fd = changedFds[i];
+        UringFdState &state = fdStates[fd];
+        const unsigned wanted = uringWantedEvents(fd_table[fd]);
+
+        // an outstanding poll for a superset of wanted events is good enough;
+        // a completion without a matching handler just rearms the FD
+        if (wanted && (state.armed & wanted) == wanted) {
+            state.changed = false;
+            continue;
+        }
+
+        if (state.armed) {
+            if (!uringRemovePoll(state.armedData)) {
+                changedFds[kept++] = fd;
+                continue;
+            }
+            state.armed = 0;
+            state.armedData = URING_IGNORED_DATA;
+            ++state.generation;
+        }
+
+        if (wanted) {
+            struct io_uring_sqe *sqe = uringGetSqe();
+            if (!sqe) {
+                changedFds[kept++] = fd;
+                continue;
+            }
+            ++state.generation;
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = fd;
+            sqe->poll32_events = wanted;
+            sqe->user_data = uringRequestData(fd, state.generation);
+            state.armed = wanted;
+            state.armedData = sqe->user_data;
+        }
+
+        state.changed = false;
+    }
+    changedFds.resize(kept);
+
+    uringPublishSqes();
+}
+
+/// moves FD readiness from the CQ ring to readyFds
+static void
+uringReapCompletions()
+{
+    unsigned head = *ring.cqHead;
+    const unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe &cqe = ring.cqes[head & *ring.cqMask];
+        ++uring_completions;
+
+        if (cqe.user_data == URING_IGNORED_DATA)
+            continue; // POLL_REMOVE result
+
+        const int fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+        const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+        UringFdState &state = fdStates[fd];
+        if (state.generation != generation || !state.armed) {
+            ++uring_stale_completions; // abandoned or cancelled poll
+            continue;
+        }
+
+        state.armed = 0;
+        state.armedData = URING_IGNORED_DATA;
+        uringNoteChange(fd); // rearm unless handlers lose interest
+
+        UringReadyFd ready;
+        ready.fd = fd;
+        ready.generation = generation;
+        // treat poll failures (e.g., EBADF) like POLLERR
+        ready.revents = cqe.res >= 0 ? cqe.res : POLLERR;
+        readyFds.push_back(ready);
+    }
+
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+}
+
+/* XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX */
+/* Public functions */
+
+void
+Comm::SelectLoopInit(void)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring.fd = uringSetup(URING_ENTRIES, &params);
+    if (ring.fd < 0) {
+        debugs(5, DBG_IMPORTANT, "io_uring_setup(2) failure: " << xstrerror());
+    } else if (!uringMapRings(params)) {
+        close(ring.fd);
+        ring.fd = -1;
+    }
+
+    if (ring.fd < 0) {
+        debugs(5, DBG_IMPORTANT, "Falling back to epoll(2) for network I/O");
+        useEpoll = true;
+        Comm::Epoll::SelectLoopInit();
+        return;
+    }
+
+    debugs(5, DBG_IMPORTANT, "Using experimental io_uring(7) poll backend for network I/O with " <<
+           params.sq_entries << " submission entries");
+
+    fdStates.resize(SQUID_MAXFD);
+    uring_submitted_hist.enumInit(256);
+
+    commIoUringRegisterWithCacheManager();
+}
+
+/**
+ * Records the handler for the given FD. The kernel learns about changed
+ * interest during the next Comm::DoSelect() call.
+ */
+void
+Comm::SetSelect(int fd, unsigned int type, PF * handler, void *client_data, time_t timeout)
+{
+    if (useEpoll)
+        return Comm::Epoll::SetSelect(fd, type, handler, client_data, timeout);
+
+    fde *F = &fd_table[fd];
+    assert(fd >= 0);
+    debugs(5, 5, HERE << "FD " << fd << ", type=" << type <<
+           ", handler=" << handler << ", client_data=" << client_data <<
+           ", timeout=" << timeout);
+
+    if (type & COMM_SELECT_READ) {
+        F->read_handler = handler;
+        F->read_data = client_data;
+    }
+
+    if (type & COMM_SELECT_WRITE) {
+        F->write_handler = handler;
+        F->write_data = client_data;
+    }
+
+    // Abandon the outstanding poll right away when nobody is interested, so
+    // that its completion cannot reach handlers of a reused FD after close.
+    if (!F->flags.open || (!F->read_handler && !F->write_handler))
+        uringAbandonPoll(fd);
+    else
+        uringNoteChange(fd);
+
+    if (timeout)
+        F->timeout = squid_curtime + timeout;
+}
+
+void
+Comm::ResetSelect(int fd)
+{
+    if (useEpoll)
+        return Comm::Epoll::ResetSelect(fd);
+
+    uringAbandonPoll(fd);
+    uringNoteChange(fd);
+}
+
+static void commIncomingStats(StoreEntry * sentry);
+
+static void
+commIoUringRegisterWithCacheManager(void)
+{
+    Mgr::RegisterAction("comm_io_uring_incoming",
+                        "comm_incoming() stats",
+                        commIncomingStats, 0, 1);
+}
+
+static void
+commIncomingStats(StoreEntry * sentry)
+{
+    StatCounters *f = &statCounter;
+    storeAppendPrintf(sentry, "Total number of io_uring loops: %ld\n", statCounter.select_loops);
+    storeAppendPrintf(sentry, "Total number of io_uring_enter(2) calls: %" PRIu64 "\n", uring_enters);
+    storeAppendPrintf(sentry, "Total number of submissions: %" PRIu64 "\n", uring_submitted);
+    storeAppendPrintf(sentry, "Total number of completions: %" PRIu64 "\n", uring_completions);
+    storeAppendPrintf(sentry, "Completions of abandoned polls: %" PRIu64 "\n", uring_stale_completions);
+    storeAppendPrintf(sentry, "Histogram of submissions per loop\n");
+    uring_submitted_hist.dump(sentry, statHistIntDumper);
+    storeAppendPrintf(sentry, "Histogram of returned filedescriptors\n");
+    f->select_fds_hist.dump(sentry, statHistIntDumper);
+}
+
+/**
+ * Submits queued interest changes, waits up to msec for FD readiness,
+ * and calls the handlers of ready FDs.
+ */
+Comm::Flag
+Comm::DoSelect(int msec)
+{
+    if (useEpoll)
+        return Comm::Epoll::DoSelect(msec);
+
+    PROF_start(comm_check_incoming);
+
+    if (msec > max_poll_time)
+        msec = max_poll_time;
+
+    uringQueueChanges();
+
+    struct __kernel_timespec ts;
+    ts.tv_sec = msec / 1000;
+    ts.tv_nsec = (msec % 1000) * 1000000L;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = reinterpret_cast<uintptr_t>(&ts);
+
+    const unsigned toSubmit = ring.sqToSubmit;
+    for (;;) {
+        const int submitted = uringEnter(ring.sqToSubmit, 1,
+                                         IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                         &arg, sizeof(arg));
+        ++uring_enters;
+        ++ statCounter.select_loops;
+
+        // the kernel may consume SQEs even when the wait fails
+        ring.sqToSubmit = ring.sqLocalTail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+
+        if (submitted >= 0) {
+            uring_submitted += submitted;
+            break;
+        }
+
+        if (errno == ETIME || ignoreErrno(errno))
+            break;
+
+        getCurrentTime();
+
+        PROF_stop(comm_check_incoming);
+
+        return Comm::COMM_ERROR;
+    }
+
+    PROF_stop(comm_check_incoming);
+    getCurrentTime();
+
+    uring_submitted_hist.count(toSubmit - ring.sqToSubmit);
+
+    readyFds.clear();
+    uringReapCompletions();
+
+    const int num = readyFds.size();
+    statCounter.select_fds_hist.count(num);
+
+    if (num == 0)
+        return Comm::TIMEOUT;       /* No error.. */
+
+    PROF_start(comm_handle_ready_fd);
+
+    for (int i = 0; i < num; ++i) {
+        const UringReadyFd &ready = readyFds[i];
+        const int fd = ready.fd;
+        fde *F = &fd_table[fd];
+        PF *hdl;
+
+        debugs(5, 8, HERE << "got FD " << fd << " events=" << std::hex << ready.revents <<
+               " F->read_handler=" << F->read_handler << " F->write_handler=" << F->write_handler);
+
+        if (fdStates[fd].generation != ready.generation)
+            continue; // an earlier handler abandoned this poll, probably closing the FD
+
+        if (ready.revents & (POLLIN|POLLHUP|POLLERR) || F->flags.read_pending) {
+            if ((hdl = F->read_handler) != NULL) {
+                debugs(5, 8, HERE << "Calling read handler on FD " << fd);
+                PROF_start(comm_read_handler);
+                F->flags.read_pending = 0;
+                F->read_handler = NULL;
+                hdl(fd, F->read_data);
+                PROF_stop(comm_read_handler);
+                ++ statCounter.select_fds;
+            }
+        }
+
+        if (fdStates[fd].generation != ready.generation)
+            continue;
+
+        if (ready.revents & (POLLOUT|POLLHUP|POLLERR)) {
+            if ((hdl = F->write_handler) != NULL) {
+                debugs(5, 8, HERE << "Calling write handler on FD " << fd);
+                PROF_start(comm_write_handler);
+                F->write_handler = NULL;
+                hdl(fd, F->write_data);
+                PROF_stop(comm_write_handler);
+                ++ statCounter.select_fds;
+            }
+        }
+    }
+
+    PROF_stop(comm_handle_ready_fd);
+
+    return Comm::OK;
+}
+
+void
+Comm::QuickPollRequired(void)
+{
+    if (useEpoll)
+        return Comm::Epoll::QuickPollRequired();
+
+    max_poll_time = 10;
+}
+
+#endif /* USE_IO_URING */
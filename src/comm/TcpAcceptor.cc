@@ -314,6 +314,7 @@ Comm::TcpAcceptor::notify(const Comm::Flag flag, const Comm::ConnectionPointer &
         params.conn = params.xaction->tcpClient = newConnDetails;
         params.flag = flag;
         params.xerrno = errcode;
+        call->lane = AsyncCall::laneAccept;
         ScheduleCallHere(call);
     }
 }
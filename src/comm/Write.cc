@@ -10,6 +10,7 @@
 #include "comm/Connection.h"
 #include "comm/IoCallback.h"
 #include "comm/Write.h"
+#include "compat/cmsg.h"
 #include "fd.h"
 #include "fde.h"
 #include "globals.h"
@@ -22,6 +23,48 @@
 #endif
 
 #include <cerrno>
+#if HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+/// the most buffers a gathered write may have
+#define COMM_WRITEV_MAX 16
+
+/// Writes up to nleft of the bytes that state->iov still holds past
+/// state->offset, returning what writev() returns.
+static int
+WriteGathered(int fd, const Comm::IoCallback *state, int nleft)
+{
+#if HAVE_SYS_UIO_H
+    struct iovec pending[COMM_WRITEV_MAX];
+    int count = 0;
+    size_t skip = state->offset;
+    size_t left = nleft;
+    for (int i = 0; i < state->iovcnt && left > 0; ++i) {
+        const struct iovec &part = state->iov[i];
+        if (skip >= part.iov_len) {
+            skip -= part.iov_len;
+            continue;
+        }
+        pending[count].iov_base = static_cast<char*>(part.iov_base) + skip;
+        pending[count].iov_len = min(part.iov_len - skip, left);
+        left -= pending[count].iov_len;
+        skip = 0;
+        ++count;
+    }
+
+    PROF_start(write);
+    const int len = writev(fd, pending, count);
+    PROF_stop(write);
+    return len;
+#else
+    assert(false); // Comm::Write() gathers the buffers instead
+    return -1;
+#endif
+}
 
 void
 Comm::Write(const Comm::ConnectionPointer &conn, MemBuf *mb, AsyncCall::Pointer &callback)
@@ -47,6 +90,87 @@ Comm::Write(const Comm::ConnectionPointer &conn, const char *buf, int size, Asyn
     ccb->selectOrQueueWrite();
 }
 
+/// gathers the buffers into one write when the FD write method allows it
+void
+Comm::Write(const Comm::ConnectionPointer &conn, const struct iovec *iov, int iovcnt, AsyncCall::Pointer &callback, FREE * free_func)
+{
+    assert(iovcnt > 0 && iovcnt <= COMM_WRITEV_MAX);
+
+    int size = 0;
+    for (int i = 0; i < iovcnt; ++i)
+        size += iov[i].iov_len;
+
+#if HAVE_SYS_UIO_H
+    const bool gather = fd_table[conn->fd].write_method == &default_write_method;
+#else
+    const bool gather = false;
+#endif
+    if (!gather) {
+        // TLS and other non-plain write methods need a contiguous buffer
+        MemBuf mb;
+        mb.init();
+        for (int i = 0; i < iovcnt; ++i)
+            mb.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        if (free_func)
+            free_func(iov[0].iov_base);
+        Comm::Write(conn, &mb, callback);
+        return;
+    }
+
+    debugs(5, 5, HERE << conn << ": sz " << size << " in " << iovcnt << " buffers: asynCall " << callback);
+
+    /* Make sure we are open, not closing, and not writing */
+    assert(fd_table[conn->fd].flags.open);
+    assert(!fd_table[conn->fd].closing());
+    Comm::IoCallback *ccb = COMMIO_FD_WRITECB(conn->fd);
+    assert(!ccb->active());
+
+    fd_table[conn->fd].writeStart = squid_curtime;
+    ccb->conn = conn;
+    /* Queue the write */
+    ccb->setCallback(IOCB_WRITE, callback, static_cast<char*>(iov[0].iov_base), free_func, size);
+    ccb->iov = static_cast<struct iovec *>(xmalloc(iovcnt * sizeof(struct iovec)));
+    memcpy(ccb->iov, iov, iovcnt * sizeof(struct iovec));
+    ccb->iovcnt = iovcnt;
+    ccb->selectOrQueueWrite();
+}
+
+/// Sends up to nleft of the file bytes that state still has to write,
+/// returning what sendfile() returns.
+static int
+SendFileBytes(int fd, const Comm::IoCallback *state, int nleft)
+{
+#if HAVE_SYS_SENDFILE_H
+    off_t offset = state->fileOffset + state->offset;
+    return sendfile(fd, state->fileFd, &offset, nleft);
+#else
+    assert(false); // callers must not use Comm::SendFile() here
+    return -1;
+#endif
+}
+
+void
+Comm::SendFile(const Comm::ConnectionPointer &conn, int fileFd, int64_t offset, int size, AsyncCall::Pointer &callback)
+{
+    debugs(5, 5, HERE << conn << ": sz " << size << " from FD " << fileFd <<
+           " at " << offset << ": asynCall " << callback);
+
+    /* Make sure we are open, not closing, and not writing */
+    assert(fd_table[conn->fd].flags.open);
+    assert(!fd_table[conn->fd].closing());
+    Comm::IoCallback *ccb = COMMIO_FD_WRITECB(conn->fd);
+    assert(!ccb->active());
+
+    fd_table[conn->fd].writeStart = squid_curtime;
+    ccb->conn = conn;
+    /* Queue the write */
+    ccb->setCallback(IOCB_WRITE, callback, NULL, NULL, size);
+    ccb->sendingFile = true;
+    ccb->fileFd = fileFd;
+    ccb->fileOffset = offset;
+    ccb->selectOrQueueWrite();
+}
+
 /** Write to FD.
  * This function is used by the lowest level of IO loop which only has access to FD numbers.
  * We have to use the comm iocb_table to map FD numbers to waiting data and Comm::Connections.
@@ -103,7 +227,12 @@ Comm::HandleWrite(int fd, void *data)
 
     /* actually WRITE data */
     int xerrno = errno = 0;
-    len = FD_WRITE_METHOD(fd, state->buf + state->offset, nleft);
+    if (state->sendingFile)
+        len = SendFileBytes(fd, state, nleft);
+    else if (state->iov)
+        len = WriteGathered(fd, state, nleft);
+    else
+        len = FD_WRITE_METHOD(fd, state->buf + state->offset, nleft);
     xerrno = errno;
     debugs(5, 5, HERE << "write() returns " << len);
 
@@ -124,7 +253,10 @@ Comm::HandleWrite(int fd, void *data)
 #endif /* USE_DELAY_POOLS */
 
     fd_bytes(fd, len, FD_WRITE);
-    ++statCounter.syscalls.sock.writes;
+    if (state->sendingFile)
+        ++statCounter.syscalls.sock.sendfiles;
+    else
+        ++statCounter.syscalls.sock.writes;
     // After each successful partial write,
     // reset fde::writeStart to the current time.
     fd_table[fd].writeStart = squid_curtime;
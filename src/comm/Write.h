@@ -14,6 +14,8 @@
 #include "typedefs.h"
 
 class MemBuf;
+struct iovec;
+
 namespace Comm
 {
 
@@ -31,6 +33,23 @@ void Write(const Comm::ConnectionPointer &conn, const char *buf, int size, Async
  */
 void Write(const Comm::ConnectionPointer &conn, MemBuf *mb, AsyncCall::Pointer &callback);
 
+/**
+ * Queue a write of iovcnt buffers, gathered by writev(2) when the
+ * connection allows it. callback is scheduled when the write
+ * completes, on error, or on file descriptor close.
+ *
+ * The buffers must remain valid until then. free_func is used to free
+ * iov[0].iov_base when the write has completed.
+ */
+void Write(const Comm::ConnectionPointer &conn, const struct iovec *iov, int iovcnt, AsyncCall::Pointer &callback, FREE *free_func);
+
+/**
+ * Queue sending size bytes of the open fileFd, starting at offset, with
+ * sendfile(2). callback is scheduled when the write completes, on error,
+ * or on file descriptor close. The caller keeps fileFd open until then.
+ */
+void SendFile(const Comm::ConnectionPointer &conn, int fileFd, int64_t offset, int size, AsyncCall::Pointer &callback);
+
 /// Cancel the write pending on FD. No action if none pending.
 void WriteCancel(const Comm::ConnectionPointer &conn, const char *reason);
 
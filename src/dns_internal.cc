@@ -16,10 +16,10 @@
 #include "comm/Loops.h"
 #include "comm/Read.h"
 #include "comm/Write.h"
-#include "dlink.h"
 #include "event.h"
 #include "fd.h"
 #include "fde.h"
+#include "heap.h"
 #include "ip/tools.h"
 #include "Mem.h"
 #include "MemBuf.h"
@@ -119,8 +119,8 @@ struct _idns_query {
 
     struct timeval start_t;
     struct timeval sent_t;
-    struct timeval queue_t;
-    dlink_node lru;
+    double deadline; ///< when to retransmit or give up on the pending query
+    heap_node *deadline_node; ///< our idns_deadlines entry; nil unless pending
     IDNSCB *callback;
     void *callback_data;
     int attempt;
@@ -173,10 +173,18 @@ static int nns_mdns_count = 0;
 static int npc = 0;
 static int npc_alloc = 0;
 static int ndots = 1;
-static dlink_list lru_list;
 static int event_queued = 0;
 static hash_table *idns_lookup_hash = NULL;
 
+/// pending (sent but unanswered) queries, ordered by their deadline
+static heap *idns_deadlines = NULL;
+
+/// pending queries, indexed by query ID (which is unique among them)
+static idns_query **idns_pending = NULL;
+
+/// the number of all possible query IDs
+static const int IDNS_QUERY_IDS = 0x10000;
+
 /*
  * Notes on EDNS:
  *
@@ -227,6 +235,8 @@ static IOCB idnsSentQueryVC;
 
 static int idnsFromKnownNameserver(Ip::Address const &from);
 static idns_query *idnsFindQuery(unsigned short id);
+static void idnsAddPending(idns_query *q);
+static void idnsRemovePending(idns_query *q);
 static void idnsGrokReply(const char *buf, size_t sz, int from_ns);
 static PF idnsRead;
 static EVH idnsCheckQueue;
@@ -681,7 +691,6 @@ idnsParseWIN32Registry(void)
 static void
 idnsStats(StoreEntry * sentry)
 {
-    dlink_node *n;
     idns_query *q;
     int i;
     int j;
@@ -692,8 +701,8 @@ idnsStats(StoreEntry * sentry)
     storeAppendPrintf(sentry, "  ID   SIZE SENDS FIRST SEND LAST SEND M FQDN\n");
     storeAppendPrintf(sentry, "------ ---- ----- ---------- --------- - ----\n");
 
-    for (n = lru_list.head; n; n = n->next) {
-        q = (idns_query *)n->data;
+    for (unsigned long n = 0; n < heap_nodes(idns_deadlines); ++n) {
+        q = static_cast<idns_query *>(heap_peep(idns_deadlines, n));
         storeAppendPrintf(sentry, "%#06x %4d %5d %10.3f %9.3f %c %s\n",
                           (int) q->query_id, (int) q->sz, q->nsends,
                           tvSubDsec(q->start_t, current_time),
@@ -755,10 +764,15 @@ idnsTickleQueue(void)
     if (event_queued)
         return;
 
-    if (NULL == lru_list.tail)
+    if (heap_empty(idns_deadlines))
         return;
 
-    const double when = min(Config.Timeout.idns_query, Config.Timeout.idns_retransmit)/1000.0;
+    // wake up at the earliest deadline, but keep polling at least as often
+    // as before in case a query with an earlier deadline is sent meanwhile
+    double when = min(Config.Timeout.idns_query, Config.Timeout.idns_retransmit)/1000.0;
+    const double earliest = heap_peepminkey(idns_deadlines) - current_dtime;
+    if (earliest < when)
+        when = earliest > 0 ? earliest : 0;
 
     eventAdd("idnsCheckQueue", idnsCheckQueue, NULL, when, 1);
 
@@ -923,9 +937,7 @@ idnsSendQuery(idns_query * q)
         return;
     }
 
-    assert(q->lru.next == NULL);
-
-    assert(q->lru.prev == NULL);
+    assert(q->deadline_node == NULL);
 
     int x = -1, y = -1;
     int nsn;
@@ -966,9 +978,7 @@ idnsSendQuery(idns_query * q)
     }
 
     ++ nameservers[nsn].nqueries;
-    q->queue_t = current_time;
-    dlinkAdd(q, &q->lru, &lru_list);
-    q->pending = 1;
+    idnsAddPending(q);
     idnsTickleQueue();
 }
 
@@ -993,25 +1003,63 @@ idnsFromKnownNameserver(Ip::Address const &from)
 static idns_query *
 idnsFindQuery(unsigned short id)
 {
-    dlink_node *n;
-    idns_query *q;
+    return idns_pending[id];
+}
 
-    for (n = lru_list.tail; n; n = n->prev) {
-        q = (idns_query*)n->data;
+/// heap key generator for idns_deadlines
+static heap_key
+idnsDeadlineKey(void *data, heap_key)
+{
+    return static_cast<idns_query *>(data)->deadline;
+}
 
-        if (q->query_id == id)
-            return q;
-    }
+/// starts waiting for a reply to the just sent query
+static void
+idnsAddPending(idns_query *q)
+{
+    // the retransmission timeout doubles after each round of nameservers
+    const time_msec_t rto = Config.Timeout.idns_retransmit << ((q->nsends - 1) / nns);
+    q->deadline = q->sent_t.tv_sec + q->sent_t.tv_usec / 1000000.0 + rto / 1000.0;
+    q->deadline_node = heap_insert(idns_deadlines, q);
+
+    if (idns_pending[q->query_id])
+        debugs(78, DBG_IMPORTANT, "WARNING: DNS query ID 0x" << std::hex << q->query_id << " is already pending");
+    else
+        idns_pending[q->query_id] = q;
+
+    q->pending = 1;
+}
+
+/// stops waiting for a reply to the query, if any
+static void
+idnsRemovePending(idns_query *q)
+{
+    if (!q->deadline_node)
+        return;
+
+    heap_delete(idns_deadlines, q->deadline_node);
+    q->deadline_node = NULL;
+
+    if (idns_pending[q->query_id] == q)
+        idns_pending[q->query_id] = NULL;
 
-    return NULL;
+    q->pending = 0;
 }
 
 static unsigned short
 idnsQueryID(void)
 {
-    unsigned short id = squid_random() & 0xFFFF;
-    unsigned short first_id = id;
+    // Fresh random IDs are cheap to check, and they almost always succeed
+    // unless a large part of the ID space is pending. Stepping from the
+    // collision instead would make the next ID easier to guess.
+    unsigned short id = 0;
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        id = squid_random() & 0xFFFF;
+        if (!idnsFindQuery(id))
+            return id;
+    }
 
+    const unsigned short first_id = id;
     while (idnsFindQuery(id)) {
         ++id;
 
@@ -1167,8 +1215,7 @@ idnsGrokReply(const char *buf, size_t sz, int from_ns)
     }
 #endif
 
-    dlinkDelete(&q->lru, &lru_list);
-    q->pending = 0;
+    idnsRemovePending(q);
 
     if (message->tc) {
         debugs(78, 3, HERE << "Resolver requested TC (" << q->query.name << ")");
@@ -1228,7 +1275,7 @@ idnsGrokReply(const char *buf, size_t sz, int from_ns)
 
             // cleanup slave AAAA query
             while (idns_query *slave = q->slave) {
-                dlinkDelete(&slave->lru, &lru_list);
+                idnsRemovePending(slave);
                 q->slave = slave->slave;
                 rfc1035MessageDestroy(&slave->message);
                 cbdataFree(slave);
@@ -1331,7 +1378,7 @@ idnsRead(int fd, void *data)
 
         // Before unknown_nameservers check to avoid flooding cache.log on attacks,
         // but after the ++ above to keep statistics right.
-        if (!lru_list.head)
+        if (heap_empty(idns_deadlines))
             continue; // Don't process replies if there is no pending query.
 
         if (nsn < 0 && Config.onoff.ignore_unknown_nameservers) {
@@ -1353,8 +1400,6 @@ idnsRead(int fd, void *data)
 static void
 idnsCheckQueue(void *unused)
 {
-    dlink_node *n;
-    dlink_node *p = NULL;
     idns_query *q;
     event_queued = 0;
 
@@ -1362,29 +1407,19 @@ idnsCheckQueue(void *unused)
         /* name servers went away; reconfiguring or shutting down */
         return;
 
-    for (n = lru_list.tail; n; n = p) {
-
-        p = n->prev;
-        q = static_cast<idns_query*>(n->data);
-
+    while (!heap_empty(idns_deadlines)) {
         /* Anything to process in the queue? */
-        if ((time_msec_t)tvSubMsec(q->queue_t, current_time) < Config.Timeout.idns_retransmit )
+        // queries (re)sent below are due no earlier than now; leave them be
+        if (heap_peepminkey(idns_deadlines) >= current_dtime)
             break;
 
-        /* Query timer still running? */
-        if ((time_msec_t)tvSubMsec(q->sent_t, current_time) < (Config.Timeout.idns_retransmit * 1 << ((q->nsends - 1) / nns))) {
-            dlinkDelete(&q->lru, &lru_list);
-            q->queue_t = current_time;
-            dlinkAdd(q, &q->lru, &lru_list);
-            continue;
-        }
+        q = static_cast<idns_query*>(heap_peepmin(idns_deadlines));
 
         debugs(78, 3, "idnsCheckQueue: ID " << q->xact_id <<
                " QID 0x"  << std::hex << std::setfill('0')  <<
                std::setw(4) << q->query_id << ": timeout" );
 
-        dlinkDelete(&q->lru, &lru_list);
-        q->pending = 0;
+        idnsRemovePending(q);
 
         if ((time_msec_t)tvSubMsec(q->start_t, current_time) < Config.Timeout.idns_query) {
             idnsSendQuery(q);
@@ -1587,6 +1622,8 @@ dnsInit(void)
         memDataInit(MEM_IDNS_QUERY, "idns_query", sizeof(idns_query), 0);
         memset(RcodeMatrix, '\0', sizeof(RcodeMatrix));
         idns_lookup_hash = hash_create((HASHCMP *) strcmp, 103, hash_string);
+        idns_deadlines = new_heap(64, idnsDeadlineKey);
+        idns_pending = static_cast<idns_query **>(xcalloc(IDNS_QUERY_IDS, sizeof(idns_query *)));
         ++init;
     }
 
@@ -9,21 +9,29 @@
 /* DEBUG: section 41    Event Processing */
 
 #include "squid.h"
+#include "base/AsyncCallQueue.h"
 #include "compat/drand48.h"
 #include "event.h"
 #include "mgr/Registration.h"
 #include "profiler/Profiler.h"
 #include "SquidTime.h"
 #include "Store.h"
+#include "StoreEntryStream.h"
 #include "tools.h"
 
+#include <algorithm>
 #include <cmath>
 
 /* The list of event processes */
 
 static OBJH eventDump;
+static OBJH asyncCallsDump;
 static const char *last_event_ran = NULL;
 
+/// number of children of an EventScheduler::tasks heap node; a 4-ary heap
+/// is shallower than a binary one and keeps siblings next to each other
+static const size_t HeapArity = 4;
+
 // This AsyncCall dialer can be configured to check that the event cbdata is
 // valid before calling the event handler
 class EventDialer: public CallDialer
@@ -91,7 +99,7 @@ EventDialer::print(std::ostream &os) const
 ev_entry::ev_entry(char const * aName, EVH * aFunction, void * aArgument, double evWhen,
                    int aWeight, bool haveArgument) : name(aName), func(aFunction),
     arg(haveArgument ? cbdataReference(aArgument) : aArgument), when(evWhen), weight(aWeight),
-    cbdata(haveArgument)
+    cbdata(haveArgument), sequence(0), heapPos(0)
 {
 }
 
@@ -133,6 +141,7 @@ void
 eventInit(void)
 {
     Mgr::RegisterAction("events", "Event Queue", eventDump, 0, 1);
+    Mgr::RegisterAction("async_calls", "Async Call Queue Lanes", asyncCallsDump, 0, 1);
 }
 
 static void
@@ -141,6 +150,13 @@ eventDump(StoreEntry * sentry)
     EventScheduler::GetInstance()->dump(sentry);
 }
 
+static void
+asyncCallsDump(StoreEntry * sentry)
+{
+    StoreEntryStream stream(sentry);
+    AsyncCallQueue::Instance().dump(stream);
+}
+
 void
 eventFreeMemory(void)
 {
@@ -155,7 +171,7 @@ eventFind(EVH * func, void *arg)
 
 EventScheduler EventScheduler::_instance;
 
-EventScheduler::EventScheduler(): tasks(NULL)
+EventScheduler::EventScheduler(): lastSequence(0)
 {}
 
 EventScheduler::~EventScheduler()
@@ -163,40 +179,149 @@ EventScheduler::~EventScheduler()
     clean();
 }
 
+bool
+EventScheduler::Key::operator <(const Key &other) const
+{
+    if (func != other.func)
+        return std::less<EVH *>()(func, other.func);
+    return std::less<void *>()(arg, other.arg);
+}
+
+/// whether event a is due before event b
+bool
+EventScheduler::Before(const ev_entry *a, const ev_entry *b)
+{
+    if (a->when != b->when)
+        return a->when < b->when;
+    return a->sequence < b->sequence; // same-time events fire in submission order
+}
+
+/// stores the event at the given heap position
 void
-EventScheduler::cancel(EVH * func, void *arg)
+EventScheduler::place(ev_entry *event, size_t pos)
 {
-    ev_entry **E;
-    ev_entry *event;
+    tasks[pos] = event;
+    event->heapPos = pos;
+}
 
-    for (E = &tasks; (event = *E) != NULL; E = &(*E)->next) {
-        if (event->func != func)
-            continue;
+/// moves the event at pos towards the heap root until the heap is valid
+void
+EventScheduler::siftUp(size_t pos)
+{
+    ev_entry *event = tasks[pos];
+    while (pos > 0) {
+        const size_t parent = (pos - 1) / HeapArity;
+        if (!Before(event, tasks[parent]))
+            break;
+        place(tasks[parent], pos);
+        pos = parent;
+    }
+    place(event, pos);
+}
 
-        if (arg && event->arg != arg)
-            continue;
+/// moves the event at pos towards the heap leaves until the heap is valid
+void
+EventScheduler::siftDown(size_t pos)
+{
+    ev_entry *event = tasks[pos];
+    const size_t size = tasks.size();
+    for (;;) {
+        const size_t first = pos * HeapArity + 1;
+        if (first >= size)
+            break;
+        const size_t last = min(first + HeapArity, size);
+        size_t earliest = first;
+        for (size_t child = first + 1; child < last; ++child) {
+            if (Before(tasks[child], tasks[earliest]))
+                earliest = child;
+        }
+        if (!Before(tasks[earliest], event))
+            break;
+        place(tasks[earliest], pos);
+        pos = earliest;
+    }
+    place(event, pos);
+}
 
-        *E = event->next;
+/// adds a new event to the heap and the index
+void
+EventScheduler::push(ev_entry *event)
+{
+    event->sequence = ++lastSequence;
+    tasks.push_back(event);
+    siftUp(tasks.size() - 1);
+    index.insert(Index::value_type(Key(event->func, event->arg), event));
+}
 
-        delete event;
+/// removes the event from the heap but not from the index
+void
+EventScheduler::remove(ev_entry *event)
+{
+    const size_t pos = event->heapPos;
+    assert(pos < tasks.size() && tasks[pos] == event);
+
+    ev_entry *last = tasks.back();
+    tasks.pop_back();
+    if (last != event) {
+        place(last, pos);
+        siftUp(pos);
+        siftDown(last->heapPos);
+    }
+}
 
-        if (arg)
-            return;
-        /*
-         * DPW 2007-04-12
-         * Since this method may now delete multiple events (when
-         * arg is NULL) it no longer returns after a deletion and
-         * we have a potential NULL pointer problem.  If we just
-         * deleted the last event in the list then *E is now equal
-         * to NULL.  We need to break here or else we'll get a NULL
-         * pointer dereference in the last clause of the for loop.
-         */
-        if (NULL == *E)
+/// removes and returns the earliest event
+ev_entry *
+EventScheduler::pop()
+{
+    ev_entry *event = tasks.front();
+    remove(event);
+
+    std::pair<Index::iterator, Index::iterator> range =
+        index.equal_range(Key(event->func, event->arg));
+    for (Index::iterator i = range.first; i != range.second; ++i) {
+        if (i->second == event) {
+            index.erase(i);
             break;
+        }
+    }
+
+    return event;
+}
+
+/// forgets and destroys the indexed event
+void
+EventScheduler::erase(Index::iterator pos)
+{
+    ev_entry *event = pos->second;
+    index.erase(pos);
+    remove(event);
+    delete event;
+}
+
+void
+EventScheduler::cancel(EVH * func, void *arg)
+{
+    if (!arg) {
+        // cancel all events with the given handler
+        Index::iterator i = index.lower_bound(Key(func, NULL));
+        while (i != index.end() && i->first.func == func)
+            erase(i++);
+        return;
     }
 
-    if (arg)
+    // cancel the earliest event with the given handler and argument
+    std::pair<Index::iterator, Index::iterator> range = index.equal_range(Key(func, arg));
+    if (range.first == range.second) {
         debug_trap("eventDelete: event not found");
+        return;
+    }
+
+    Index::iterator earliest = range.first;
+    for (Index::iterator i = range.first; i != range.second; ++i) {
+        if (Before(i->second, earliest->second))
+            earliest = i;
+    }
+    erase(earliest);
 }
 
 // The event API does not guarantee exact timing, but guarantees that no event
@@ -204,13 +329,14 @@ EventScheduler::cancel(EVH * func, void *arg)
 int
 EventScheduler::timeRemaining() const
 {
-    if (!tasks)
+    if (tasks.empty())
         return EVENT_IDLE;
 
-    if (tasks->when <= current_dtime) // we are on time or late
+    const double when = tasks.front()->when;
+    if (when <= current_dtime) // we are on time or late
         return 0; // fire the event ASAP
 
-    const double diff = tasks->when - current_dtime; // microseconds
+    const double diff = when - current_dtime; // microseconds
     // Round UP: If we come back a nanosecond earlier, we will wait again!
     const int timeLeft = static_cast<int>(ceil(1000*diff)); // milliseconds
     // Avoid hot idle: A series of rapid select() calls with zero timeout.
@@ -228,19 +354,20 @@ EventScheduler::checkEvents(int timeout)
     PROF_start(eventRun);
 
     do {
-        ev_entry *event = tasks;
-        assert(event);
+        assert(!tasks.empty());
+        ev_entry *event = pop();
+
+        const bool heavy = event->weight &&
+                           (!event->cbdata || cbdataReferenceValid(event->arg));
 
         /* XXX assumes event->name is static memory! */
         AsyncCall::Pointer call = asyncCall(41,5, event->name,
                                             EventDialer(event->func, event->arg, event->cbdata));
+        call->lane = heavy ? AsyncCall::laneBackground : AsyncCall::laneTimer;
         ScheduleCallHere(call);
 
         last_event_ran = event->name; // XXX: move this to AsyncCallQueue
-        const bool heavy = event->weight &&
-                           (!event->cbdata || cbdataReferenceValid(event->arg));
 
-        tasks = event->next;
         delete event;
 
         result = timeRemaining();
@@ -258,20 +385,17 @@ EventScheduler::checkEvents(int timeout)
 void
 EventScheduler::clean()
 {
-    while (ev_entry * event = tasks) {
-        tasks = event->next;
-        delete event;
-    }
+    index.clear();
 
-    tasks = NULL;
+    for (std::vector<ev_entry *>::iterator i = tasks.begin(); i != tasks.end(); ++i)
+        delete *i;
+
+    tasks.clear();
 }
 
 void
 EventScheduler::dump(StoreEntry * sentry)
 {
-
-    ev_entry *e = tasks;
-
     if (last_event_ran)
         storeAppendPrintf(sentry, "Last event to run: %s\n\n", last_event_ran);
 
@@ -281,26 +405,22 @@ EventScheduler::dump(StoreEntry * sentry)
                       "Weight",
                       "Callback Valid?");
 
-    while (e != NULL) {
+    // the heap is only partially ordered
+    std::vector<ev_entry *> sorted(tasks);
+    std::sort(sorted.begin(), sorted.end(), Before);
+
+    for (std::vector<ev_entry *>::const_iterator i = sorted.begin(); i != sorted.end(); ++i) {
+        const ev_entry *e = *i;
         storeAppendPrintf(sentry, "%-25s\t%0.3f sec\t%5d\t %s\n",
                           e->name, e->when ? e->when - current_dtime : 0, e->weight,
                           (e->arg && e->cbdata) ? cbdataReferenceValid(e->arg) ? "yes" : "no" : "N/A");
-        e = e->next;
     }
 }
 
 bool
 EventScheduler::find(EVH * func, void * arg)
 {
-
-    ev_entry *event;
-
-    for (event = tasks; event != NULL; event = event->next) {
-        if (event->func == func && event->arg == arg)
-            return true;
-    }
-
-    return false;
+    return index.find(Key(func, arg)) != index.end();
 }
 
 EventScheduler *
@@ -318,16 +438,7 @@ EventScheduler::schedule(const char *name, EVH * func, void *arg, double when, i
     const double timestamp = when > 0.0 ? current_dtime + when : 0;
     ev_entry *event = new ev_entry(name, func, arg, timestamp, weight, cbdata);
 
-    ev_entry **E;
     debugs(41, 7, HERE << "schedule: Adding '" << name << "', in " << when << " seconds");
-    /* Insert after the last event with the same or earlier time */
-
-    for (E = &tasks; *E; E = &(*E)->next) {
-        if ((*E)->when > event->when)
-            break;
-    }
-
-    event->next = *E;
-    *E = event;
+    push(event);
 }
 
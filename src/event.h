@@ -12,6 +12,9 @@
 #include "AsyncEngine.h"
 #include "MemPool.h"
 
+#include <map>
+#include <vector>
+
 class StoreEntry;
 
 /* event scheduling facilities - run a callback after a given time period. */
@@ -40,7 +43,10 @@ public:
     int weight;
     bool cbdata;
 
-    ev_entry *next;
+    /// scheduling order among events with the same due time
+    uint64_t sequence;
+    /// position in EventScheduler::tasks
+    size_t heapPos;
 };
 
 MEMPROXY_CLASS_INLINE(ev_entry);
@@ -68,8 +74,35 @@ public:
     static EventScheduler *GetInstance();
 
 private:
+    /// (handler, argument) pair identifying scheduled events
+    class Key
+    {
+    public:
+        Key(EVH *aFunc, void *anArg): func(aFunc), arg(anArg) {}
+        bool operator <(const Key &other) const;
+
+        EVH *func;
+        void *arg;
+    };
+    typedef std::multimap<Key, ev_entry *> Index;
+
+    static bool Before(const ev_entry *a, const ev_entry *b);
+
+    void push(ev_entry *event);
+    ev_entry *pop();
+    void remove(ev_entry *event);
+    void erase(Index::iterator pos);
+    void siftUp(size_t pos);
+    void siftDown(size_t pos);
+    void place(ev_entry *event, size_t pos);
+
     static EventScheduler _instance;
-    ev_entry * tasks;
+    /// pending events as a d-ary min-heap ordered by due time and sequence
+    std::vector<ev_entry *> tasks;
+    /// pending events by handler and argument, for cancel() and find()
+    Index index;
+    /// sequence number of the last scheduled event
+    uint64_t lastSequence;
 };
 
 #endif /* SQUID_EVENT_H */
@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "acl/Acl.h"
 #include "acl/FilledChecklist.h"
+#include "base/RunnersRegistry.h"
 #include "cache_cf.h"
 #include "client_side.h"
 #include "comm/Connection.h"
@@ -25,6 +26,7 @@
 #include "HttpReply.h"
 #include "HttpRequest.h"
 #include "ip/tools.h"
+#include "ipc/SharedCache.h"
 #include "MemBuf.h"
 #include "mgr/Registration.h"
 #include "rfc1738.h"
@@ -48,6 +50,8 @@
 #include "ident/AclIdent.h"
 #endif
 
+#include <map>
+
 #ifndef DEFAULT_EXTERNAL_ACL_TTL
 #define DEFAULT_EXTERNAL_ACL_TTL 1 * 60 * 60
 #endif
@@ -61,6 +65,8 @@ static int external_acl_entry_expired(external_acl * def, const ExternalACLEntry
 static int external_acl_grace_expired(external_acl * def, const ExternalACLEntryPointer &entry);
 static void external_acl_cache_touch(external_acl * def, const ExternalACLEntryPointer &entry);
 static ExternalACLEntryPointer external_acl_cache_add(external_acl * def, const char *key, ExternalACLEntryData const &data);
+static ExternalACLEntryPointer external_acl_cache_find_shared(external_acl * def, const char *key, const ExternalACLEntryPointer &cached);
+static void external_acl_cache_share(external_acl * def, const ExternalACLEntryPointer &entry);
 
 /******************************************************************
  * external_acl directive
@@ -88,6 +94,27 @@ public:
 
 MEMPROXY_CLASS_INLINE(external_acl_format);
 
+/// a helper result as stored in the shared cache
+class ExternalACLSharedResult
+{
+public:
+    ExternalACLSharedResult(): expires(0), negative(false), date(0), size(0) {
+        notes[0] = '\0';
+    }
+
+    /// the maximum size of all notes; results with more notes are not shared
+    static const size_t DataSize = 512;
+
+    time_t expires; ///< when the result becomes stale
+    bool negative; ///< whether the helper has denied access
+    time_t date; ///< when the helper has replied
+    uint16_t size; ///< the number of used notes bytes
+    char notes[DataSize]; ///< the helper kv-pairs, as name\0value\0 sequences
+};
+
+/// helper results shared by all SMP workers (see Ipc::SharedCache)
+typedef Ipc::SharedCache<ExternalACLSharedResult> ExternalACLSharedCache;
+
 class external_acl
 {
 
@@ -124,6 +151,15 @@ public:
 
     dlink_list queue;
 
+    /// the maximum number of results shared with other SMP workers
+    int cache_shared;
+
+    /// results shared with other SMP workers or nil
+    ExternalACLSharedCache *sharedCache;
+
+    /// whether to pack lookups started together into one helper write
+    bool pipeline;
+
 #if USE_AUTH
     /**
      * Configuration flag. May only be altered by the configuration parser.
@@ -271,6 +307,10 @@ parse_externalAclHelper(external_acl ** list)
             a->children.concurrency = atoi(token + 12);
         } else if (strncmp(token, "cache=", 6) == 0) {
             a->cache_size = atoi(token + 6);
+        } else if (strncmp(token, "cache_shared=", 13) == 0) {
+            a->cache_shared = atoi(token + 13);
+        } else if (strcmp(token, "pipeline") == 0) {
+            a->pipeline = true;
         } else if (strncmp(token, "grace=", 6) == 0) {
             a->grace = atoi(token + 6);
         } else if (strcmp(token, "protocol=2.5") == 0) {
@@ -486,6 +526,12 @@ dump_externalAclHelper(StoreEntry * sentry, const char *name, const external_acl
         if (node->cache)
             storeAppendPrintf(sentry, " cache=%d", node->cache_size);
 
+        if (node->cache_shared)
+            storeAppendPrintf(sentry, " cache_shared=%d", node->cache_shared);
+
+        if (node->pipeline)
+            storeAppendPrintf(sentry, " pipeline");
+
         if (node->quote == external_acl::QUOTE_METHOD_SHELL)
             storeAppendPrintf(sentry, " protocol=2.5");
 
@@ -719,6 +765,33 @@ copyResultsFromEntry(HttpRequest *req, const ExternalACLEntryPointer &entry)
     }
 }
 
+/// sets the entry fields that Squid extracts from the helper kv-pairs
+static void
+copyFieldsFromNotes(ExternalACLEntryData &entryData)
+{
+    const char *label = entryData.notes.findFirst("tag");
+    if (label != NULL && *label != '\0')
+        entryData.tag = label;
+
+    label = entryData.notes.findFirst("message");
+    if (label != NULL && *label != '\0')
+        entryData.message = label;
+
+    label = entryData.notes.findFirst("log");
+    if (label != NULL && *label != '\0')
+        entryData.log = label;
+
+#if USE_AUTH
+    label = entryData.notes.findFirst("user");
+    if (label != NULL && *label != '\0')
+        entryData.user = label;
+
+    label = entryData.notes.findFirst("password");
+    if (label != NULL && *label != '\0')
+        entryData.password = label;
+#endif
+}
+
 static allow_t
 aclMatchExternal(external_acl_data *acl, ACLFilledChecklist *ch)
 {
@@ -773,6 +846,10 @@ aclMatchExternal(external_acl_data *acl, ACLFilledChecklist *ch)
 
         entry = static_cast<ExternalACLEntry *>(hash_lookup(acl->def->cache, key));
 
+        // another worker may have a fresher result
+        if (acl->def->sharedCache && (entry == NULL || external_acl_grace_expired(acl->def, entry)))
+            entry = external_acl_cache_find_shared(acl->def, key, entry);
+
         const ExternalACLEntryPointer staleEntry = entry;
         if (entry != NULL && external_acl_entry_expired(acl->def, entry))
             entry = NULL;
@@ -1294,6 +1371,68 @@ external_acl_cache_delete(external_acl * def, const ExternalACLEntryPointer &ent
     def->cache_entries -= 1;
 }
 
+static ExternalACLEntryPointer
+external_acl_cache_find_shared(external_acl * def, const char *key, const ExternalACLEntryPointer &cached)
+{
+    ExternalACLSharedResult value;
+    if (!def->sharedCache->get(key, value))
+        return cached;
+
+    if (cached != NULL && cached->date >= value.date)
+        return cached; // we already have the shared result or a newer one
+
+    ExternalACLEntryData data;
+    data.result = value.negative ? ACCESS_DENIED : ACCESS_ALLOWED;
+    for (size_t pos = 0; pos < value.size;) {
+        const char *name = value.notes + pos;
+        pos += strlen(name) + 1;
+        const char *noteValue = value.notes + pos;
+        pos += strlen(noteValue) + 1;
+        data.notes.add(name, noteValue);
+    }
+    copyFieldsFromNotes(data);
+
+    debugs(82, 3, "using '" << key << "' = " << data.result << " shared by another worker");
+    ExternalACLEntryPointer entry = external_acl_cache_add(def, key, data);
+    // keep the original reply time so that ttl and grace work as in that worker
+    entry->date = value.date;
+    return entry;
+}
+
+static void
+external_acl_cache_share(external_acl * def, const ExternalACLEntryPointer &entry)
+{
+    if (!def->sharedCache)
+        return;
+
+    ExternalACLSharedResult value;
+    value.negative = entry->result != ACCESS_ALLOWED;
+    const int ttl = value.negative ? def->negative_ttl : def->ttl;
+    if (ttl <= 0)
+        return; // not cached locally either
+
+    value.date = entry->date;
+    value.expires = entry->date + ttl;
+
+    typedef std::vector<NotePairs::Entry *>::const_iterator NEI;
+    for (NEI i = entry->notes.entries.begin(); i != entry->notes.entries.end(); ++i) {
+        const size_t nameSize = (*i)->name.size() + 1;
+        const size_t valueSize = (*i)->value.size() + 1;
+        if (value.size + nameSize + valueSize > ExternalACLSharedResult::DataSize) {
+            debugs(82, 3, "too many notes to share '" << static_cast<const char *>(entry->key) << "'");
+            return;
+        }
+        memcpy(value.notes + value.size, (*i)->name.rawBuf(), nameSize - 1);
+        value.notes[value.size + nameSize - 1] = '\0';
+        value.size += nameSize;
+        memcpy(value.notes + value.size, (*i)->value.rawBuf(), valueSize - 1);
+        value.notes[value.size + valueSize - 1] = '\0';
+        value.size += valueSize;
+    }
+
+    def->sharedCache->put(static_cast<const char *>(entry->key), value);
+}
+
 /******************************************************************
  * external_acl helpers
  */
@@ -1358,41 +1497,24 @@ externalAclHandleReply(void *data, const Helper::Reply &reply)
     // XXX: make entryData store a proper Helper::Reply object instead of copying.
 
     entryData.notes.append(&reply.notes);
-
-    const char *label = reply.notes.findFirst("tag");
-    if (label != NULL && *label != '\0')
-        entryData.tag = label;
-
-    label = reply.notes.findFirst("message");
-    if (label != NULL && *label != '\0')
-        entryData.message = label;
-
-    label = reply.notes.findFirst("log");
-    if (label != NULL && *label != '\0')
-        entryData.log = label;
-
-#if USE_AUTH
-    label = reply.notes.findFirst("user");
-    if (label != NULL && *label != '\0')
-        entryData.user = label;
-
-    label = reply.notes.findFirst("password");
-    if (label != NULL && *label != '\0')
-        entryData.password = label;
-#endif
+    copyFieldsFromNotes(entryData);
 
     dlinkDelete(&state->list, &state->def->queue);
 
     ExternalACLEntryPointer entry;
     if (cbdataReferenceValid(state->def)) {
         // only cache OK and ERR results.
-        if (reply.result == Helper::Okay || reply.result == Helper::Error)
+        if (reply.result == Helper::Okay || reply.result == Helper::Error) {
             entry = external_acl_cache_add(state->def, state->key, entryData);
-        else {
+            external_acl_cache_share(state->def, entry);
+        } else {
             const ExternalACLEntryPointer oldentry = static_cast<ExternalACLEntry *>(hash_lookup(state->def->cache, state->key));
 
             if (oldentry != NULL)
                 external_acl_cache_delete(state->def, oldentry);
+
+            if (state->def->sharedCache)
+                state->def->sharedCache->forget(state->key);
         }
     }
 
@@ -1495,6 +1617,81 @@ ExternalACLLookup::Start(ACLChecklist *checklist, external_acl_data *acl, bool i
            "' in '" << def->name << "' (ch=" << ch << ").");
 }
 
+/// shared result caches attached at startup, by external_acl_type name
+typedef std::map<SBuf, ExternalACLSharedCache *> ExternalACLSharedCaches;
+static ExternalACLSharedCaches TheSharedCaches;
+
+/// whether the external_acl_type results should be shared with other workers
+static bool
+externalAclSharesResults(const external_acl *def)
+{
+    return def->cache_shared > 0 && def->cache_size > 0 && UsingSmp();
+}
+
+/// the shared memory segment name for the external_acl_type results
+static SBuf
+externalAclSharedCacheName(const external_acl *def)
+{
+    SBuf name("external_acl_");
+    name.append(def->name);
+    return name;
+}
+
+/// attaches to the shared result cache of the external_acl_type, if any
+static void
+externalAclAttachSharedCache(external_acl *def, const bool startup)
+{
+    def->sharedCache = NULL;
+    if (!externalAclSharesResults(def) || !IamWorkerProcess())
+        return;
+
+    SBuf name = externalAclSharedCacheName(def);
+    const ExternalACLSharedCaches::const_iterator i = TheSharedCaches.find(name);
+    if (i != TheSharedCaches.end()) {
+        def->sharedCache = i->second;
+    } else if (startup) {
+        def->sharedCache = new ExternalACLSharedCache(name.c_str());
+        TheSharedCaches[name] = def->sharedCache;
+    } else {
+        // the master creates segments at startup only
+        debugs(82, DBG_IMPORTANT, "WARNING: external ACL '" << def->name <<
+               "' results will not be shared until Squid is restarted");
+    }
+}
+
+/// initializes shared memory segments used by external ACL result caches
+class ExternalAclSharedCacheRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    virtual ~ExternalAclSharedCacheRr();
+
+protected:
+    virtual void create();
+
+private:
+    std::vector<ExternalACLSharedCache::Owner *> owners;
+};
+
+RunnerRegistrationEntry(ExternalAclSharedCacheRr);
+
+void
+ExternalAclSharedCacheRr::create()
+{
+    for (const external_acl *p = Config.externalAclHelperList; p; p = p->next) {
+        if (externalAclSharesResults(p))
+            owners.push_back(ExternalACLSharedCache::Init(externalAclSharedCacheName(p).c_str(), p->cache_shared));
+    }
+}
+
+ExternalAclSharedCacheRr::~ExternalAclSharedCacheRr()
+{
+    while (!owners.empty()) {
+        delete owners.back();
+        owners.pop_back();
+    }
+}
+
 static void
 externalAclStats(StoreEntry * sentry)
 {
@@ -1503,6 +1700,8 @@ externalAclStats(StoreEntry * sentry)
     for (p = Config.externalAclHelperList; p; p = p->next) {
         storeAppendPrintf(sentry, "External ACL Statistics: %s\n", p->name);
         storeAppendPrintf(sentry, "Cache size: %d\n", p->cache->count);
+        if (p->sharedCache)
+            p->sharedCache->stat(*sentry);
         helperStats(sentry, p->theHelper);
         storeAppendPrintf(sentry, "\n");
     }
@@ -1537,6 +1736,10 @@ externalAclInit(void)
 
         p->theHelper->addr = p->local_addr;
 
+        p->theHelper->pipeline = p->pipeline;
+
+        externalAclAttachSharedCache(p, firstTimeInit);
+
         helperOpenServers(p->theHelper);
     }
 
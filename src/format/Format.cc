@@ -722,7 +722,7 @@ Format::Format::assemble(MemBuf &mb, const AccessLogEntry::Pointer &al, int logS
             if (al->icap.request) {
                 HttpHeaderPos pos = HttpHeaderInitPos;
                 while (const HttpHeaderEntry *e = al->icap.request->header.getEntry(&pos)) {
-                    sb.append(e->name);
+                    sb.append(e->name.rawContent(), e->name.length());
                     sb.append(": ");
                     sb.append(e->value);
                     sb.append("\r\n");
@@ -754,7 +754,7 @@ Format::Format::assemble(MemBuf &mb, const AccessLogEntry::Pointer &al, int logS
             if (al->icap.reply) {
                 HttpHeaderPos pos = HttpHeaderInitPos;
                 while (const HttpHeaderEntry *e = al->icap.reply->header.getEntry(&pos)) {
-                    sb.append(e->name);
+                    sb.append(e->name.rawContent(), e->name.length());
                     sb.append(": ");
                     sb.append(e->value);
                     sb.append("\r\n");
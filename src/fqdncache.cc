@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "cbdata.h"
 #include "DnsLookupDetails.h"
+#include "DnsSharedCache.h"
 #include "event.h"
 #include "helper.h"
 #include "Mem.h"
@@ -20,6 +21,7 @@
 #include "SquidTime.h"
 #include "StatCounters.h"
 #include "Store.h"
+#include "tools.h"
 #include "wordlist.h"
 
 #if SQUID_SNMP
@@ -127,6 +129,10 @@ static void fqdncacheAddEntry(fqdncache_entry * f);
 /// \ingroup FQDNCacheInternal
 static hash_table *fqdn_table = NULL;
 
+/// \ingroup FQDNCacheInternal
+/// answers shared with other SMP workers; nil unless dns_cache_shared is on
+static DnsSharedCache *SharedFqdncache = NULL;
+
 /// \ingroup FQDNCacheInternal
 static long fqdncache_low = 180;
 
@@ -387,6 +393,59 @@ fqdncacheParse(fqdncache_entry *f, const rfc1035_rr * answers, int nr, const cha
     return f->name_count;
 }
 
+/// \ingroup FQDNCacheInternal
+/// makes a DNS answer available to other SMP workers
+static void
+fqdncacheShare(const fqdncache_entry *f)
+{
+    if (!SharedFqdncache || f->flags.fromhosts)
+        return;
+
+    DnsSharedAnswer answer;
+    answer.expires = f->expires;
+    answer.negative = f->flags.negcached;
+    if (f->error_message)
+        xstrncpy(answer.error, f->error_message, sizeof(answer.error));
+
+    // the names, each with its terminating zero, as long as they fit
+    for (int k = 0; k < f->name_count; ++k) {
+        const size_t len = strlen(f->names[k]) + 1;
+        if (answer.size + len > sizeof(answer.data))
+            break;
+        memcpy(answer.data + answer.size, f->names[k], len);
+        answer.size += len;
+        ++answer.count;
+    }
+
+    SharedFqdncache->put(static_cast<const char *>(f->hash.key), answer);
+}
+
+/// \ingroup FQDNCacheInternal
+/// adds an entry with the answer another SMP worker got for the address, if any
+static fqdncache_entry *
+fqdncacheFromShared(const char *name)
+{
+    DnsSharedAnswer answer;
+    if (!SharedFqdncache || !SharedFqdncache->get(name, answer))
+        return NULL;
+
+    fqdncache_entry *f = fqdncacheCreateEntry(name);
+    f->expires = answer.expires;
+    f->flags.negcached = answer.negative;
+    if (answer.error[0])
+        f->error_message = xstrdup(answer.error);
+
+    const char *item = answer.data;
+    for (int k = 0; k < answer.count && k < FQDN_MAX_NAMES; ++k) {
+        f->names[k] = xstrdup(item);
+        item += strlen(item) + 1;
+        ++f->name_count;
+    }
+
+    fqdncacheAddEntry(f);
+    return f;
+}
+
 /**
  \ingroup FQDNCacheAPI
  *
@@ -401,6 +460,7 @@ fqdncacheHandleReply(void *data, const rfc1035_rr * answers, int na, const char
     const int age = f->age();
     statCounter.dns.svcTime.count(age);
     fqdncacheParse(f, answers, na, error_message);
+    fqdncacheShare(f);
     fqdncacheAddEntry(f);
     fqdncacheCallback(f, age);
 }
@@ -442,7 +502,14 @@ fqdncache_nbgethostbyaddr(const Ip::Address &addr, FQDNH * handler, void *handle
         /* hit, but expired -- bummer */
         fqdncacheRelease(f);
         f = NULL;
-    } else {
+    }
+
+    if (NULL == f) {
+        /* another SMP worker may have resolved the address already */
+        f = fqdncacheFromShared(name);
+    }
+
+    if (NULL != f) {
         /* hit */
         debugs(35, 4, "fqdncache_nbgethostbyaddr: HIT for '" << name << "'");
 
@@ -496,11 +563,16 @@ fqdncache_gethostbyaddr(const Ip::Address &addr, int flags)
     ++ FqdncacheStats.requests;
     f = fqdncache_get(name);
 
-    if (NULL == f) {
-        (void) 0;
-    } else if (fqdncacheExpiredEntry(f)) {
+    if (NULL != f && fqdncacheExpiredEntry(f)) {
         fqdncacheRelease(f);
         f = NULL;
+    }
+
+    if (NULL == f)
+        f = fqdncacheFromShared(name);
+
+    if (NULL == f) {
+        (void) 0;
     } else if (f->flags.negcached) {
         ++ FqdncacheStats.negative_hits;
         // ignore f->error_message: the caller just checks FQDN cache presence
@@ -558,6 +630,9 @@ fqdnStats(StoreEntry * sentry)
     storeAppendPrintf(sentry, "FQDNcache Misses: %d\n",
                       FqdncacheStats.misses);
 
+    if (SharedFqdncache)
+        SharedFqdncache->stat(*sentry);
+
     storeAppendPrintf(sentry, "FQDN Cache Contents:\n\n");
 
     storeAppendPrintf(sentry, "%-45.45s %3s %3s %3s %s\n",
@@ -626,6 +701,8 @@ fqdncacheFreeMemory(void)
     hashFreeItems(fqdn_table, fqdncacheFreeEntry);
     hashFreeMemory(fqdn_table);
     fqdn_table = NULL;
+    delete SharedFqdncache;
+    SharedFqdncache = NULL;
 }
 
 /**
@@ -735,6 +812,9 @@ fqdncache_init(void)
 
     memDataInit(MEM_FQDNCACHE_ENTRY, "fqdncache_entry",
                 sizeof(fqdncache_entry), 0);
+
+    if (DnsSharedCache::Enabled() && IamWorkerProcess() && Config.fqdncache.size > 0)
+        SharedFqdncache = new DnsSharedCache(DnsSharedCache::FqdncacheName);
 }
 
 #if SQUID_SNMP
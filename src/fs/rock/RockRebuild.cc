@@ -637,12 +637,30 @@ Rock::Rebuild::useNewSlot(const SlotId slotId, const DbCellHeader &header)
     const cache_key *const key =
         reinterpret_cast<const cache_key*>(header.key);
     const sfileno fileno = sd->map->anchorIndexByKey(key);
-    assert(0 <= fileno && fileno < dbEntryLimit);
+    if (fileno < 0) {
+        // all ways of the key bucket are taken by other entries; the
+        // from-disk entries got there first and are as good as this one
+        debugs(47,8, "no map room for slot " << slotId << ", inode: " <<
+               header.firstSlot);
+        freeSlotIfIdle(slotId, false);
+        ++counts.clashcount;
+        return;
+    }
+    assert(fileno < dbEntryLimit);
 
     LoadingEntry &le = entries[fileno];
     debugs(47,9, "entry " << fileno << " state: " << le.state << ", inode: " <<
            header.firstSlot << ", size: " << header.payloadSize);
 
+    // A corrupted way without our key is empty because its entry was freed.
+    // Its corruption concerns another key, so let our entry use that way.
+    if (le.state == LoadingEntry::leCorrupted && !sd->map->peekAtEntry(fileno).sameKey(key)) {
+        le.size = 0;
+        le.version = 0;
+        le.state = LoadingEntry::leEmpty;
+        le.anchored = 0;
+    }
+
     switch (le.state) {
 
     case LoadingEntry::leEmpty: {
@@ -40,7 +40,7 @@ const int64_t Rock::SwapDir::HeaderSize = 16*1024;
 
 Rock::SwapDir::SwapDir(): ::SwapDir("rock"),
     slotSize(HeaderSize), filePath(NULL), map(NULL), io(NULL),
-    waitingForPage(NULL)
+    waitingForPage(NULL), eviction(Ipc::StoreMap::epClock)
 {
 }
 
@@ -322,6 +322,7 @@ Rock::SwapDir::init()
     Must(!map);
     map = new DirMap(inodeMapPath());
     map->cleaner = this;
+    map->evictionPolicy(eviction);
 
     const char *ioModule = needsDiskStrand() ? "IpcIo" : "Blocking";
     if (DiskIOModule *m = DiskIOModule::Find(ioModule)) {
@@ -410,6 +411,7 @@ Rock::SwapDir::getOptionTree() const
     vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseSizeOption, &SwapDir::dumpSizeOption));
     vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseTimeOption, &SwapDir::dumpTimeOption));
     vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseRateOption, &SwapDir::dumpRateOption));
+    vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseEvictionOption, &SwapDir::dumpEvictionOption));
     return vector;
 }
 
@@ -554,6 +556,45 @@ Rock::SwapDir::dumpSizeOption(StoreEntry * e) const
     storeAppendPrintf(e, " slot-size=%" PRId64, slotSize);
 }
 
+/// parses the eviction policy option; mimics ::SwapDir::optionObjectSizeParse()
+bool
+Rock::SwapDir::parseEvictionOption(char const *option, const char *value, int reconfig)
+{
+    if (strcmp(option, "eviction") != 0)
+        return false;
+
+    if (!value)
+        self_destruct();
+
+    Ipc::StoreMap::EvictionPolicy newPolicy;
+    if (strcmp(value, "clock") == 0)
+        newPolicy = Ipc::StoreMap::epClock;
+    else if (strcmp(value, "fifo") == 0)
+        newPolicy = Ipc::StoreMap::epFifo;
+    else {
+        debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option << " must be clock or fifo but is: " << value);
+        self_destruct();
+        return false;
+    }
+
+    if (!reconfig)
+        eviction = newPolicy;
+    else if (eviction != newPolicy) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+               << " cannot be changed dynamically, value left unchanged: " <<
+               Ipc::StoreMap::EvictionPolicyName(eviction));
+    }
+
+    return true;
+}
+
+/// reports the eviction policy option; mimics ::SwapDir::optionObjectSizeDump()
+void
+Rock::SwapDir::dumpEvictionOption(StoreEntry * e) const
+{
+    storeAppendPrintf(e, " eviction=%s", Ipc::StoreMap::EvictionPolicyName(eviction));
+}
+
 /// check the results of the configuration; only level-0 debugging works here
 void
 Rock::SwapDir::validateOptions()
@@ -996,6 +1037,9 @@ Rock::SwapDir::statfs(StoreEntry &e) const
             map->updateStats(stats);
             stats.dump(e);
         }
+        storeAppendPrintf(&e, "Eviction policy: %s\n",
+                          Ipc::StoreMap::EvictionPolicyName(map->evictionPolicy()));
+        map->probeStats().dump(e);
     }
 
     storeAppendPrintf(&e, "Pending operations: %d out of %d\n",
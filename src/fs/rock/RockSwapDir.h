@@ -111,6 +111,8 @@ protected:
     void dumpRateOption(StoreEntry * e) const;
     bool parseSizeOption(char const *option, const char *value, int reconfiguring);
     void dumpSizeOption(StoreEntry * e) const;
+    bool parseEvictionOption(char const *option, const char *value, int reconfiguring);
+    void dumpEvictionOption(StoreEntry * e) const;
 
     void rebuild(); ///< starts loading and validating stored entry metadata
 
@@ -138,6 +140,7 @@ private:
 
     /* configurable options */
     DiskFile::Config fileConfig; ///< file-level configuration options
+    Ipc::StoreMap::EvictionPolicy eviction; ///< how map purges entries
 
     static const int64_t HeaderSize; ///< on-disk db header size
 };
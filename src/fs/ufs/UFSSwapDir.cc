@@ -554,6 +554,19 @@ Fs::Ufs::UFSSwapDir::openStoreIO(StoreEntry &e, StoreIOState::STFNCB * file_call
     return IO->open (this, &e, file_callback, aCallback, callback_data);
 }
 
+int
+Fs::Ufs::UFSSwapDir::openContiguous(const StoreEntry &e)
+{
+    // We open synchronously, from the main loop. That is what the Blocking
+    // engine does for every swap in, but threaded and daemon engines exist
+    // to keep such disk waits out of the main loop.
+    if (strcmp(ioType, "Blocking") != 0)
+        return -1;
+
+    // each entry has a file of its own
+    return file_open(fullPath(e.swap_filen, NULL), O_RDONLY | O_BINARY);
+}
+
 int
 Fs::Ufs::UFSSwapDir::mapBitTest(sfileno filn)
 {
@@ -78,6 +78,7 @@ public:
     virtual bool dereference(StoreEntry &, bool);
     virtual StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STFNCB *, StoreIOState::STIOCB *, void *);
     virtual StoreIOState::Pointer openStoreIO(StoreEntry &, StoreIOState::STFNCB *, StoreIOState::STIOCB *, void *);
+    virtual int openContiguous(const StoreEntry &);
     virtual void openLog();
     virtual void closeLog();
     virtual int writeCleanStart();
@@ -14,6 +14,7 @@
 #include "comm/Connection.h"
 #include "comm/Read.h"
 #include "comm/Write.h"
+#include "event.h"
 #include "fd.h"
 #include "fde.h"
 #include "format/Quoting.h"
@@ -50,14 +51,19 @@ static void Enqueue(helper * hlp, Helper::Request *);
 static Helper::Request *Dequeue(helper * hlp);
 static Helper::Request *StatefulDequeue(statefulhelper * hlp);
 static helper_server *GetFirstAvailable(helper * hlp);
+static heap_key helperServerLoad(heap_t data, heap_key);
+static void helperForgetLoad(helper_server *srv);
 static helper_stateful_server *StatefulGetFirstAvailable(statefulhelper * hlp);
-static void helperDispatch(helper_server * srv, Helper::Request * r);
+static void helperDispatch(helper_server * srv, Helper::Request * r, const bool writeNow = true);
+static void helperWriteQueued(helper_server * srv);
+static EVH helperDispatchBatch;
 static void helperStatefulDispatch(helper_stateful_server * srv, Helper::Request * r);
 static void helperKickQueue(helper * hlp);
 static void helperStatefulKickQueue(statefulhelper * hlp);
 static void helperStatefulServerDone(helper_stateful_server * srv);
 static void StatefulEnqueue(statefulhelper * hlp, Helper::Request * r);
 static bool helperStartStats(StoreEntry *sentry, void *hlp, const char *label);
+static void helperTimesStats(StoreEntry *sentry, const helper *hlp);
 
 CBDATA_CLASS_INIT(helper);
 CBDATA_CLASS_INIT(helper_server);
@@ -213,6 +219,7 @@ helperOpenServers(helper * hlp)
         srv->requests = (Helper::Request **)xcalloc(hlp->childs.concurrency ? hlp->childs.concurrency : 1, sizeof(*srv->requests));
         srv->parent = cbdataReference(hlp);
         dlinkAddTail(srv, &srv->link, &hlp->servers);
+        srv->loadNode = heap_insert(hlp->loads, srv);
 
         if (rfd == wfd) {
             snprintf(fd_note_buf, FD_DESC_SZ, "%s #%d", shortname, k + 1);
@@ -376,9 +383,18 @@ helperSubmit(helper * hlp, const char *buf, HLPCB * callback, void *data)
     }
 
     Helper::Request *r = new Helper::Request(callback, data, buf);
+    r->submit_time = current_time;
     helper_server *srv;
 
-    if ((srv = GetFirstAvailable(hlp)))
+    if (hlp->pipeline && hlp->childs.concurrency > 1) {
+        // wait for other requests made during this main loop iteration
+        dlink_node *link = (dlink_node *)memAllocate(MEM_DLINK_NODE);
+        dlinkAddTail(r, link, &hlp->batch);
+        if (!hlp->batchScheduled) {
+            eventAdd("helperDispatchBatch", helperDispatchBatch, hlp, 0.0, 0, true);
+            hlp->batchScheduled = true;
+        }
+    } else if ((srv = GetFirstAvailable(hlp)))
         helperDispatch(srv, r);
     else
         Enqueue(hlp, r);
@@ -398,6 +414,7 @@ helperStatefulSubmit(statefulhelper * hlp, const char *buf, HLPCB * callback, vo
     }
 
     Helper::Request *r = new Helper::Request(callback, data, buf);
+    r->submit_time = current_time;
 
     if ((buf != NULL) && lastserver) {
         debugs(84, 5, "StatefulSubmit with lastserver " << lastserver);
@@ -503,6 +520,8 @@ helperStats(StoreEntry * sentry, helper * hlp, const char *label)
     storeAppendPrintf(sentry, "   W = WRITING\n");
     storeAppendPrintf(sentry, "   C = CLOSING\n");
     storeAppendPrintf(sentry, "   S = SHUTDOWN PENDING\n");
+
+    helperTimesStats(sentry, hlp);
 }
 
 void
@@ -560,6 +579,8 @@ helperStatefulStats(StoreEntry * sentry, statefulhelper * hlp, const char *label
     storeAppendPrintf(sentry, "   R = RESERVED\n");
     storeAppendPrintf(sentry, "   S = SHUTDOWN PENDING\n");
     storeAppendPrintf(sentry, "   P = PLACEHOLDER\n");
+
+    helperTimesStats(sentry, hlp);
 }
 
 void
@@ -580,6 +601,7 @@ helperShutdown(helper * hlp)
         assert(hlp->childs.n_active > 0);
         -- hlp->childs.n_active;
         srv->flags.shutdown = true; /* request it to shut itself down */
+        helperForgetLoad(srv);
 
         if (srv->flags.closing) {
             debugs(84, 3, "helperShutdown: " << hlp->id_name << " #" << srv->index << " is CLOSING.");
@@ -646,12 +668,41 @@ helperStatefulShutdown(statefulhelper * hlp)
     }
 }
 
+helper::helper(const char *name) :
+    cmdline(NULL),
+    id_name(name),
+    ipc_type(0),
+    last_queue_warn(0),
+    last_restart(0),
+    eom('\n'),
+    pipeline(false),
+    batchScheduled(false),
+    loads(new_heap(16, helperServerLoad))
+{
+    memset(&stats, 0, sizeof(stats));
+    queueTimes.logInit(100, 0.0, 3600000.0);
+    serviceTimes.logInit(100, 0.0, 3600000.0);
+}
+
 helper::~helper()
 {
     /* note, don't free id_name, it probably points to static memory */
 
     if (queue.head)
         debugs(84, DBG_CRITICAL, "WARNING: freeing " << id_name << " helper with " << stats.queue_size << " requests queued");
+
+    if (batchScheduled)
+        eventDelete(helperDispatchBatch, this);
+    while (dlink_node *link = batch.head) {
+        delete static_cast<Helper::Request *>(link->data);
+        dlinkDelete(link, &batch);
+        memFree(link, MEM_DLINK_NODE);
+    }
+
+    // servers that are still running must not update the heap
+    while (!heap_empty(loads))
+        static_cast<helper_server *>(heap_extractmin(loads))->loadNode = NULL;
+    delete_heap(loads);
 }
 
 /* ====================================================================== */
@@ -686,6 +737,7 @@ helperServerFree(helper_server *srv)
         srv->closeWritePipeSafely(hlp->id_name);
 
     dlinkDelete(&srv->link, &hlp->servers);
+    helperForgetLoad(srv);
 
     assert(hlp->childs.n_running > 0);
     -- hlp->childs.n_running;
@@ -820,6 +872,8 @@ helperReturnBuffer(int request_number, helper_server * srv, helper * hlp, char *
 
         -- srv->stats.pending;
         ++ srv->stats.replies;
+        if (srv->loadNode)
+            heap_update(hlp->loads, srv->loadNode, srv);
 
         ++ hlp->stats.replies;
 
@@ -827,10 +881,11 @@ helperReturnBuffer(int request_number, helper_server * srv, helper * hlp, char *
 
         srv->dispatch_time = r->dispatch_time;
 
+        const int svcTime = tvSubMsec(r->dispatch_time, current_time);
         hlp->stats.avg_svc_time =
-            Math::intAverage(hlp->stats.avg_svc_time,
-                             tvSubMsec(r->dispatch_time, current_time),
+            Math::intAverage(hlp->stats.avg_svc_time, svcTime,
                              hlp->stats.replies, REDIRECT_AV_FACTOR);
+        hlp->serviceTimes.count(svcTime);
 
         delete r;
     } else {
@@ -1022,10 +1077,11 @@ helperStatefulHandleRead(const Comm::ConnectionPointer &conn, char *buf, size_t
 
         ++ hlp->stats.replies;
         srv->answer_time = current_time;
+        const int svcTime = tvSubMsec(srv->dispatch_time, current_time);
         hlp->stats.avg_svc_time =
-            Math::intAverage(hlp->stats.avg_svc_time,
-                             tvSubMsec(srv->dispatch_time, current_time),
+            Math::intAverage(hlp->stats.avg_svc_time, svcTime,
                              hlp->stats.replies, REDIRECT_AV_FACTOR);
+        hlp->serviceTimes.count(svcTime);
 
         if (called)
             helperStatefulServerDone(srv);
@@ -1158,44 +1214,40 @@ StatefulDequeue(statefulhelper * hlp)
     return r;
 }
 
+/// orders stateless servers by the number of pending requests and then
+/// by the number of requests they got, to spread load among idle servers
+static heap_key
+helperServerLoad(heap_t data, heap_key)
+{
+    const helper_server *srv = static_cast<const helper_server *>(data);
+    return static_cast<double>(srv->stats.pending) * 4294967296.0 +
+           static_cast<double>(srv->stats.uses & 0xFFFFFFFF);
+}
+
+/// stops dispatching new requests to the server
+static void
+helperForgetLoad(helper_server *srv)
+{
+    if (srv->loadNode) {
+        heap_delete(srv->parent->loads, srv->loadNode);
+        srv->loadNode = NULL;
+    }
+}
+
+/// the least loaded server that can accept another request, if any
 static helper_server *
 GetFirstAvailable(helper * hlp)
 {
-    dlink_node *n;
-    helper_server *srv;
-    helper_server *selected = NULL;
     debugs(84, 5, "GetFirstAvailable: Running servers " << hlp->childs.n_running);
 
-    if (hlp->childs.n_running == 0)
-        return NULL;
-
-    /* Find "least" loaded helper (approx) */
-    for (n = hlp->servers.head; n != NULL; n = n->next) {
-        srv = (helper_server *)n->data;
-
-        if (selected && selected->stats.pending <= srv->stats.pending)
-            continue;
-
-        if (srv->flags.shutdown)
-            continue;
-
-        if (!srv->stats.pending)
-            return srv;
-
-        if (selected) {
-            selected = srv;
-            break;
-        }
-
-        selected = srv;
-    }
-
-    /* Check for overload */
-    if (!selected) {
+    if (hlp->childs.n_running == 0 || heap_empty(hlp->loads)) {
         debugs(84, 5, "GetFirstAvailable: None available.");
         return NULL;
     }
 
+    helper_server *selected = static_cast<helper_server *>(heap_peepmin(hlp->loads));
+
+    /* Check for overload */
     if (selected->stats.pending >= (hlp->childs.concurrency ? hlp->childs.concurrency : 1)) {
         debugs(84, 3, "GetFirstAvailable: Least-loaded helper is overloaded!");
         return NULL;
@@ -1254,18 +1306,29 @@ helperDispatchWriteDone(const Comm::ConnectionPointer &conn, char *buf, size_t l
         return;
     }
 
-    if (!srv->wqueue->isNull()) {
-        srv->writebuf = srv->wqueue;
-        srv->wqueue = new MemBuf;
-        srv->flags.writing = true;
-        AsyncCall::Pointer call = commCbCall(5,5, "helperDispatchWriteDone",
-                                             CommIoCbPtrFun(helperDispatchWriteDone, srv));
-        Comm::Write(srv->writePipe, srv->writebuf->content(), srv->writebuf->contentSize(), call, NULL);
-    }
+    helperWriteQueued(srv);
 }
 
+/// starts writing the requests accumulated in the server write queue, if any
 static void
-helperDispatch(helper_server * srv, Helper::Request * r)
+helperWriteQueued(helper_server * srv)
+{
+    if (srv->flags.writing || srv->wqueue->isNull())
+        return;
+
+    assert(NULL == srv->writebuf);
+    srv->writebuf = srv->wqueue;
+    srv->wqueue = new MemBuf;
+    srv->flags.writing = true;
+    AsyncCall::Pointer call = commCbCall(5,5, "helperDispatchWriteDone",
+                                         CommIoCbPtrFun(helperDispatchWriteDone, srv));
+    Comm::Write(srv->writePipe, srv->writebuf->content(), srv->writebuf->contentSize(), call, NULL);
+}
+
+/// sends the request to the server or, if writeNow is false, adds it to the
+/// server write queue for the caller to flush with helperWriteQueued()
+static void
+helperDispatch(helper_server * srv, Helper::Request * r, const bool writeNow)
 {
     helper *hlp = srv->parent;
     Helper::Request **ptr = NULL;
@@ -1296,21 +1359,17 @@ helperDispatch(helper_server * srv, Helper::Request * r)
     else
         srv->wqueue->append(r->buf, strlen(r->buf));
 
-    if (!srv->flags.writing) {
-        assert(NULL == srv->writebuf);
-        srv->writebuf = srv->wqueue;
-        srv->wqueue = new MemBuf;
-        srv->flags.writing = true;
-        AsyncCall::Pointer call = commCbCall(5,5, "helperDispatchWriteDone",
-                                             CommIoCbPtrFun(helperDispatchWriteDone, srv));
-        Comm::Write(srv->writePipe, srv->writebuf->content(), srv->writebuf->contentSize(), call, NULL);
-    }
+    if (writeNow)
+        helperWriteQueued(srv);
 
     debugs(84, 5, "helperDispatch: Request sent to " << hlp->id_name << " #" << srv->index << ", " << strlen(r->buf) << " bytes");
 
     ++ srv->stats.uses;
     ++ srv->stats.pending;
+    if (srv->loadNode)
+        heap_update(hlp->loads, srv->loadNode, srv);
     ++ hlp->stats.requests;
+    hlp->queueTimes.count(tvSubMsec(r->submit_time, r->dispatch_time));
 }
 
 static void
@@ -1355,6 +1414,7 @@ helperStatefulDispatch(helper_stateful_server * srv, Helper::Request * r)
     srv->flags.reserved = true;
     srv->request = r;
     srv->dispatch_time = current_time;
+    hlp->queueTimes.count(tvSubMsec(r->submit_time, srv->dispatch_time));
     AsyncCall::Pointer call = commCbCall(5,5, "helperStatefulDispatchWriteDone",
                                          CommIoCbPtrFun(helperStatefulDispatchWriteDone, hlp));
     Comm::Write(srv->writePipe, r->buf, strlen(r->buf), call, NULL);
@@ -1367,6 +1427,44 @@ helperStatefulDispatch(helper_stateful_server * srv, Helper::Request * r)
     ++ hlp->stats.requests;
 }
 
+/**
+ * Sends requests submitted to a pipelining helper during the last main loop
+ * iteration. Each server gets as many requests as its concurrency allows,
+ * in a single write, starting with the least loaded server. Requests that
+ * no server can take now are queued as usual.
+ */
+static void
+helperDispatchBatch(void *data)
+{
+    helper *hlp = static_cast<helper *>(data);
+    hlp->batchScheduled = false;
+
+    int requests = 0;
+    int writes = 0;
+    helper_server *srv;
+    while (hlp->batch.head && (srv = GetFirstAvailable(hlp))) {
+        do {
+            dlink_node *link = hlp->batch.head;
+            Helper::Request *r = static_cast<Helper::Request *>(link->data);
+            dlinkDelete(link, &hlp->batch);
+            memFree(link, MEM_DLINK_NODE);
+            helperDispatch(srv, r, false);
+            ++requests;
+        } while (hlp->batch.head && srv->stats.pending < hlp->childs.concurrency);
+        helperWriteQueued(srv);
+        ++writes;
+    }
+
+    debugs(84, 5, hlp->id_name << " sent " << requests << " batched requests in " << writes << " writes");
+
+    while (dlink_node *link = hlp->batch.head) {
+        Helper::Request *r = static_cast<Helper::Request *>(link->data);
+        dlinkDelete(link, &hlp->batch);
+        memFree(link, MEM_DLINK_NODE);
+        Enqueue(hlp, r);
+    }
+}
+
 static void
 helperKickQueue(helper * hlp)
 {
@@ -1398,6 +1496,16 @@ helperStatefulServerDone(helper_stateful_server * srv)
     }
 }
 
+/// reports how long requests waited for and were served by helper servers
+static void
+helperTimesStats(StoreEntry *sentry, const helper *hlp)
+{
+    storeAppendPrintf(sentry, "\nQueue wait time histogram (msec):\n");
+    hlp->queueTimes.dump(sentry, NULL);
+    storeAppendPrintf(sentry, "\nService time histogram (msec):\n");
+    hlp->serviceTimes.dump(sentry, NULL);
+}
+
 // TODO: should helper_ and helper_stateful_ have a common parent?
 static bool
 helperStartStats(StoreEntry *sentry, void *hlp, const char *label)
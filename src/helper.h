@@ -16,22 +16,16 @@
 #include "cbdata.h"
 #include "comm/forward.h"
 #include "dlink.h"
+#include "heap.h"
 #include "helper/ChildConfig.h"
 #include "helper/forward.h"
 #include "ip/Address.h"
+#include "StatHist.h"
 
 class helper
 {
 public:
-    inline helper(const char *name) :
-        cmdline(NULL),
-        id_name(name),
-        ipc_type(0),
-        last_queue_warn(0),
-        last_restart(0),
-        eom('\n') {
-        memset(&stats, 0, sizeof(stats));
-    }
+    helper(const char *name);
     ~helper();
 
 public:
@@ -46,6 +40,15 @@ public:
     time_t last_restart;
     char eom;   ///< The char which marks the end of (response) message, normally '\n'
 
+    /// whether requests made during one main loop iteration are sent
+    /// together, filling up one concurrent server before using another
+    bool pipeline;
+    dlink_list batch; ///< pipelined requests waiting for helperDispatchBatch()
+    bool batchScheduled; ///< whether helperDispatchBatch() is scheduled
+
+    /// running stateless servers that may get new requests, least loaded first
+    heap *loads;
+
     struct _stats {
         int requests;
         int replies;
@@ -53,6 +56,9 @@ public:
         int avg_svc_time;
     } stats;
 
+    StatHist queueTimes; ///< msec requests waited for a free server
+    StatHist serviceTimes; ///< msec servers took to answer
+
 private:
     CBDATA_CLASS2(helper);
 };
@@ -139,6 +145,8 @@ public:
     helper *parent;
     Helper::Request **requests;
 
+    heap_node *loadNode; ///< our place in parent->loads or nil
+
 private:
     CBDATA_CLASS2(helper_server);
 };
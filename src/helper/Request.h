@@ -23,6 +23,7 @@ public:
         data(cbdataReference(d)),
         placeholder(b == NULL)
     {
+        memset(&submit_time, 0, sizeof(submit_time));
         memset(&dispatch_time, 0, sizeof(dispatch_time));
     }
 
@@ -37,6 +38,7 @@ public:
     void *data;
 
     int placeholder;            /* if 1, this is a dummy request waiting for a stateful helper to become available */
+    struct timeval submit_time; ///< when the request was given to the helper
     struct timeval dispatch_time;
 };
 
@@ -43,6 +43,7 @@ public:
 
     virtual char const *typeString() const;
     virtual void parse();
+    virtual void prepareForUse() { data->prepareForUse(); }
     virtual bool isProxyAuth() const {return true;}
 
     virtual int match(ACLChecklist *checklist);
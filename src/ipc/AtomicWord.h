@@ -48,6 +48,11 @@ public:
 
     // TODO: no need for __sync_fetch_and_add here?
     Value get() const { return __sync_fetch_and_add(const_cast<Value*>(&value), 0); }
+
+    /// reads the value without get()'s write access to the shared cache line
+    Value load() const { return __atomic_load_n(&value, __ATOMIC_ACQUIRE); }
+    /// replaces the value; pairs with load()
+    void store(const Value v) { __atomic_store_n(&value, v, __ATOMIC_RELEASE); }
     operator Value () const { return get(); }
 
 private:
@@ -86,6 +91,9 @@ public:
 
     // TODO: no need for __sync_fetch_and_add here?
     Value get() const { assert(Enabled()); return value; }
+
+    Value load() const { return get(); }
+    void store(const Value v) { assert(Enabled()); value = v; }
     operator Value () const { return get(); }
 
 private:
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 54    Interprocess Communication */
+
+#include "squid.h"
+#include "ipc/SharedCache.h"
+#include "Store.h"
+
+void
+Ipc::SharedCacheStats::dump(StoreEntry &e, const int slots, const int used, const int fresh) const
+{
+    storeAppendPrintf(&e, "Shared cache slots:      %d (%d used, %d fresh)\n",
+                      slots, used, fresh);
+    storeAppendPrintf(&e, "Shared cache hits:       %" PRIu64 "\n", hits);
+    storeAppendPrintf(&e, "Shared cache misses:     %" PRIu64 " (%" PRIu64 " stale)\n",
+                      misses, stale);
+    storeAppendPrintf(&e, "Shared cache stores:     %" PRIu64 "\n", stores);
+    storeAppendPrintf(&e, "Shared cache busy slots: %" PRIu64 "\n", busy);
+}
+
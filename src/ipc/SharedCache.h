@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_IPC_SHAREDCACHE_H
+#define SQUID_IPC_SHAREDCACHE_H
+
+#include "Debug.h"
+#include "hash.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/ReadWriteLock.h"
+#include "SBuf.h"
+#include "SquidTime.h"
+
+class StoreEntry;
+
+namespace Ipc
+{
+
+/// lookup statistics of one SharedCache user
+class SharedCacheStats
+{
+public:
+    SharedCacheStats(): hits(0), misses(0), stale(0), stores(0), busy(0) {}
+
+    /// reports these statistics and the given slot usage
+    void dump(StoreEntry &e, const int slots, const int used, const int fresh) const;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stale; ///< misses due to an expired value
+    uint64_t stores;
+    uint64_t busy; ///< slots skipped because another process was using them
+};
+
+/**
+ * Lookup results shared by all SMP workers, so that a result obtained by
+ * one worker does not have to be obtained again by the others.
+ *
+ * The map is a fixed array of slots in shared memory, split into small
+ * buckets indexed by the hashed key. A value replaces a stale value in
+ * its bucket or, if there is none, the value that expires first. Stale
+ * values are never purged otherwise, so no timer or LRU walk is needed.
+ * Slots busy in other workers are skipped rather than waited for.
+ *
+ * Value is a plain data class with "time_t expires" and "bool negative"
+ * members; it is copied as is to and from shared memory.
+ */
+template <class Value>
+class SharedCache
+{
+public:
+    /// values with the same key hash compete for these many slots
+    static const int BucketSize = 4;
+
+    /// the maximum key length; longer keys are not shared
+    static const size_t KeySize = 255;
+
+    /// one cached value
+    class Slot
+    {
+    public:
+        Slot() { key[0] = '\0'; }
+
+        mutable ReadWriteLock lock; ///< protects the fields below
+        char key[KeySize + 1]; ///< empty if the slot is free
+        Value value;
+    };
+
+    /// data shared across maps in different processes
+    class Shared
+    {
+    public:
+        explicit Shared(const int aLimit): limit(aLimit), slots(aLimit) {}
+        size_t sharedMemorySize() const { return SharedMemorySize(limit); }
+        static size_t SharedMemorySize(const int limit) { return sizeof(Shared) + limit * sizeof(Slot); }
+
+        const int limit; ///< the number of slots (a multiple of BucketSize)
+        Mem::FlexibleArray<Slot> slots;
+    };
+
+    typedef Mem::Owner<Shared> Owner;
+
+    /// creates the shared memory segment for at least the given number of values
+    static Owner *Init(const char *const path, const int limit);
+
+    /// attaches to the shared memory segment created by Init()
+    explicit SharedCache(const char *const aPath);
+
+    /// copies the fresh value for the key, if any
+    bool get(const char *key, Value &value);
+
+    /// shares the value with other workers
+    void put(const char *key, const Value &value);
+
+    /// removes the cached value (or just the negative one) for the key
+    void forget(const char *key, const bool negativeOnly = false);
+
+    /// reports usage and the lookup statistics of this worker
+    void stat(StoreEntry &e) const;
+
+private:
+    Slot *bucketOf(const char *key);
+
+    const SBuf path; ///< shared memory segment name, used for logging
+    Mem::Pointer<Shared> shared;
+    SharedCacheStats stats;
+};
+
+} // namespace Ipc
+
+/* Ipc::SharedCache implementation */
+
+template <class Value>
+typename Ipc::SharedCache<Value>::Owner *
+Ipc::SharedCache<Value>::Init(const char *const path, const int limit)
+{
+    assert(limit > 0); // we should not be created otherwise
+    // round up to whole buckets
+    const int slots = (limit + BucketSize - 1) / BucketSize * BucketSize;
+    Owner *const owner = shm_new(Shared)(path, slots);
+    debugs(54, 5, "new shared cache [" << path << "] created: " << slots);
+    return owner;
+}
+
+template <class Value>
+Ipc::SharedCache<Value>::SharedCache(const char *const aPath):
+    path(aPath),
+    shared(shm_old(Shared)(aPath))
+{
+    assert(shared->limit > 0); // we should not be created otherwise
+    debugs(54, 5, "attached shared cache [" << path << "]: " << shared->limit);
+}
+
+template <class Value>
+typename Ipc::SharedCache<Value>::Slot *
+Ipc::SharedCache<Value>::bucketOf(const char *key)
+{
+    const int bucket = hash4(key, shared->limit / BucketSize);
+    return &shared->slots[bucket * BucketSize];
+}
+
+template <class Value>
+bool
+Ipc::SharedCache<Value>::get(const char *key, Value &value)
+{
+    Slot *bucket = bucketOf(key);
+    for (int i = 0; i < BucketSize; ++i) {
+        Slot &s = bucket[i];
+        if (!s.lock.lockShared()) {
+            ++stats.busy;
+            continue;
+        }
+
+        if (strcmp(s.key, key) != 0) {
+            s.lock.unlockShared();
+            continue;
+        }
+
+        const bool fresh = s.value.expires > squid_curtime;
+        if (fresh)
+            value = s.value;
+        s.lock.unlockShared();
+
+        if (!fresh) {
+            ++stats.stale;
+            break;
+        }
+
+        debugs(54, 5, "hit for " << key << " in [" << path << "]");
+        ++stats.hits;
+        return true;
+    }
+
+    ++stats.misses;
+    return false;
+}
+
+template <class Value>
+void
+Ipc::SharedCache<Value>::put(const char *key, const Value &value)
+{
+    if (strlen(key) > KeySize)
+        return;
+
+    // reuse the slot with the same key or, if there is none,
+    // the free, the stale, or the soonest-to-expire slot
+    Slot *bucket = bucketOf(key);
+    Slot *victim = NULL;
+    time_t victimExpires = 0;
+    for (int i = 0; i < BucketSize; ++i) {
+        Slot &s = bucket[i];
+        if (!s.lock.lockShared()) {
+            ++stats.busy;
+            continue;
+        }
+        const bool same = strcmp(s.key, key) == 0;
+        const time_t expires = s.key[0] ? s.value.expires : 0;
+        s.lock.unlockShared();
+
+        if (same) {
+            victim = &s;
+            break;
+        }
+
+        if (!victim || expires < victimExpires) {
+            victim = &s;
+            victimExpires = expires;
+        }
+    }
+
+    if (!victim)
+        return;
+
+    if (!victim->lock.lockExclusive()) {
+        ++stats.busy;
+        return;
+    }
+    strcpy(victim->key, key);
+    victim->value = value;
+    victim->lock.unlockExclusive();
+
+    debugs(54, 5, "stored " << key << " in [" << path << "] slot " << (victim - shared->slots.raw()));
+    ++stats.stores;
+}
+
+template <class Value>
+void
+Ipc::SharedCache<Value>::forget(const char *key, const bool negativeOnly)
+{
+    Slot *bucket = bucketOf(key);
+    for (int i = 0; i < BucketSize; ++i) {
+        Slot &s = bucket[i];
+        if (!s.lock.lockExclusive()) {
+            ++stats.busy;
+            continue;
+        }
+        if (strcmp(s.key, key) == 0 && (!negativeOnly || s.value.negative)) {
+            debugs(54, 5, "forgetting " << key << " in [" << path << "]");
+            s.key[0] = '\0';
+        }
+        s.lock.unlockExclusive();
+    }
+}
+
+template <class Value>
+void
+Ipc::SharedCache<Value>::stat(StoreEntry &e) const
+{
+    int used = 0;
+    int fresh = 0;
+    for (int i = 0; i < shared->limit; ++i) {
+        const Slot &s = shared->slots[i];
+        if (!s.lock.lockShared())
+            continue;
+        if (s.key[0]) {
+            ++used;
+            if (s.value.expires > squid_curtime)
+                ++fresh;
+        }
+        s.lock.unlockShared();
+    }
+
+    stats.dump(e, shared->limit, used, fresh);
+}
+
+#endif /* SQUID_IPC_SHAREDCACHE_H */
+
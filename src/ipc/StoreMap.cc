@@ -27,6 +27,19 @@ StoreMapAnchorsId(const SBuf &path)
     return Ipc::Mem::Segment::Name(path, "anchors");
 }
 
+static SBuf
+StoreMapBucketsId(const SBuf &path)
+{
+    return Ipc::Mem::Segment::Name(path, "buckets");
+}
+
+/// the number of buckets needed to give each anchor its way
+static int
+StoreMapBucketCount(const int anchorLimit)
+{
+    return (anchorLimit + Ipc::StoreMapWays - 1) / Ipc::StoreMapWays;
+}
+
 Ipc::StoreMap::Owner *
 Ipc::StoreMap::Init(const SBuf &path, const int sliceLimit)
 {
@@ -35,18 +48,23 @@ Ipc::StoreMap::Init(const SBuf &path, const int sliceLimit)
     Owner *owner = new Owner;
     owner->anchors = shm_new(Anchors)(StoreMapAnchorsId(path).c_str(), anchorLimit);
     owner->slices = shm_new(Slices)(StoreMapSlicesId(path).c_str(), sliceLimit);
+    owner->buckets = shm_new(StoreMapBuckets)(StoreMapBucketsId(path).c_str(), StoreMapBucketCount(anchorLimit));
     debugs(54, 5, "created " << path << " with " << anchorLimit << '+' << sliceLimit);
     return owner;
 }
 
 Ipc::StoreMap::StoreMap(const SBuf &aPath): cleaner(NULL), path(aPath),
     anchors(shm_old(Anchors)(StoreMapAnchorsId(path).c_str())),
-    slices(shm_old(Slices)(StoreMapSlicesId(path).c_str()))
+    slices(shm_old(Slices)(StoreMapSlicesId(path).c_str())),
+    buckets(shm_old(StoreMapBuckets)(StoreMapBucketsId(path).c_str())),
+    eviction(epClock)
 {
     debugs(54, 5, "attached " << path << " with " <<
            anchors->capacity << '+' << slices->capacity);
+    assert(anchors->layoutVersion == Anchors::LayoutVersion);
     assert(entryLimit() > 0); // key-to-position mapping requires this
     assert(entryLimit() <= sliceLimit()); // at least one slice per entry
+    assert(buckets->capacity == StoreMapBucketCount(anchors->capacity));
 }
 
 int
@@ -78,6 +96,7 @@ Ipc::StoreMap::forgetWritingEntry(sfileno fileno)
 
     inode.waitingToBeFreed = false;
     inode.rewind();
+    unindexEntry(fileno);
 
     inode.lock.unlockExclusive();
     --anchors->count;
@@ -90,13 +109,76 @@ Ipc::StoreMap::openForWriting(const cache_key *const key, sfileno &fileno)
 {
     debugs(54, 5, "opening entry with key " << storeKeyText(key)
            << " for writing " << path);
-    const int idx = anchorIndexByKey(key);
+    const int bucketIdx = bucketIndexByKey(key);
+    const StoreMapBucket &bucket = bucketAt(bucketIdx);
+    const sfileno firstWay = bucketIdx * StoreMapWays;
+    const uint64_t hint = KeyHint(key);
+
+    // replace the older version of our entry, if any; if that version is
+    // busy, do not store a second copy of the key in another way
+    for (int way = 0; way < StoreMapWays; ++way) {
+        const sfileno idx = firstWay + way;
+        if (validEntry(idx) && bucket.hints[way].load() == hint) {
+            if (Anchor *anchor = openForWritingAt(idx)) {
+                indexEntry(idx, hint);
+                ++probes.placements[way];
+                fileno = idx;
+                return anchor;
+            }
+            debugs(54, 5, "the older version of " << storeKeyText(key) <<
+                   " at " << idx << " is busy in " << path);
+            return NULL;
+        }
+    }
+
+    // use an empty way, if any
+    for (int way = 0; way < StoreMapWays; ++way) {
+        const sfileno idx = firstWay + way;
+        if (validEntry(idx) && !bucket.hints[way].load()) {
+            if (Anchor *anchor = openForWritingAt(idx, false)) {
+                indexEntry(idx, hint);
+                ++probes.placements[way];
+                fileno = idx;
+                return anchor;
+            }
+        }
+    }
 
-    if (Anchor *anchor = openForWritingAt(idx)) {
-        fileno = idx;
-        return anchor;
+    // evict an entry, starting with the least recently referenced one;
+    // CLOCK also prefers entries with fewer hits the purge hand did not see
+    int victimWay = 0;
+    for (int way = 1; way < StoreMapWays && validEntry(firstWay + way); ++way) {
+        // note: we do not lock, so comparisons may be inacurate
+        const Anchor &candidate = anchorAt(firstWay + way);
+        const Anchor &victim = anchorAt(firstWay + victimWay);
+        if (eviction == epClock) {
+            const uint8_t candidateRefs = candidate.references.load();
+            const uint8_t victimRefs = victim.references.load();
+            if (candidateRefs != victimRefs) {
+                if (candidateRefs < victimRefs)
+                    victimWay = way;
+                continue;
+            }
+        }
+        if (candidate.basics.lastref < victim.basics.lastref)
+            victimWay = way;
+    }
+    for (int probe = 0; probe < StoreMapWays; ++probe) {
+        const int way = (victimWay + probe) % StoreMapWays;
+        const sfileno idx = firstWay + way;
+        if (!validEntry(idx))
+            continue;
+        if (Anchor *anchor = openForWritingAt(idx)) {
+            indexEntry(idx, hint);
+            ++probes.placements[way];
+            ++probes.evictions;
+            fileno = idx;
+            return anchor;
+        }
     }
 
+    debugs(54, 5, "all " << StoreMapWays << " ways of bucket " << bucketIdx <<
+           " are busy in " << path);
     return NULL;
 }
 
@@ -140,6 +222,8 @@ Ipc::StoreMap::startAppending(const sfileno fileno)
 {
     Anchor &s = anchorAt(fileno);
     assert(s.writing());
+    if (!s.empty())
+        indexEntry(fileno, KeyHint(reinterpret_cast<const cache_key*>(s.key)));
     s.lock.startAppending();
     debugs(54, 5, "restricted entry " << fileno << " to appending " << path);
 }
@@ -149,6 +233,8 @@ Ipc::StoreMap::closeForWriting(const sfileno fileno, bool lockForReading)
 {
     Anchor &s = anchorAt(fileno);
     assert(s.writing());
+    if (!s.empty())
+        indexEntry(fileno, KeyHint(reinterpret_cast<const cache_key*>(s.key)));
     if (lockForReading) {
         s.lock.switchExclusiveToShared();
         debugs(54, 5, "switched entry " << fileno <<
@@ -245,21 +331,29 @@ Ipc::StoreMap::freeEntryByKey(const cache_key *const key)
     debugs(54, 5, "marking entry with key " << storeKeyText(key)
            << " to be freed in " << path);
 
-    const int idx = anchorIndexByKey(key);
-    Anchor &s = anchorAt(idx);
-    if (s.lock.lockExclusive()) {
-        if (s.sameKey(key))
-            freeChain(idx, s, true);
-        s.lock.unlockExclusive();
-    } else if (s.lock.lockShared()) {
-        if (s.sameKey(key))
-            s.waitingToBeFreed = true; // mark to free it later
-        s.lock.unlockShared();
-    } else {
-        // we cannot be sure that the entry we found is ours because we do not
-        // have a lock on it, but we still check to minimize false deletions
-        if (s.sameKey(key))
-            s.waitingToBeFreed = true; // mark to free it later
+    const int bucketIdx = bucketIndexByKey(key);
+    const StoreMapBucket &bucket = bucketAt(bucketIdx);
+    const uint64_t hint = KeyHint(key);
+    // racing writers may have stored several entries with our key
+    for (int way = 0; way < StoreMapWays; ++way) {
+        if (bucket.hints[way].load() != hint)
+            continue;
+        const sfileno idx = bucketIdx * StoreMapWays + way;
+        Anchor &s = anchorAt(idx);
+        if (s.lock.lockExclusive()) {
+            if (s.sameKey(key))
+                freeChain(idx, s, true);
+            s.lock.unlockExclusive();
+        } else if (s.lock.lockShared()) {
+            if (s.sameKey(key))
+                s.waitingToBeFreed = true; // mark to free it later
+            s.lock.unlockShared();
+        } else {
+            // we cannot be sure that the entry we found is ours because we do not
+            // have a lock on it, but we still check to minimize false deletions
+            if (s.sameKey(key))
+                s.waitingToBeFreed = true; // mark to free it later
+        }
     }
 }
 
@@ -285,6 +379,7 @@ Ipc::StoreMap::freeChain(const sfileno fileno, Anchor &inode, const bool keepLoc
 
     inode.waitingToBeFreed = false;
     inode.rewind();
+    unindexEntry(fileno);
 
     if (!keepLocked)
         inode.lock.unlockExclusive();
@@ -297,15 +392,25 @@ Ipc::StoreMap::openForReading(const cache_key *const key, sfileno &fileno)
 {
     debugs(54, 5, "opening entry with key " << storeKeyText(key)
            << " for reading " << path);
-    const int idx = anchorIndexByKey(key);
-    if (const Anchor *slot = openForReadingAt(idx)) {
-        if (slot->sameKey(key)) {
-            fileno = idx;
-            return slot; // locked for reading
+    const int bucketIdx = bucketIndexByKey(key);
+    const StoreMapBucket &bucket = bucketAt(bucketIdx);
+    const uint64_t hint = KeyHint(key);
+    for (int way = 0; way < StoreMapWays; ++way) {
+        if (bucket.hints[way].load() != hint)
+            continue;
+        const sfileno idx = bucketIdx * StoreMapWays + way;
+        if (const Anchor *slot = openForReadingAt(idx)) {
+            if (slot->sameKey(key)) {
+                ++probes.hits[way];
+                noteReference(anchorAt(idx));
+                fileno = idx;
+                return slot; // locked for reading
+            }
+            slot->lock.unlockShared();
+            debugs(54, 7, "closed entry " << idx << " for reading " << path);
         }
-        slot->lock.unlockShared();
-        debugs(54, 7, "closed entry " << idx << " for reading " << path);
     }
+    ++probes.misses;
     return NULL;
 }
 
@@ -357,22 +462,72 @@ Ipc::StoreMap::purgeOne()
     int tries = 0;
     for (; tries < searchLimit; ++tries) {
         const sfileno fileno = static_cast<sfileno>(++anchors->victim % entryLimit());
-        Anchor &s = anchorAt(fileno);
-        if (s.lock.lockExclusive()) {
-            // the caller wants a free slice; empty anchor is not enough
-            if (!s.empty() && s.start >= 0) {
-                // this entry may be marked for deletion, and that is OK
-                freeChain(fileno, s, false);
-                debugs(54, 5, "purged entry " << fileno << " from " << path);
+        if (eviction == epClock && forgiveReference(anchorAt(fileno))) {
+            ++probes.secondChances;
+            continue;
+        }
+        if (purgeAt(fileno))
+            return true;
+    }
+
+    // Do not fail the caller just because all visited entries had hits.
+    // The hand has forgiven some of them, so the next search is shorter.
+    if (eviction == epClock) {
+        for (int forced = 0; forced < searchLimit; ++forced, ++tries) {
+            const sfileno fileno = static_cast<sfileno>(++anchors->victim % entryLimit());
+            if (purgeAt(fileno)) {
+                ++probes.forcedPurges;
                 return true;
             }
-            s.lock.unlockExclusive();
         }
     }
+
     debugs(54, 5, "no entries to purge from " << path << "; tried: " << tries);
     return false;
 }
 
+/// frees the entry at fileno if it is not locked and has slices
+bool
+Ipc::StoreMap::purgeAt(const sfileno fileno)
+{
+    Anchor &s = anchorAt(fileno);
+    if (s.lock.lockExclusive()) {
+        // the caller wants a free slice; empty anchor is not enough
+        if (!s.empty() && s.start >= 0) {
+            // this entry may be marked for deletion, and that is OK
+            freeChain(fileno, s, false);
+            ++probes.purges;
+            debugs(54, 5, "purged entry " << fileno << " from " << path);
+            return true;
+        }
+        s.lock.unlockExclusive();
+    }
+    return false;
+}
+
+/// remembers a hit, up to MaxReferences of them; does not require a lock
+void
+Ipc::StoreMap::noteReference(Anchor &inode)
+{
+    const uint8_t refs = inode.references.load();
+    if (refs < MaxReferences)
+        inode.references.swap_if(refs, refs + 1); // losing a race is harmless
+}
+
+/// forgets one remembered hit, if any; returns whether there was one
+bool
+Ipc::StoreMap::forgiveReference(Anchor &inode)
+{
+    const uint8_t refs = inode.references.load();
+    return refs > 0 && inode.references.swap_if(refs, refs - 1);
+}
+
+const char *
+Ipc::StoreMap::EvictionPolicyName(const EvictionPolicy policy)
+{
+    return policy == epClock ? "clock" : "fifo";
+}
+
 void
 Ipc::StoreMap::importSlice(const SliceId sliceId, const Slice &slice)
 {
@@ -436,16 +591,62 @@ Ipc::StoreMap::anchorAt(const sfileno fileno) const
 
 sfileno
 Ipc::StoreMap::anchorIndexByKey(const cache_key *const key) const
+{
+    const sfileno firstWay = bucketIndexByKey(key) * StoreMapWays;
+    sfileno emptyWay = -1;
+    for (int way = 0; way < StoreMapWays && validEntry(firstWay + way); ++way) {
+        const Anchor &s = anchorAt(firstWay + way);
+        if (s.sameKey(key))
+            return firstWay + way;
+        // skip empty anchors that another writer has locked but not keyed yet
+        if (emptyWay < 0 && s.empty() && !s.writing())
+            emptyWay = firstWay + way;
+    }
+    return emptyWay; // may be -1: we never return another key's entry
+}
+
+int
+Ipc::StoreMap::bucketIndexByKey(const cache_key *const key) const
 {
     const uint64_t *const k = reinterpret_cast<const uint64_t *>(key);
     // TODO: use a better hash function
-    return (k[0] + k[1]) % entryLimit();
+    return (k[0] + k[1]) % buckets->capacity;
 }
 
-Ipc::StoreMap::Anchor &
-Ipc::StoreMap::anchorByKey(const cache_key *const key)
+Ipc::StoreMapBucket &
+Ipc::StoreMap::bucketAt(const int bucketIdx)
+{
+    assert(0 <= bucketIdx && bucketIdx < buckets->capacity);
+    return buckets->at(bucketIdx);
+}
+
+const Ipc::StoreMapBucket &
+Ipc::StoreMap::bucketAt(const int bucketIdx) const
+{
+    return const_cast<StoreMap&>(*this).bucketAt(bucketIdx);
+}
+
+/// makes the locked entry at fileno findable by its key
+void
+Ipc::StoreMap::indexEntry(const sfileno fileno, const uint64_t hint)
+{
+    bucketAt(fileno / StoreMapWays).hints[fileno % StoreMapWays].store(hint);
+}
+
+/// stops key lookups from probing the locked entry at fileno
+void
+Ipc::StoreMap::unindexEntry(const sfileno fileno)
 {
-    return anchorAt(anchorIndexByKey(key));
+    bucketAt(fileno / StoreMapWays).hints[fileno % StoreMapWays].store(0);
+}
+
+/// a non-zero key fingerprint for StoreMapBucket
+uint64_t
+Ipc::StoreMap::KeyHint(const cache_key *const key)
+{
+    const uint64_t *const k = reinterpret_cast<const uint64_t *>(key);
+    // the bucket is chosen by k[0] + k[1], so use a different mix here
+    return (k[0] ^ (k[1] << 1)) | 1;
 }
 
 Ipc::StoreMap::Slice&
@@ -463,7 +664,7 @@ Ipc::StoreMap::sliceAt(const SliceId sliceId) const
 
 /* Ipc::StoreMapAnchor */
 
-Ipc::StoreMapAnchor::StoreMapAnchor(): start(0)
+Ipc::StoreMapAnchor::StoreMapAnchor(): references(0), start(0)
 {
     memset(&key, 0, sizeof(key));
     memset(&basics, 0, sizeof(basics));
@@ -502,12 +703,13 @@ Ipc::StoreMapAnchor::rewind()
 {
     assert(writing());
     start = 0;
+    references = 0;
     memset(&key, 0, sizeof(key));
     memset(&basics, 0, sizeof(basics));
     // but keep the lock
 }
 
-Ipc::StoreMap::Owner::Owner(): anchors(NULL), slices(NULL)
+Ipc::StoreMap::Owner::Owner(): anchors(NULL), slices(NULL), buckets(NULL)
 {
 }
 
@@ -515,11 +717,13 @@ Ipc::StoreMap::Owner::~Owner()
 {
     delete anchors;
     delete slices;
+    delete buckets;
 }
 
 /* Ipc::StoreMapAnchors */
 
 Ipc::StoreMapAnchors::StoreMapAnchors(const int aCapacity):
+    layoutVersion(LayoutVersion),
     count(0),
     victim(0),
     capacity(aCapacity),
@@ -539,3 +743,78 @@ Ipc::StoreMapAnchors::SharedMemorySize(const int capacity)
     return sizeof(StoreMapAnchors) + capacity * sizeof(StoreMapAnchor);
 }
 
+
+/* Ipc::StoreMapBuckets */
+
+Ipc::StoreMapBuckets::StoreMapBuckets(const int aCapacity):
+    capacity(aCapacity),
+    raw(aCapacity + 1)
+{
+}
+
+size_t
+Ipc::StoreMapBuckets::SharedMemorySize(const int capacity)
+{
+    return sizeof(StoreMapBuckets) + capacity * sizeof(StoreMapBucket);
+}
+
+Ipc::StoreMapBucket &
+Ipc::StoreMapBuckets::at(const int idx)
+{
+    // shared segments are page-aligned, but our header shifts the array
+    char *const base = reinterpret_cast<char*>(raw.raw());
+    const size_t misalignment = reinterpret_cast<uintptr_t>(base) % sizeof(StoreMapBucket);
+    char *const aligned = misalignment ? base + sizeof(StoreMapBucket) - misalignment : base;
+    return reinterpret_cast<StoreMapBucket*>(aligned)[idx];
+}
+
+/* Ipc::StoreMapProbeStats */
+
+Ipc::StoreMapProbeStats::StoreMapProbeStats()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void
+Ipc::StoreMapProbeStats::dump(StoreEntry &e) const
+{
+    uint64_t found = 0;
+    uint64_t placed = 0;
+    for (int way = 0; way < StoreMapWays; ++way) {
+        found += hits[way];
+        placed += placements[way];
+    }
+
+    const uint64_t lookups = found + misses;
+    storeAppendPrintf(&e, "Key lookups:     %9" PRIu64 "\n", lookups);
+    if (lookups) {
+        storeAppendPrintf(&e, "Misses:          %9" PRIu64 " %6.2f%%\n",
+                          misses, (100.0 * misses / lookups));
+        for (int way = 0; way < StoreMapWays; ++way) {
+            if (hits[way]) {
+                storeAppendPrintf(&e, "Hits at probe %d: %9" PRIu64 " %6.2f%%\n",
+                                  way + 1, hits[way], (100.0 * hits[way] / lookups));
+            }
+        }
+    }
+
+    storeAppendPrintf(&e, "Key placements:  %9" PRIu64 "\n", placed);
+    if (placed) {
+        for (int way = 0; way < StoreMapWays; ++way) {
+            if (placements[way]) {
+                storeAppendPrintf(&e, "Placed at probe %d: %9" PRIu64 " %6.2f%%\n",
+                                  way + 1, placements[way], (100.0 * placements[way] / placed));
+            }
+        }
+        storeAppendPrintf(&e, "Evictions:       %9" PRIu64 " %6.2f%%\n",
+                          evictions, (100.0 * evictions / placed));
+    }
+
+    storeAppendPrintf(&e, "Purges:          %9" PRIu64 "\n", purges);
+    if (purges) {
+        storeAppendPrintf(&e, "Second chances:  %9" PRIu64 " %6.2f per purge\n",
+                          secondChances, (1.0 * secondChances / purges));
+        storeAppendPrintf(&e, "Forced purges:   %9" PRIu64 " %6.2f%%\n",
+                          forcedPurges, (100.0 * forcedPurges / purges));
+    }
+}
@@ -61,6 +61,8 @@ public:
 public:
     mutable ReadWriteLock lock; ///< protects slot data below
     Atomic::WordT<uint8_t> waitingToBeFreed; ///< may be accessed w/o a lock
+    /// recent hits not yet forgiven by the CLOCK hand; may be accessed w/o a lock
+    Atomic::WordT<uint8_t> references;
 
     // fields marked with [app] can be modified when appending-while-reading
 
@@ -109,11 +111,15 @@ class StoreMapAnchors
 public:
     typedef Ipc::Mem::Owner< StoreMapAnchors > Owner;
 
+    /// shared memory layout version; bump when anchors or buckets change
+    static const uint32_t LayoutVersion = 3;
+
     explicit StoreMapAnchors(const int aCapacity);
 
     size_t sharedMemorySize() const;
     static size_t SharedMemorySize(const int anAnchorLimit);
 
+    const uint32_t layoutVersion; ///< LayoutVersion of the segment creator
     Atomic::Word count; ///< current number of entries
     Atomic::WordT<uint32_t> victim; ///< starting point for purge search
     const int capacity; ///< total number of anchors
@@ -121,6 +127,57 @@ public:
 };
 // TODO: Find an elegant way to use StoreMapItems in StoreMapAnchors
 
+/// the number of adjacent anchors (ways) where an entry with a given key may
+/// be stored; a new entry evicts an old one only when all ways are taken
+static const int StoreMapWays = 8;
+
+/// Fingerprints of the keys stored in one group of StoreMapWays anchors.
+/// Readers scan fingerprints without locking and only lock the anchors that
+/// may hold their key. A bucket fills one 64-byte CPU cache line.
+class StoreMapBucket
+{
+public:
+    /// fingerprints of anchor keys; zero if the way is not indexed
+    Atomic::WordT<uint64_t> hints[StoreMapWays];
+};
+
+/// cache-line-aligned StoreMapBuckets indexed by the key hash
+class StoreMapBuckets
+{
+public:
+    typedef Ipc::Mem::Owner< StoreMapBuckets > Owner;
+
+    explicit StoreMapBuckets(const int aCapacity);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity); }
+    static size_t SharedMemorySize(const int aCapacity);
+
+    StoreMapBucket &at(const int idx);
+
+    const int capacity; ///< total number of buckets
+
+private:
+    /// storage for capacity+1 buckets; at() skips the misaligned head
+    Ipc::Mem::FlexibleArray<StoreMapBucket> raw;
+};
+
+/// how many ways StoreMap key lookups and placements had to probe
+class StoreMapProbeStats
+{
+public:
+    StoreMapProbeStats();
+
+    void dump(StoreEntry &e) const;
+
+    uint64_t hits[StoreMapWays]; ///< lookups that found the key at way N+1
+    uint64_t misses; ///< lookups that probed the whole bucket in vain
+    uint64_t placements[StoreMapWays]; ///< new entries stored at way N+1
+    uint64_t evictions; ///< placements that had to free a foreign entry
+    uint64_t purges; ///< entries freed by purgeOne()
+    uint64_t secondChances; ///< referenced entries spared by purgeOne()
+    uint64_t forcedPurges; ///< purges that had to ignore references
+};
+
 class StoreMapCleaner;
 
 /// Manages shared Store index (e.g., locking/unlocking/freeing entries) using
@@ -136,6 +193,18 @@ public:
     typedef StoreMapSlices Slices;
     typedef StoreMapSliceId SliceId;
 
+    /// how purgeOne() and openForWriting() pick entries to evict
+    typedef enum {
+        epFifo, ///< in the order of anchor positions, ignoring hits
+        epClock ///< like epFifo, but spare entries with recent hits
+    } EvictionPolicy;
+
+    /// the most hits an anchor remembers; each spares it from one purge
+    static const uint8_t MaxReferences = 3;
+
+    /// the configuration name of the given policy
+    static const char *EvictionPolicyName(const EvictionPolicy policy);
+
 public:
     /// aggregates anchor and slice owners for Init() caller convenience
     class Owner
@@ -145,6 +214,7 @@ public:
         ~Owner();
         Anchors::Owner *anchors;
         Slices::Owner *slices;
+        StoreMapBuckets::Owner *buckets;
     private:
         Owner(const Owner &); // not implemented
         Owner &operator =(const Owner &); // not implemented
@@ -155,7 +225,12 @@ public:
 
     StoreMap(const SBuf &aPath);
 
-    /// computes map entry position for a given entry key
+    /// Computes map entry position for a given entry key without locking:
+    /// the way holding that key or else an unlocked empty way of the key
+    /// bucket; -1 if all bucket ways hold other keys. Other processes may
+    /// change unlocked ways at any time, so the result is only a hint that the
+    /// caller must confirm by locking the entry (e.g., via openForWritingAt()
+    /// without overwriting). Ways write-locked by the caller are reliable.
     sfileno anchorIndexByKey(const cache_key *const key) const;
 
     /// Like strcmp(mapped, new), but for store entry versions/timestamps.
@@ -211,6 +286,10 @@ public:
     /// either finds and frees an entry with at least 1 slice or returns false
     bool purgeOne();
 
+    /// how this process evicts entries; the map does not share this setting
+    EvictionPolicy evictionPolicy() const { return eviction; }
+    void evictionPolicy(const EvictionPolicy policy) { eviction = policy; }
+
     /// copies slice to its designated position
     void importSlice(const SliceId sliceId, const Slice &slice);
 
@@ -224,23 +303,38 @@ public:
     /// adds approximate current stats to the supplied ones
     void updateStats(ReadWriteLockStats &stats) const;
 
+    /// key probing stats of this process
+    const StoreMapProbeStats &probeStats() const { return probes; }
+
     StoreMapCleaner *cleaner; ///< notified before a readable entry is freed
 
 protected:
     const SBuf path; ///< cache_dir path or similar cache name; for logging
     Mem::Pointer<StoreMapAnchors> anchors; ///< entry inodes (starting blocks)
     Mem::Pointer<StoreMapSlices> slices; ///< chained entry pieces positions
+    Mem::Pointer<StoreMapBuckets> buckets; ///< key fingerprints by key hash
 
 private:
     Anchor &anchorAt(const sfileno fileno);
     const Anchor &anchorAt(const sfileno fileno) const;
-    Anchor &anchorByKey(const cache_key *const key);
+    int bucketIndexByKey(const cache_key *const key) const;
+    StoreMapBucket &bucketAt(const int bucketIdx);
+    const StoreMapBucket &bucketAt(const int bucketIdx) const;
+    void indexEntry(const sfileno fileno, const uint64_t hint);
+    void unindexEntry(const sfileno fileno);
+    static uint64_t KeyHint(const cache_key *const key);
 
     Slice &sliceAt(const SliceId sliceId);
     const Slice &sliceAt(const SliceId sliceId) const;
     Anchor *openForReading(Slice &s);
 
     void freeChain(const sfileno fileno, Anchor &inode, const bool keepLock);
+    void noteReference(Anchor &inode);
+    bool forgiveReference(Anchor &inode);
+    bool purgeAt(const sfileno fileno);
+
+    EvictionPolicy eviction; ///< purgeOne() and openForWriting() victim selection
+    StoreMapProbeStats probes; ///< updated by key lookups
 };
 
 /// API for adjusting external state when dirty map slice is being freed
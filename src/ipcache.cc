@@ -13,6 +13,7 @@
 #include "cbdata.h"
 #include "dlink.h"
 #include "DnsLookupDetails.h"
+#include "DnsSharedCache.h"
 #include "event.h"
 #include "ip/Address.h"
 #include "ip/tools.h"
@@ -25,6 +26,7 @@
 #include "SquidTime.h"
 #include "StatCounters.h"
 #include "Store.h"
+#include "tools.h"
 #include "wordlist.h"
 
 #if SQUID_SNMP
@@ -134,6 +136,10 @@ static ipcache_addrs static_addrs;
 /// \ingroup IPCacheInternal
 static hash_table *ip_table = NULL;
 
+/// \ingroup IPCacheInternal
+/// answers shared with other SMP workers; nil unless dns_cache_shared is on
+static DnsSharedCache *SharedIpcache = NULL;
+
 /// \ingroup IPCacheInternal
 static long ipcache_low = 180;
 /// \ingroup IPCacheInternal
@@ -453,6 +459,63 @@ ipcacheParse(ipcache_entry *i, const rfc1035_rr * answers, int nr, const char *e
     i->flags.negcached = false;
 }
 
+/// \ingroup IPCacheInternal
+/// makes a DNS answer available to other SMP workers
+static void
+ipcacheShare(const ipcache_entry *i)
+{
+    if (!SharedIpcache || i->flags.fromhosts)
+        return;
+
+    DnsSharedAnswer answer;
+    answer.expires = i->expires;
+    answer.negative = i->flags.negcached;
+    if (i->error_message)
+        xstrncpy(answer.error, i->error_message, sizeof(answer.error));
+
+    const int maxCount = DnsSharedAnswer::DataSize / sizeof(struct in6_addr);
+    for (int k = 0; k < i->addrs.count && k < maxCount; ++k) {
+        struct in6_addr addr;
+        i->addrs.in_addrs[k].getInAddr(addr);
+        memcpy(answer.data + answer.size, &addr, sizeof(addr));
+        answer.size += sizeof(addr);
+        ++answer.count;
+    }
+
+    SharedIpcache->put(static_cast<const char *>(i->hash.key), answer);
+}
+
+/// \ingroup IPCacheInternal
+/// adds an entry with the answer another SMP worker got for the name, if any
+static ipcache_entry *
+ipcacheFromShared(const char *name)
+{
+    DnsSharedAnswer answer;
+    if (!SharedIpcache || !SharedIpcache->get(name, answer))
+        return NULL;
+
+    ipcache_entry *i = ipcacheCreateEntry(name);
+    i->expires = answer.expires;
+    i->flags.negcached = answer.negative;
+    if (answer.error[0])
+        i->error_message = xstrdup(answer.error);
+
+    if (answer.count) {
+        i->addrs.in_addrs = static_cast<Ip::Address *>(xcalloc(answer.count, sizeof(Ip::Address)));
+        i->addrs.bad_mask = (unsigned char *)xcalloc(answer.count, sizeof(unsigned char));
+        for (int k = 0; k < answer.count; ++k) {
+            struct in6_addr addr;
+            memcpy(&addr, answer.data + k * sizeof(addr), sizeof(addr));
+            i->addrs.in_addrs[k].setEmpty(); // perform same init actions as constructor would.
+            i->addrs.in_addrs[k] = addr;
+        }
+        i->addrs.count = answer.count;
+    }
+
+    ipcacheAddEntry(i);
+    return i;
+}
+
 /// \ingroup IPCacheInternal
 static void
 ipcacheHandleReply(void *data, const rfc1035_rr * answers, int na, const char *error_message)
@@ -464,6 +527,7 @@ ipcacheHandleReply(void *data, const rfc1035_rr * answers, int na, const char *e
     statCounter.dns.svcTime.count(age);
 
     ipcacheParse(i, answers, na, error_message);
+    ipcacheShare(i);
     ipcacheAddEntry(i);
     ipcacheCallback(i, age);
 }
@@ -520,7 +584,14 @@ ipcache_nbgethostbyname(const char *name, IPH * handler, void *handlerData)
         /* hit, but expired -- bummer */
         ipcacheRelease(i);
         i = NULL;
-    } else {
+    }
+
+    if (NULL == i) {
+        /* another SMP worker may have resolved the name already */
+        i = ipcacheFromShared(name);
+    }
+
+    if (NULL != i) {
         /* hit */
         debugs(14, 4, "ipcache_nbgethostbyname: HIT for '" << name << "'");
 
@@ -584,6 +655,9 @@ ipcache_init(void)
     ip_table = hash_create((HASHCMP *) strcmp, n, hash4);
     memDataInit(MEM_IPCACHE_ENTRY, "ipcache_entry", sizeof(ipcache_entry), 0);
 
+    if (DnsSharedCache::Enabled() && IamWorkerProcess() && Config.ipcache.size > 0)
+        SharedIpcache = new DnsSharedCache(DnsSharedCache::IpcacheName);
+
     ipcacheRegisterWithCacheManager();
 }
 
@@ -612,11 +686,16 @@ ipcache_gethostbyname(const char *name, int flags)
     ++IpcacheStats.requests;
     i = ipcache_get(name);
 
-    if (NULL == i) {
-        (void) 0;
-    } else if (ipcacheExpiredEntry(i)) {
+    if (NULL != i && ipcacheExpiredEntry(i)) {
         ipcacheRelease(i);
         i = NULL;
+    }
+
+    if (NULL == i)
+        i = ipcacheFromShared(name);
+
+    if (NULL == i) {
+        (void) 0;
     } else if (i->flags.negcached) {
         ++IpcacheStats.negative_hits;
         // ignore i->error_message: the caller just checks IP cache presence
@@ -693,6 +772,13 @@ ipcacheStatPrint(ipcache_entry * i, StoreEntry * sentry)
                               i->addrs.in_addrs[k].toStr(buf,MAX_IPSTRLEN),
                               i->addrs.bad_mask[k] ? "BAD" : "OK ");
     }
+
+    const ipcache_family_stats &v4 = i->addrs.ipv4;
+    const ipcache_family_stats &v6 = i->addrs.ipv6;
+    if (v4.successes || v4.failures || v6.successes || v6.failures)
+        storeAppendPrintf(sentry, "%57s IPv4: %u ok, %u failed, %ums; IPv6: %u ok, %u failed, %ums\n", "",
+                          v4.successes, v4.failures, v4.rtt,
+                          v6.successes, v6.failures, v6.rtt);
 }
 
 /**
@@ -730,6 +816,8 @@ stat_ipcache_get(StoreEntry * sentry)
                       IpcacheStats.cname_only);
     storeAppendPrintf(sentry, "IPcache Invalid Request: %d\n",
                       IpcacheStats.invalid);
+    if (SharedIpcache)
+        SharedIpcache->stat(*sentry);
     storeAppendPrintf(sentry, "\n\n");
     storeAppendPrintf(sentry, "IP Cache Contents:\n\n");
     storeAppendPrintf(sentry, " %-31.31s %3s %6s %6s  %4s\n",
@@ -751,6 +839,9 @@ ipcacheInvalidate(const char *name)
 {
     ipcache_entry *i;
 
+    if (SharedIpcache)
+        SharedIpcache->forget(name);
+
     if ((i = ipcache_get(name)) == NULL)
         return;
 
@@ -768,6 +859,9 @@ ipcacheInvalidateNegative(const char *name)
 {
     ipcache_entry *i;
 
+    if (SharedIpcache)
+        SharedIpcache->forget(name, true);
+
     if ((i = ipcache_get(name)) == NULL)
         return;
 
@@ -973,6 +1067,73 @@ ipcacheMarkGoodAddr(const char *name, const Ip::Address &addr)
     debugs(14, 2, "ipcacheMarkGoodAddr: " << name << " " << addr );
 }
 
+/// \ingroup IPCacheAPI
+/// records how a connection attempt to an address of the named host went
+void
+ipcacheNoteConnect(const char *name, const Ip::Address &addr, bool connected, int msec)
+{
+    ipcache_entry *i;
+
+    if ((i = ipcache_get(name)) == NULL)
+        return;
+
+    ipcache_family_stats &stats = addr.isIPv4() ? i->addrs.ipv4 : i->addrs.ipv6;
+
+    if (connected) {
+        const int sample = min(max(msec, 0), 0xFFFF);
+        stats.rtt = stats.successes ? (3 * stats.rtt + sample) / 4 : sample;
+        ++stats.successes;
+    } else {
+        ++stats.failures;
+    }
+
+    // age old outcomes so that preferences follow connectivity changes
+    if (stats.successes + stats.failures > 16) {
+        stats.successes /= 2;
+        stats.failures /= 2;
+    }
+
+    debugs(14, 3, name << " " << addr << (connected ? " connected" : " failed") <<
+           " after " << msec << "ms; IPv" << (addr.isIPv4() ? 4 : 6) << " stats: " <<
+           stats.successes << '/' << stats.failures << ' ' << stats.rtt << "ms");
+}
+
+/// \ingroup IPCacheInternal
+/// whether connections to the family addresses fail more often than not
+static bool
+ipcacheFamilyFails(const ipcache_family_stats &stats)
+{
+    return stats.failures > stats.successes;
+}
+
+/**
+ \ingroup IPCacheAPI
+ *
+ * Whether connections should be tried with IPv4 addresses first. The
+ * family of the current address wins unless the connection statistics
+ * show that only the other family works or that it connects at least
+ * twice as fast. Attempts that lose a connection race are not counted,
+ * so a family that never connects never gets any successes.
+ */
+bool
+ipcacheIpv4First(const ipcache_addrs *ia)
+{
+    const bool currentIsIpv4 = ia->in_addrs[ia->cur].isIPv4();
+    const ipcache_family_stats &current = currentIsIpv4 ? ia->ipv4 : ia->ipv6;
+    const ipcache_family_stats &other = currentIsIpv4 ? ia->ipv6 : ia->ipv4;
+
+    if (!other.successes || ipcacheFamilyFails(other))
+        return currentIsIpv4;
+
+    if (!current.successes || ipcacheFamilyFails(current))
+        return !currentIsIpv4;
+
+    if (current.successes && 2 * other.rtt < current.rtt)
+        return !currentIsIpv4;
+
+    return currentIsIpv4;
+}
+
 /// \ingroup IPCacheInternal
 static void
 ipcacheFreeEntry(void *data)
@@ -992,6 +1153,8 @@ ipcacheFreeMemory(void)
     hashFreeItems(ip_table, ipcacheFreeEntry);
     hashFreeMemory(ip_table);
     ip_table = NULL;
+    delete SharedIpcache;
+    SharedIpcache = NULL;
 }
 
 /**
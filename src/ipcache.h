@@ -16,12 +16,21 @@ class Address;
 
 class DnsLookupDetails;
 
+/// connection outcomes for the addresses of one family of a cached name
+typedef struct _ipcache_family_stats {
+    unsigned short successes; ///< recently established connections
+    unsigned short failures; ///< recently failed connection attempts
+    unsigned short rtt; ///< smoothed connection establishment time in msec
+} ipcache_family_stats;
+
 typedef struct _ipcache_addrs {
     Ip::Address *in_addrs;
     unsigned char *bad_mask;
     unsigned char count;
     unsigned char cur;
     unsigned char badcount;
+    ipcache_family_stats ipv4;
+    ipcache_family_stats ipv6;
 } ipcache_addrs;
 
 typedef void IPH(const ipcache_addrs *, const DnsLookupDetails &details, void *);
@@ -36,6 +45,8 @@ void ipcacheCycleAddr(const char *name, ipcache_addrs *);
 void ipcacheMarkBadAddr(const char *name, const Ip::Address &);
 void ipcacheMarkGoodAddr(const char *name, const Ip::Address &);
 void ipcacheMarkAllGood(const char *name);
+void ipcacheNoteConnect(const char *name, const Ip::Address &, bool connected, int msec);
+bool ipcacheIpv4First(const ipcache_addrs *);
 void ipcacheFreeMemory(void);
 ipcache_addrs *ipcacheCheckNumeric(const char *name);
 void ipcache_restart(void);
@@ -21,6 +21,7 @@
 #include "Mem.h"
 #include "MemBuf.h"
 #include "memMeter.h"
+#include "MemPoolSlab.h"
 #include "mgr/Registration.h"
 #include "RegexList.h"
 #include "SquidConfig.h"
@@ -798,5 +799,37 @@ Mem::Report(std::ostream &stream)
     stream << "Total Pools created: " << mp_total.tot_pools_alloc << "\n";
     stream << "Pools ever used:     " << mp_total.tot_pools_alloc - not_used << " (shown above)\n";
     stream << "Currently in use:    " << mp_total.tot_pools_inuse << "\n";
+
+    SlabClassReport(stream);
+}
+
+/// reports utilization of slabs shared by slab pools, if any
+void
+Mem::SlabClassReport(std::ostream &stream)
+{
+    std::vector<MemSlabClassStats> classes;
+    if (!MemSlabClass::GetStats(classes))
+        return;
+
+    const char *delim = "\t ";
+    stream << "\nSlab classes:\n";
+    stream << "Obj Size\t Slab (KB)\t obj/slab\t Pools\t "
+           "Slabs\t free\t part\t "
+           "Objects out\t free\t %Util\t "
+           "Refills\t Drains\n";
+    for (std::vector<MemSlabClassStats>::const_iterator i = classes.begin(); i != classes.end(); ++i) {
+        stream << std::setw(8) << std::right << i->obj_size << delim;
+        stream << toKB(i->slab_size) << delim;
+        stream << i->slab_capacity << delim;
+        stream << i->pools << delim;
+        stream << i->slabs_alloc << delim;
+        stream << i->slabs_free << delim;
+        stream << i->slabs_partial << delim;
+        stream << i->items_out << delim;
+        stream << i->items_free << delim;
+        stream << std::setprecision(3) << (i->slabs_alloc ? xpercent(i->items_out, i->slabs_alloc * i->slab_capacity) : 0.0) << delim;
+        stream << static_cast<int64_t>(i->refills) << delim;
+        stream << static_cast<int64_t>(i->drains) << "\n";
+    }
 }
 
@@ -42,7 +42,9 @@ memNodeWriteComplete(void* d)
 
 mem_node::mem_node(int64_t offset) :
     nodeBuffer(0,offset,data),
-    write_pending(false)
+    write_pending(false),
+    pins(0),
+    released(false)
 {
     *data = 0;
 }
@@ -112,3 +114,20 @@ mem_node::operator < (mem_node const & rhs) const
     return start() < rhs.start();
 }
 
+void
+mem_node::unpin()
+{
+    assert(pins > 0);
+    if (--pins == 0 && released)
+        delete this;
+}
+
+void
+mem_node::Release(mem_node *aNode)
+{
+    if (aNode->pins > 0)
+        aNode->released = true;
+    else
+        delete aNode;
+}
+
@@ -31,11 +31,23 @@ public:
     bool contains (int64_t const &location) const;
     bool canAccept (int64_t const &location) const;
     bool operator < (mem_node const & rhs) const;
+
+    /// keeps data valid for a reader using it in place; see Release()
+    void pin() { ++pins; }
+    /// undoes pin(), deleting a node already Release()d by its mem_hdr
+    void unpin();
+    /// deletes the node now or, if it is pinned, at the last unpin()
+    static void Release(mem_node *aNode);
+
     /* public */
     StoreIOBuffer nodeBuffer;
     /* Private */
     char data[SM_PAGE_SIZE];
     bool write_pending;
+
+private:
+    int pins; ///< number of readers using data in place
+    bool released; ///< no longer owned by a mem_hdr
 };
 
 MEMPROXY_CLASS_INLINE(mem_node);
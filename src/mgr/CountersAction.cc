@@ -36,6 +36,8 @@ Mgr::CountersActionData::operator += (const CountersActionData& stats)
     client_http_kbytes_in += stats.client_http_kbytes_in;
     client_http_kbytes_out += stats.client_http_kbytes_out;
     client_http_hit_kbytes_out += stats.client_http_hit_kbytes_out;
+    client_http_sendfile_writes += stats.client_http_sendfile_writes;
+    client_http_sendfile_kbytes_out += stats.client_http_sendfile_kbytes_out;
     server_all_requests += stats.server_all_requests;
     server_all_errors += stats.server_all_errors;
     server_all_kbytes_in += stats.server_all_kbytes_in;
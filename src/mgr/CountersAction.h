@@ -31,6 +31,8 @@ public:
     double client_http_kbytes_in;
     double client_http_kbytes_out;
     double client_http_hit_kbytes_out;
+    double client_http_sendfile_writes;
+    double client_http_sendfile_kbytes_out;
     double server_all_requests;
     double server_all_errors;
     double server_all_kbytes_in;
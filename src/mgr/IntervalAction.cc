@@ -98,6 +98,7 @@ Mgr::IntervalActionData::operator += (const IntervalActionData& stats)
     syscalls_sock_closes += stats.syscalls_sock_closes;
     syscalls_sock_reads += stats.syscalls_sock_reads;
     syscalls_sock_writes += stats.syscalls_sock_writes;
+    syscalls_sock_sendfiles += stats.syscalls_sock_sendfiles;
     syscalls_sock_recvfroms += stats.syscalls_sock_recvfroms;
     syscalls_sock_sendtos += stats.syscalls_sock_sendtos;
     syscalls_selects += stats.syscalls_selects;
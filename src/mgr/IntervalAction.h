@@ -93,6 +93,7 @@ public:
     double syscalls_sock_closes;
     double syscalls_sock_reads;
     double syscalls_sock_writes;
+    double syscalls_sock_sendfiles;
     double syscalls_sock_recvfroms;
     double syscalls_sock_sendtos;
     double syscalls_selects;
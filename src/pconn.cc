@@ -21,176 +21,147 @@
 #include "pconn.h"
 #include "PeerPoolMgr.h"
 #include "SquidConfig.h"
+#include "SquidMath.h"
+#include "SquidTime.h"
 #include "Store.h"
 
-#define PCONN_FDS_SZ    8   /* pconn set size, increase for better memcache hit rate */
-
 //TODO: re-attach to MemPools. WAS: static MemAllocator *pconn_fds_pool = NULL;
 PconnModule * PconnModule::instance = NULL;
+CBDATA_CLASS_INIT(IdleConn);
 CBDATA_CLASS_INIT(IdleConnList);
 
+/* ========== IdleConn ================================================ */
+
+IdleConn::IdleConn(const Comm::ConnectionPointer &aConn, IdleConnList *aList):
+    conn(aConn),
+    list(aList),
+    pushed(current_time),
+    older(NULL),
+    newer(NULL),
+    olderInPool(NULL),
+    newerInPool(NULL)
+{
+}
+
 /* ========== IdleConnList ============================================ */
 
 IdleConnList::IdleConnList(const char *key, PconnPool *thePool) :
-    capacity_(PCONN_FDS_SZ),
+    oldest_(NULL),
+    newest_(NULL),
     size_(0),
     parent_(thePool)
 {
     hash.key = xstrdup(key);
-    theList_ = new Comm::ConnectionPointer[capacity_];
-// TODO: re-attach to MemPools. WAS: theList = (?? *)pconn_fds_pool->alloc();
 }
 
 IdleConnList::~IdleConnList()
 {
-    if (parent_)
+    if (parent_) {
+        for (IdleConn *idle = oldest_; idle; idle = idle->newer)
+            parent_->noteConnectionRemoved(idle);
         parent_->unlinkList(this);
+    }
 
     if (size_) {
         parent_ = NULL; // prevent reentrant notifications and deletions
         closeN(size_);
     }
 
-    delete[] theList_;
-
     xfree(hash.key);
 }
 
-/** Search the list. Matches by FD socket number.
- * Performed from the end of list where newest entries are.
- *
- * \retval <0   The connection is not listed
- * \retval >=0  The connection array index
+/** Unlink and delete the listed entry.
+ * Deletes this list if it becomes empty and belongs to a pool.
  */
-int
-IdleConnList::findIndexOf(const Comm::ConnectionPointer &conn) const
-{
-    for (int index = size_ - 1; index >= 0; --index) {
-        if (conn->fd == theList_[index]->fd) {
-            debugs(48, 3, HERE << "found " << conn << " at index " << index);
-            return index;
-        }
-    }
-
-    debugs(48, 2, HERE << conn << " NOT FOUND!");
-    return -1;
-}
-
-/** Remove the entry at specified index.
- * May perform a shuffle of list entries to fill the gap.
- * \retval false The index is not an in-use entry.
- */
-bool
-IdleConnList::removeAt(int index)
+void
+IdleConnList::remove(IdleConn *idle)
 {
-    if (index < 0 || index >= size_)
-        return false;
+    assert(idle->list == this);
 
-    // shuffle the remaining entries to fill the new gap.
-    for (; index < size_ - 1; ++index)
-        theList_[index] = theList_[index + 1];
-    theList_[--size_] = NULL;
+    if (idle->older)
+        idle->older->newer = idle->newer;
+    else
+        oldest_ = idle->newer;
+    if (idle->newer)
+        idle->newer->older = idle->older;
+    else
+        newest_ = idle->older;
+    --size_;
 
-    if (parent_) {
-        parent_->noteConnectionRemoved();
-        if (size_ == 0) {
-            debugs(48, 3, HERE << "deleting " << hashKeyStr(&hash));
-            delete this;
-        }
+    if (parent_)
+        parent_->noteConnectionRemoved(idle);
+    delete idle;
+
+    if (parent_ && size_ == 0) {
+        debugs(48, 3, HERE << "deleting " << hashKeyStr(&hash));
+        delete this;
     }
+}
 
-    return true;
+void
+IdleConnList::close(IdleConn *idle)
+{
+    const Comm::ConnectionPointer conn = idle->conn;
+    clearHandlers(idle);
+    /* may delete this */
+    remove(idle);
+    conn->close();
 }
 
-// almost a duplicate of removeFD. But drops multiple entries.
 void
 IdleConnList::closeN(size_t n)
 {
     if (n < 1) {
         debugs(48, 2, HERE << "Nothing to do.");
         return;
-    } else if (n >= (size_t)size_) {
-        debugs(48, 2, HERE << "Closing all entries.");
-        while (size_ > 0) {
-            const Comm::ConnectionPointer conn = theList_[--size_];
-            theList_[size_] = NULL;
-            clearHandlers(conn);
-            conn->close();
-            if (parent_)
-                parent_->noteConnectionRemoved();
-        }
-    } else { //if (n < size_)
-        debugs(48, 2, HERE << "Closing " << n << " of " << size_ << " entries.");
-
-        size_t index;
-        // ensure the first N entries are closed
-        for (index = 0; index < n; ++index) {
-            const Comm::ConnectionPointer conn = theList_[index];
-            theList_[index] = NULL;
-            clearHandlers(conn);
-            conn->close();
-            if (parent_)
-                parent_->noteConnectionRemoved();
-        }
-        // shuffle the list N down.
-        for (index = 0; index < (size_t)size_ - n; ++index) {
-            theList_[index] = theList_[index + n];
-        }
-        // ensure the last N entries are unset
-        while (index < ((size_t)size_)) {
-            theList_[index] = NULL;
-            ++index;
-        }
-        size_ -= n;
     }
 
-    if (parent_ && size_ == 0) {
-        debugs(48, 3, HERE << "deleting " << hashKeyStr(&hash));
-        delete this;
-    }
+    debugs(48, 2, HERE << "Closing " << min(n, static_cast<size_t>(size_)) << " of " << size_ << " entries.");
+    // stop before the last remove() may delete us
+    for (; n > 1 && size_ > 1; --n)
+        close(oldest_);
+    if (size_ > 0)
+        close(oldest_); // may delete this
 }
 
 void
-IdleConnList::clearHandlers(const Comm::ConnectionPointer &conn)
+IdleConnList::clearHandlers(IdleConn *idle)
 {
+    const Comm::ConnectionPointer &conn = idle->conn;
     debugs(48, 3, HERE << "removing close handler for " << conn);
-    comm_read_cancel(conn->fd, IdleConnList::Read, this);
+    comm_read_cancel(conn->fd, IdleConnList::Read, idle);
     commUnsetConnTimeout(conn);
 }
 
 void
 IdleConnList::push(const Comm::ConnectionPointer &conn)
 {
-    if (size_ == capacity_) {
-        debugs(48, 3, HERE << "growing idle Connection array");
-        capacity_ <<= 1;
-        const Comm::ConnectionPointer *oldList = theList_;
-        theList_ = new Comm::ConnectionPointer[capacity_];
-        for (int index = 0; index < size_; ++index)
-            theList_[index] = oldList[index];
-
-        delete[] oldList;
-    }
+    IdleConn *idle = new IdleConn(conn, this);
+    idle->older = newest_;
+    if (newest_)
+        newest_->newer = idle;
+    else
+        oldest_ = idle;
+    newest_ = idle;
+    ++size_;
 
     if (parent_)
-        parent_->noteConnectionAdded();
+        parent_->noteConnectionAdded(idle);
 
-    theList_[size_] = conn;
-    ++size_;
     AsyncCall::Pointer readCall = commCbCall(5,4, "IdleConnList::Read",
-                                  CommIoCbPtrFun(IdleConnList::Read, this));
+                                  CommIoCbPtrFun(IdleConnList::Read, idle));
     comm_read(conn, fakeReadBuf_, sizeof(fakeReadBuf_), readCall);
     AsyncCall::Pointer timeoutCall = commCbCall(5,4, "IdleConnList::Timeout",
-                                     CommTimeoutCbPtrFun(IdleConnList::Timeout, this));
+                                     CommTimeoutCbPtrFun(IdleConnList::Timeout, idle));
     commSetConnTimeout(conn, Config.Timeout.serverIdlePconn, timeoutCall);
 }
 
 /// Determine whether an entry in the idle list is available for use.
 /// Returns false if the entry is unset, closed or closing.
 bool
-IdleConnList::isAvailable(int i) const
+IdleConnList::isAvailable(const IdleConn *idle) const
 {
-    const Comm::ConnectionPointer &conn = theList_[i];
+    const Comm::ConnectionPointer &conn = idle->conn;
 
     // connection already closed. useless.
     if (!Comm::IsConnOpen(conn))
@@ -200,28 +171,33 @@ IdleConnList::isAvailable(int i) const
     if (!COMMIO_FD_READCB(conn->fd)->active())
         return false;
 
+    // our connection timeout handler is scheduled to run already. unsafe for now.
+    // TODO: cancel the pending timeout callback and allow re-use of the conn.
+    if (fd_table[conn->fd].timeoutHandler == NULL)
+        return false;
+
     return true;
 }
 
+/// pops the listed connection for reuse; may delete this
 Comm::ConnectionPointer
-IdleConnList::pop()
+IdleConnList::take(IdleConn *idle)
 {
-    for (int i=size_-1; i>=0; --i) {
-
-        if (!isAvailable(i))
-            continue;
-
-        // our connection timeout handler is scheduled to run already. unsafe for now.
-        // TODO: cancel the pending timeout callback and allow re-use of the conn.
-        if (fd_table[theList_[i]->fd].timeoutHandler == NULL)
-            continue;
+    Comm::ConnectionPointer result = idle->conn;
+    if (parent_)
+        parent_->noteReuse(*idle);
+    clearHandlers(idle);
+    /* may delete this */
+    remove(idle);
+    return result;
+}
 
-        // finally, a match. pop and return it.
-        Comm::ConnectionPointer result = theList_[i];
-        clearHandlers(result);
-        /* may delete this */
-        removeAt(i);
-        return result;
+Comm::ConnectionPointer
+IdleConnList::pop()
+{
+    for (IdleConn *idle = newest_; idle; idle = idle->older) {
+        if (isAvailable(idle))
+            return take(idle);
     }
 
     return Comm::ConnectionPointer();
@@ -244,30 +220,21 @@ IdleConnList::findUseable(const Comm::ConnectionPointer &key)
     const bool keyCheckAddr = !key->local.isAnyAddr();
     const bool keyCheckPort = key->local.port() > 0;
 
-    for (int i=size_-1; i>=0; --i) {
+    for (IdleConn *idle = newest_; idle; idle = idle->older) {
 
-        if (!isAvailable(i))
+        if (!isAvailable(idle))
             continue;
 
         // local end port is required, but dont match.
-        if (keyCheckPort && key->local.port() != theList_[i]->local.port())
+        if (keyCheckPort && key->local.port() != idle->conn->local.port())
             continue;
 
         // local address is required, but does not match.
-        if (keyCheckAddr && key->local.matchIPAddr(theList_[i]->local) != 0)
-            continue;
-
-        // our connection timeout handler is scheduled to run already. unsafe for now.
-        // TODO: cancel the pending timeout callback and allow re-use of the conn.
-        if (fd_table[theList_[i]->fd].timeoutHandler == NULL)
+        if (keyCheckAddr && key->local.matchIPAddr(idle->conn->local) != 0)
             continue;
 
         // finally, a match. pop and return it.
-        Comm::ConnectionPointer result = theList_[i];
-        clearHandlers(result);
-        /* may delete this */
-        removeAt(i);
-        return result;
+        return take(idle);
     }
 
     return Comm::ConnectionPointer();
@@ -275,17 +242,13 @@ IdleConnList::findUseable(const Comm::ConnectionPointer &key)
 
 /* might delete list */
 void
-IdleConnList::findAndClose(const Comm::ConnectionPointer &conn)
-{
-    const int index = findIndexOf(conn);
-    if (index >= 0) {
-        if (parent_)
-            parent_->notifyManager("idle conn closure");
-        clearHandlers(conn);
-        /* might delete this */
-        removeAt(index);
-        conn->close();
+IdleConnList::findAndClose(IdleConn *idle)
+{
+    if (parent_) {
+        parent_->notifyManager("idle conn closure");
+        parent_->noteIdleClosure();
     }
+    close(idle);
 }
 
 void
@@ -299,18 +262,18 @@ IdleConnList::Read(const Comm::ConnectionPointer &conn, char *buf, size_t len, C
         return;
     }
 
-    IdleConnList *list = (IdleConnList *) data;
-    /* may delete list/data */
-    list->findAndClose(conn);
+    IdleConn *idle = static_cast<IdleConn *>(data);
+    /* may delete list */
+    idle->list->findAndClose(idle);
 }
 
 void
 IdleConnList::Timeout(const CommTimeoutCbParams &io)
 {
     debugs(48, 3, HERE << io.conn);
-    IdleConnList *list = static_cast<IdleConnList *>(io.data);
-    /* may delete list/data */
-    list->findAndClose(io.conn);
+    IdleConn *idle = static_cast<IdleConn *>(io.data);
+    /* may delete list */
+    idle->list->findAndClose(idle);
 }
 
 /* ========== PconnPool PRIVATE FUNCTIONS ============================================ */
@@ -348,6 +311,21 @@ PconnPool::dumpHist(StoreEntry * e) const
     }
 }
 
+void
+PconnPool::dumpReuse(StoreEntry *e) const
+{
+    storeAppendPrintf(e, "%s idle connection reuse:\n", descr);
+    storeAppendPrintf(e, "\tIdle connections: %d\n", theCount);
+    storeAppendPrintf(e, "\tPushed:\t%" PRIu64 "\n", stats.pushes);
+    const uint64_t pops = stats.hits + stats.misses;
+    storeAppendPrintf(e, "\tReused:\t%" PRIu64 " (%.2f%% of %" PRIu64 " lookups)\n",
+                      stats.hits, Math::doublePercent(stats.hits, pops), pops);
+    storeAppendPrintf(e, "\tClosed while idle:\t%" PRIu64 "\n", stats.closures);
+    storeAppendPrintf(e, "\tEvicted by limits:\t%" PRIu64 "\n", stats.evictions);
+    storeAppendPrintf(e, "\tIdle time before reuse (msec):\n");
+    idleTimes.dump(e, NULL);
+}
+
 void
 PconnPool::dumpHash(StoreEntry *e) const
 {
@@ -366,7 +344,9 @@ PconnPool::dumpHash(StoreEntry *e) const
 PconnPool::PconnPool(const char *aDescr, const CbcPointer<PeerPoolMgr> &aMgr):
     table(NULL), descr(aDescr),
     mgr(aMgr),
-    theCount(0)
+    theCount(0),
+    lruOldest(NULL),
+    lruNewest(NULL)
 {
     int i;
     table = hash_create((HASHCMP *) strcmp, 229, hash_string);
@@ -374,6 +354,9 @@ PconnPool::PconnPool(const char *aDescr, const CbcPointer<PeerPoolMgr> &aMgr):
     for (i = 0; i < PCONN_HIST_SZ; ++i)
         hist[i] = 0;
 
+    memset(&stats, 0, sizeof(stats));
+    idleTimes.logInit(100, 0.0, 3600000.0);
+
     PconnModule::GetInstance()->add(this);
 }
 
@@ -417,6 +400,7 @@ PconnPool::push(const Comm::ConnectionPointer &conn, const char *domain)
     }
 
     list->push(conn);
+    ++stats.pushes;
     assert(!comm_has_incomplete_write(conn->fd));
 
     LOCAL_ARRAY(char, desc, FD_DESC_SZ);
@@ -424,6 +408,9 @@ PconnPool::push(const Comm::ConnectionPointer &conn, const char *domain)
     fd_note(conn->fd, desc);
     debugs(48, 3, HERE << "pushed " << conn << " for " << aKey);
 
+    /* may delete list */
+    enforceLimits(list);
+
     // successful push notifications resume multi-connection opening sequence
     notifyManager("push");
 }
@@ -437,6 +424,7 @@ PconnPool::pop(const Comm::ConnectionPointer &dest, const char *domain, bool kee
     IdleConnList *list = (IdleConnList *)hash_lookup(table, aKey);
     if (list == NULL) {
         debugs(48, 3, HERE << "lookup for key {" << aKey << "} failed.");
+        ++stats.misses;
         // failure notifications resume standby conn creation after fdUsageHigh
         notifyManager("pop failure");
         return Comm::ConnectionPointer();
@@ -447,6 +435,8 @@ PconnPool::pop(const Comm::ConnectionPointer &dest, const char *domain, bool kee
 
     /* may delete list */
     Comm::ConnectionPointer popped = list->findUseable(dest);
+    if (popped == NULL)
+        ++stats.misses;
     if (!keepOpen && Comm::IsConnOpen(popped))
         popped->close();
 
@@ -465,32 +455,78 @@ PconnPool::notifyManager(const char *reason)
 void
 PconnPool::closeN(int n)
 {
-    hash_table *hid = table;
-    hash_first(hid);
+    for (int i = 0; i < n && lruOldest; ++i) {
+        // may delete lruOldest->list
+        lruOldest->list->close(lruOldest);
+    }
+}
 
-    // close N connections, one per list, to treat all lists "fairly"
-    for (int i = 0; i < n && count(); ++i) {
+/// closes least recently used connections above the configured idle limits
+void
+PconnPool::enforceLimits(IdleConnList *list)
+{
+    // standby pools are sized by their PeerPoolMgr
+    if (mgr.set())
+        return;
 
-        hash_link *current = hash_next(hid);
-        if (!current) {
-            hash_first(hid);
-            current = hash_next(hid);
-            Must(current); // must have one because the count() was positive
-        }
+    const int perDestination = Config.pconn.idleLimitPerDestination;
+    if (perDestination > 0 && list->count() > perDestination) {
+        const int excess = list->count() - perDestination;
+        debugs(48, 3, "closing " << excess << " idle connections to " << hashKeyStr(&list->hash));
+        stats.evictions += excess;
+        list->closeN(excess); // leaves perDestination connections in the list
+    }
 
-        // may delete current
-        reinterpret_cast<IdleConnList*>(current)->closeN(1);
+    const int total = Config.pconn.idleLimit;
+    if (total > 0 && theCount > total) {
+        const int excess = theCount - total;
+        debugs(48, 3, "closing " << excess << " idle " << descr << " connections");
+        stats.evictions += excess;
+        closeN(excess);
     }
 }
 
 void
 PconnPool::unlinkList(IdleConnList *list)
 {
-    theCount -= list->count();
-    assert(theCount >= 0);
     hash_remove_link(table, &list->hash);
 }
 
+void
+PconnPool::noteConnectionAdded(IdleConn *idle)
+{
+    idle->olderInPool = lruNewest;
+    if (lruNewest)
+        lruNewest->newerInPool = idle;
+    else
+        lruOldest = idle;
+    lruNewest = idle;
+    ++theCount;
+}
+
+void
+PconnPool::noteConnectionRemoved(IdleConn *idle)
+{
+    assert(theCount > 0);
+    if (idle->olderInPool)
+        idle->olderInPool->newerInPool = idle->newerInPool;
+    else
+        lruOldest = idle->newerInPool;
+    if (idle->newerInPool)
+        idle->newerInPool->olderInPool = idle->olderInPool;
+    else
+        lruNewest = idle->olderInPool;
+    idle->olderInPool = idle->newerInPool = NULL;
+    --theCount;
+}
+
+void
+PconnPool::noteReuse(const IdleConn &idle)
+{
+    ++stats.hits;
+    idleTimes.count(tvSubMsec(idle.pushed, current_time));
+}
+
 void
 PconnPool::noteUses(int uses)
 {
@@ -549,6 +585,8 @@ PconnModule::dump(StoreEntry *e)
         // TODO: Let each pool dump itself the way it wants to.
         storeAppendPrintf(e, "\n Pool %d Stats\n", i);
         (*p)->dumpHist(e);
+        storeAppendPrintf(e, "\n");
+        (*p)->dumpReuse(e);
         storeAppendPrintf(e, "\n Pool %d Hash Table\n",i);
         (*p)->dumpHash(e);
     }
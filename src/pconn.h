@@ -19,6 +19,7 @@
  \todo CLEANUP: Break multiple classes out of the generic pconn.h header
  */
 
+class IdleConnList;
 class PconnPool;
 class PeerPoolMgr;
 
@@ -28,10 +29,33 @@ class PeerPoolMgr;
 #include "hash.h"
 /* for IOCB */
 #include "comm.h"
+#include "StatHist.h"
 
 /// \ingroup PConnAPI
 #define PCONN_HIST_SZ (1<<16)
 
+/** \ingroup PConnAPI
+ * An idle connection linked into its IdleConnList and, if that list belongs
+ * to a PconnPool, into the pool-wide least-recently-used list.
+ */
+class IdleConn
+{
+public:
+    IdleConn(const Comm::ConnectionPointer &aConn, IdleConnList *aList);
+
+    Comm::ConnectionPointer conn;
+    IdleConnList *list; ///< the destination list holding us
+    struct timeval pushed; ///< when the connection became idle
+
+    IdleConn *older; ///< the previous connection in our list
+    IdleConn *newer; ///< the next connection in our list
+    IdleConn *olderInPool; ///< the previous connection in the pool LRU list
+    IdleConn *newerInPool; ///< the next connection in the pool LRU list
+
+private:
+    CBDATA_CLASS2(IdleConn);
+};
+
 /** \ingroup PConnAPI
  * A list of connections currently open to a particular destination end-point.
  */
@@ -55,16 +79,19 @@ public:
      */
     Comm::ConnectionPointer findUseable(const Comm::ConnectionPointer &key);
 
-    void clearHandlers(const Comm::ConnectionPointer &conn);
+    void clearHandlers(IdleConn *idle);
 
     int count() const { return size_; }
+    /// closes the n oldest connections; may delete us
     void closeN(size_t count);
+    /// closes the given listed connection; may delete us
+    void close(IdleConn *idle);
 
 private:
-    bool isAvailable(int i) const;
-    bool removeAt(int index);
-    int findIndexOf(const Comm::ConnectionPointer &conn) const;
-    void findAndClose(const Comm::ConnectionPointer &conn);
+    bool isAvailable(const IdleConn *idle) const;
+    void remove(IdleConn *idle);
+    Comm::ConnectionPointer take(IdleConn *idle);
+    void findAndClose(IdleConn *idle);
     static IOCB Read;
     static CTCB Timeout;
 
@@ -72,16 +99,14 @@ public:
     hash_link hash;             /** must be first */
 
 private:
-    /** List of connections we are holding.
-     * Sorted as FIFO list for most efficient speeds on pop() and findUsable()
-     * The worst-case pop() and scans occur on timeout and link closure events
-     * where timing is less critical. Occasional slow additions are okay.
+    /** List of connections we are holding, from oldest to newest.
+     * pop() and findUseable() start with the newest connection. Timeouts,
+     * link closures, and limits remove connections without searching.
      */
-    Comm::ConnectionPointer *theList_;
+    IdleConn *oldest_;
+    IdleConn *newest_;
 
-    /// Number of entries theList can currently hold without re-allocating (capacity).
-    int capacity_;
-    ///< Number of in-use entries in theList
+    ///< Number of connections in the list
     int size_;
 
     /** The pool containing this sub-list.
@@ -138,11 +163,16 @@ public:
     void dumpHash(StoreEntry *e) const;
     void unlinkList(IdleConnList *list);
     void noteUses(int uses);
-    /// closes any n connections, regardless of their destination
+    /// closes the n least recently used connections, regardless of their destination
     void closeN(int n);
     int count() const { return theCount; }
-    void noteConnectionAdded() { ++theCount; }
-    void noteConnectionRemoved() { assert(theCount > 0); --theCount; }
+    void noteConnectionAdded(IdleConn *idle);
+    void noteConnectionRemoved(IdleConn *idle);
+    /// an idle connection is about to be reused
+    void noteReuse(const IdleConn &idle);
+    /// an idle connection was closed by the server or timed out
+    void noteIdleClosure() { ++stats.closures; }
+    void dumpReuse(StoreEntry *e) const;
 
     // sends an async message to the pool manager, if any
     void notifyManager(const char *reason);
@@ -151,11 +181,26 @@ private:
 
     static const char *key(const Comm::ConnectionPointer &destLink, const char *domain);
 
+    void enforceLimits(IdleConnList *list);
+
     int hist[PCONN_HIST_SZ];
     hash_table *table;
     const char *descr;
     CbcPointer<PeerPoolMgr> mgr; ///< optional pool manager (for notifications)
     int theCount; ///< the number of pooled connections
+
+    IdleConn *lruOldest; ///< the least recently pushed idle connection
+    IdleConn *lruNewest; ///< the most recently pushed idle connection
+
+    /// idle connection reuse statistics
+    struct Stats {
+        uint64_t pushes; ///< connections that became idle
+        uint64_t hits; ///< pop() calls that found a usable connection
+        uint64_t misses; ///< pop() calls that did not
+        uint64_t closures; ///< idle connections closed by servers or timeouts
+        uint64_t evictions; ///< idle connections closed to stay within limits
+    } stats;
+    StatHist idleTimes; ///< msec reused connections spent idle
 };
 
 class StoreEntry;
@@ -35,6 +35,8 @@
 #include "Store.h"
 #include "URL.h"
 
+#include <vector>
+
 static struct {
     int timeouts;
 } PeerStats;
@@ -324,12 +326,33 @@ peerSelectDnsResults(const ipcache_addrs *ia, const DnsLookupDetails &details, v
 
         assert(ia->cur < ia->count);
 
-        // loop over each result address, adding to the possible destinations.
+        // When connection racing is enabled, alternate address families,
+        // starting with the one that works better (or IPv4 if dns_v4_first
+        // says so), so that FwdState has an address of the other family to
+        // race against a slow connection attempt (and so that
+        // forward_max_tries does not leave one of the families out).
+        // Otherwise, keep the DNS order.
+        const bool racing = Config.Timeout.happyEyeballsConnect > 0;
+        const bool ipv4First = Config.dns.v4_first || ipcacheIpv4First(ia);
+        std::vector<int> first, second;
         int ip = ia->cur;
         for (int n = 0; n < ia->count; ++n, ++ip) {
+            if (ip >= ia->count) ip = 0; // looped back to zero.
+            if (!racing || ia->in_addrs[ip].isIPv4() == ipv4First)
+                first.push_back(ip);
+            else
+                second.push_back(ip);
+        }
+
+        // loop over each result address, adding to the possible destinations.
+        for (size_t n = 0; n < first.size() + second.size(); ++n) {
             Comm::ConnectionPointer p;
 
-            if (ip >= ia->count) ip = 0; // looped back to zero.
+            const size_t pairs = min(first.size(), second.size());
+            if (n < 2 * pairs)
+                ip = (n % 2) ? second[n / 2] : first[n / 2];
+            else
+                ip = first.size() > pairs ? first[n - pairs] : second[n - pairs];
 
             // Enforce forward_max_tries configuration.
             if (psstate->paths->size() >= (unsigned int)Config.forward_max_tries)
@@ -13,6 +13,8 @@
 #endif
 
 #include "squid.h"
+#include "base/RegexSet.h"
+#include "base/RunnersRegistry.h"
 #include "HttpHdrCc.h"
 #include "HttpReply.h"
 #include "HttpRequest.h"
@@ -94,6 +96,40 @@ static int refreshStaleness(const StoreEntry * entry, time_t check_time, const t
 
 static RefreshPattern DefaultRefresh;
 
+/// refresh_pattern regexes for regex_prefilter, indexed like RefreshRules
+static RegexSet *RefreshRegexes = NULL;
+/// Config.Refresh rules, in order, for mapping RefreshRegexes matches
+static std::vector<const RefreshPattern *> RefreshRules;
+
+/// (re)builds RefreshRegexes from the current configuration
+static void
+refreshSyncPatterns()
+{
+    delete RefreshRegexes;
+    RefreshRegexes = NULL;
+    RefreshRules.clear();
+
+    if (!Config.onoff.regex_prefilter)
+        return;
+
+    RefreshRegexes = new RegexSet;
+    for (const RefreshPattern *R = Config.Refresh; R; R = R->next) {
+        RefreshRegexes->add(R->pattern, REG_EXTENDED | REG_NOSUB | (R->flags.icase ? REG_ICASE : 0));
+        RefreshRules.push_back(R);
+    }
+    RefreshRegexes->compile();
+}
+
+/// keeps refresh_pattern lookup structures in sync with squid.conf
+class RefreshRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    virtual void useConfig() { refreshSyncPatterns(); }
+    virtual void syncConfig() { refreshSyncPatterns(); }
+};
+RunnerRegistrationEntry(RefreshRr);
+
 /** Locate the first refresh_pattern rule that matches the given URL by regex.
  *
  * \note regexec() returns 0 if matched, and REG_NOMATCH otherwise
@@ -103,6 +139,11 @@ static RefreshPattern DefaultRefresh;
 const RefreshPattern *
 refreshLimits(const char *url)
 {
+    if (RefreshRegexes) {
+        const int i = RefreshRegexes->match(url);
+        return i < 0 ? NULL : RefreshRules[i];
+    }
+
     const RefreshPattern *R;
 
     for (R = Config.Refresh; R; R = R->next) {
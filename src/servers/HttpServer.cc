@@ -114,8 +114,11 @@ Http::Server::parseOneRequest(Http::ProtocolVersion &ver)
 {
     ClientSocketContext *context = NULL;
     PROF_start(HttpServer_parseOneRequest);
-    HttpParserInit(&parser_, in.buf.c_str(), in.buf.length());
+    // after a partial parse, in.buf only grew, so skip already scanned bytes
+    parser_.resume(in.buf.c_str(), in.buf.length());
     context = parseHttpRequest(this, &parser_, &method_, &ver);
+    if (!context)
+        parser_.state = HTTP_PARSE_MORE;
     PROF_stop(HttpServer_parseOneRequest);
     return context;
 }
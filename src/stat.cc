@@ -1015,6 +1015,7 @@ GetAvgStat(Mgr::IntervalActionData& stats, int minutes, int hours)
     stats.syscalls_sock_closes = XAVG(syscalls.sock.closes);
     stats.syscalls_sock_reads = XAVG(syscalls.sock.reads);
     stats.syscalls_sock_writes = XAVG(syscalls.sock.writes);
+    stats.syscalls_sock_sendfiles = XAVG(syscalls.sock.sendfiles);
     stats.syscalls_sock_recvfroms = XAVG(syscalls.sock.recvfroms);
     stats.syscalls_sock_sendtos = XAVG(syscalls.sock.sendtos);
     stats.syscalls_selects = XAVG(syscalls.selects);
@@ -1168,6 +1169,7 @@ DumpAvgStat(Mgr::IntervalActionData& stats, StoreEntry* sentry)
     storeAppendPrintf(sentry, "syscalls.sock.closes = %f/sec\n", stats.syscalls_sock_closes);
     storeAppendPrintf(sentry, "syscalls.sock.reads = %f/sec\n", stats.syscalls_sock_reads);
     storeAppendPrintf(sentry, "syscalls.sock.writes = %f/sec\n", stats.syscalls_sock_writes);
+    storeAppendPrintf(sentry, "syscalls.sock.sendfiles = %f/sec\n", stats.syscalls_sock_sendfiles);
     storeAppendPrintf(sentry, "syscalls.sock.recvfroms = %f/sec\n", stats.syscalls_sock_recvfroms);
     storeAppendPrintf(sentry, "syscalls.sock.sendtos = %f/sec\n", stats.syscalls_sock_sendtos);
 
@@ -1440,6 +1442,8 @@ GetCountersStats(Mgr::CountersActionData& stats)
     stats.client_http_kbytes_in = f->client_http.kbytes_in.kb;
     stats.client_http_kbytes_out = f->client_http.kbytes_out.kb;
     stats.client_http_hit_kbytes_out = f->client_http.hit_kbytes_out.kb;
+    stats.client_http_sendfile_writes = f->client_http.sendfile_writes;
+    stats.client_http_sendfile_kbytes_out = f->client_http.sendfile_kbytes_out.kb;
 
     stats.server_all_requests = f->server.all.requests;
     stats.server_all_errors = f->server.all.errors;
@@ -1518,6 +1522,10 @@ DumpCountersStats(Mgr::CountersActionData& stats, StoreEntry* sentry)
                       stats.client_http_kbytes_out);
     storeAppendPrintf(sentry, "client_http.hit_kbytes_out = %.0f\n",
                       stats.client_http_hit_kbytes_out);
+    storeAppendPrintf(sentry, "client_http.sendfile_writes = %.0f\n",
+                      stats.client_http_sendfile_writes);
+    storeAppendPrintf(sentry, "client_http.sendfile_kbytes_out = %.0f\n",
+                      stats.client_http_sendfile_kbytes_out);
 
     storeAppendPrintf(sentry, "server.all.requests = %.0f\n",
                       stats.server_all_requests);
@@ -15,6 +15,29 @@
 #include "profiler/Profiler.h"
 #include "stmem.h"
 
+#include <algorithm>
+
+/// whether location precedes the first byte of aNode
+static bool
+LocationBeforeNodeStart(int64_t const &location, mem_node * const &aNode)
+{
+    return location < aNode->start();
+}
+
+/// whether aNode starts before location
+static bool
+NodeStartBeforeLocation(mem_node * const &aNode, int64_t const &location)
+{
+    return aNode->start() < location;
+}
+
+/// whether location precedes the byte after the last byte of aNode
+static bool
+LocationBeforeNodeEnd(int64_t const &location, mem_node * const &aNode)
+{
+    return location < aNode->end();
+}
+
 /*
  * NodeGet() is called to get the data buffer to pass to storeIOWrite().
  * By setting the write_pending flag here we are assuming that there
@@ -33,10 +56,8 @@ mem_hdr::NodeGet(mem_node * aNode)
 int64_t
 mem_hdr::lowestOffset () const
 {
-    const SplayNode<mem_node *> *theStart = nodes.start();
-
-    if (theStart)
-        return theStart->data->nodeBuffer.offset;
+    if (!nodes.empty())
+        return nodes.front()->nodeBuffer.offset;
 
     return 0;
 }
@@ -45,10 +66,8 @@ int64_t
 mem_hdr::endOffset () const
 {
     int64_t result = 0;
-    const SplayNode<mem_node *> *theEnd = nodes.finish();
-
-    if (theEnd)
-        result = theEnd->data->dataRange().end;
+    if (!nodes.empty())
+        result = nodes.back()->dataRange().end;
 
     assert (result == inmem_hi);
 
@@ -58,7 +77,9 @@ mem_hdr::endOffset () const
 void
 mem_hdr::freeContent()
 {
-    nodes.destroy();
+    for (Nodes::iterator i = nodes.begin(); i != nodes.end(); ++i)
+        mem_node::Release(*i);
+    nodes.clear();
     inmem_hi = 0;
     debugs(19, 9, HERE << this << " hi: " << inmem_hi);
 }
@@ -72,8 +93,15 @@ mem_hdr::unlink(mem_node *aNode)
     }
 
     debugs(19, 8, this << " removing " << aNode);
-    nodes.remove (aNode, NodeCompare);
-    delete aNode;
+    if (!nodes.empty() && nodes.front() == aNode) {
+        nodes.pop_front(); // the common freeDataUpto() case
+    } else {
+        const Nodes::iterator i = std::lower_bound(nodes.begin(), nodes.end(),
+                                  aNode->start(), NodeStartBeforeLocation);
+        assert(i != nodes.end() && *i == aNode);
+        nodes.erase(i);
+    }
+    mem_node::Release(aNode);
     return true;
 }
 
@@ -82,16 +110,13 @@ mem_hdr::freeDataUpto(int64_t target_offset)
 {
     debugs(19, 8, this << " up to " << target_offset);
     /* keep the last one to avoid change to other part of code */
-    SplayNode<mem_node*> const * theStart;
+    while (nodes.size() > 1) {
+        mem_node *theStart = nodes.front();
 
-    while ((theStart = nodes.start())) {
-        if (theStart == nodes.finish())
+        if (theStart->end() > target_offset )
             break;
 
-        if (theStart->data->end() > target_offset )
-            break;
-
-        if (!unlink(theStart->data))
+        if (!unlink(theStart))
             break;
     }
 
@@ -136,7 +161,15 @@ mem_hdr::writeAvailable(mem_node *aNode, int64_t location, size_t amount, char c
 void
 mem_hdr::appendNode (mem_node *aNode)
 {
-    nodes.insert (aNode, NodeCompare);
+    if (nodes.empty() || nodes.back()->start() < aNode->start()) {
+        nodes.push_back(aNode);
+        return;
+    }
+
+    /* filling a hole in a sparse object */
+    const Nodes::iterator pos = std::upper_bound(nodes.begin(), nodes.end(),
+                                aNode->start(), LocationBeforeNodeStart);
+    nodes.insert(pos, aNode);
 }
 
 void
@@ -147,10 +180,10 @@ mem_hdr::makeAppendSpace()
         return;
     }
 
-    if (!nodes.finish()->data->space())
+    if (!nodes.back()->space())
         appendNode (new mem_node (endOffset()));
 
-    assert (nodes.finish()->data->space());
+    assert (nodes.back()->space());
 }
 
 void
@@ -160,7 +193,7 @@ mem_hdr::internalAppend(const char *data, int len)
 
     while (len > 0) {
         makeAppendSpace();
-        int copied = appendToNode (nodes.finish()->data, data, len);
+        int copied = appendToNode (nodes.back(), data, len);
         assert (copied);
 
         len -= copied;
@@ -168,19 +201,36 @@ mem_hdr::internalAppend(const char *data, int len)
     }
 }
 
+/// the first node whose data ends after location, or nodes.end()
+mem_hdr::Nodes::const_iterator
+mem_hdr::firstEndingAfter(int64_t location) const
+{
+    // nodes do not overlap, so their ends are sorted just like their starts
+    return std::upper_bound(nodes.begin(), nodes.end(), location, LocationBeforeNodeEnd);
+}
+
 /* returns a mem_node that contains location..
  * If no node contains the start, it returns NULL.
  */
 mem_node *
 mem_hdr::getBlockContainingLocation (int64_t location) const
 {
-    // Optimize: do not create a whole mem_node just to store location
-    mem_node target (location);
-    target.nodeBuffer.length = 1;
-    mem_node *const *result = nodes.find (&target, NodeCompare);
+    if (nodes.empty())
+        return NULL;
+
+    // Objects received in order consist of full pages, so the page index
+    // is usually just the distance from the first node.
+    const int64_t first = nodes.front()->start();
+    if (location >= first) {
+        const uint64_t guess = (location - first) / SM_PAGE_SIZE;
+        if (guess < nodes.size() && nodes[guess]->contains(location))
+            return nodes[guess];
+    }
 
-    if (result)
-        return *result;
+    // sparse or partially filled content; fall back to a binary search
+    const Nodes::const_iterator i = firstEndingAfter(location);
+    if (i != nodes.end() && (*i)->contains(location))
+        return *i;
 
     return NULL;
 }
@@ -210,7 +260,7 @@ mem_hdr::debugDump() const
     debugs (19, 0, "mem_hdr::debugDump: lowest offset: " << lowestOffset() << " highest offset + 1: " << endOffset() << ".");
     std::ostringstream result;
     PointerPrinter<mem_node *> foo(result, " - ");
-    getNodes().visit(foo);
+    std::for_each(nodes.begin(), nodes.end(), foo);
     debugs (19, 0, "mem_hdr::debugDump: Current available data is: " << result.str() << ".");
 }
 
@@ -279,6 +329,22 @@ mem_hdr::copy(StoreIOBuffer const &target) const
     return target.length - bytes_to_go;
 }
 
+mem_node *
+mem_hdr::lend(StoreIOBuffer &target) const
+{
+    assert(target.length > 0);
+    mem_node *p = getBlockContainingLocation(target.offset);
+    if (!p)
+        return NULL;
+
+    const size_t pageOffset = target.offset - p->nodeBuffer.offset;
+    target.data = p->nodeBuffer.data + pageOffset;
+    target.length = min(target.length, p->nodeBuffer.length - pageOffset);
+    p->pin();
+    debugs(19, 6, this << " lends " << target.range() << " of " << *p);
+    return p;
+}
+
 bool
 mem_hdr::hasContigousContentRange(Range<int64_t> const & range) const
 {
@@ -298,9 +364,11 @@ bool
 mem_hdr::unionNotEmpty(StoreIOBuffer const &candidate)
 {
     assert (candidate.offset >= 0);
-    mem_node target(candidate.offset);
-    target.nodeBuffer.length = candidate.length;
-    return nodes.find (&target, NodeCompare);
+    if (!candidate.length)
+        return false;
+
+    const Nodes::const_iterator i = firstEndingAfter(candidate.offset);
+    return i != nodes.end() && (*i)->start() < candidate.offset + static_cast<int64_t>(candidate.length);
 }
 
 mem_node *
@@ -310,20 +378,14 @@ mem_hdr::nodeToRecieve(int64_t offset)
 
     if (!nodes.size()) {
         appendNode (new mem_node(offset));
-        return nodes.start()->data;
+        return nodes.front();
     }
 
     mem_node *candidate = NULL;
     /* case 2: location fits within an extant node */
 
-    if (offset > 0) {
-        mem_node search (offset - 1);
-        search.nodeBuffer.length = 1;
-        mem_node *const *leadup =  nodes.find (&search, NodeCompare);
-
-        if (leadup)
-            candidate = *leadup;
-    }
+    if (offset > 0)
+        candidate = getBlockContainingLocation(offset - 1);
 
     if (candidate && candidate->canAccept(offset))
         return candidate;
@@ -380,27 +442,11 @@ mem_hdr::~mem_hdr()
     freeContent();
 }
 
-/* splay of mem nodes:
- * conditions:
- * a = b if a.intersection(b).size > 0;
- * a < b if a < b
- */
-int
-mem_hdr::NodeCompare(mem_node * const &left, mem_node * const &right)
-{
-    // possibly Range can help us at some point.
-
-    if (left->dataRange().intersection(right->dataRange()).size() > 0)
-        return 0;
-
-    return *left < *right ? -1 : 1;
-}
-
 void
 mem_hdr::dump() const
 {
-    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.start() " << nodes.start());
-    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " nodes.finish() " << nodes.finish());
+    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " first node " << start());
+    debugs(20, DBG_IMPORTANT, "mem_hdr: " << (void *)this << " last node " << (nodes.empty() ? NULL : nodes.back()));
 }
 
 size_t
@@ -412,15 +458,13 @@ mem_hdr::size() const
 mem_node const *
 mem_hdr::start() const
 {
-    const SplayNode<mem_node *> * result = nodes.start();
-
-    if (result)
-        return result->data;
+    if (!nodes.empty())
+        return nodes.front();
 
     return NULL;
 }
 
-const Splay<mem_node *> &
+const mem_hdr::Nodes &
 mem_hdr::getNodes() const
 {
     return nodes;
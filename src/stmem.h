@@ -10,16 +10,22 @@
 #define SQUID_STMEM_H
 
 #include "Range.h"
-#include "splay.h"
+
+#include <deque>
 
 class mem_node;
 
 class StoreIOBuffer;
 
+/// In-memory object content, kept as a sequence of SM_PAGE_SIZE mem_nodes
+/// ordered by offset. Lookups never reorder the sequence, so concurrent
+/// readers of one object do not disturb each other.
 class mem_hdr
 {
 
 public:
+    typedef std::deque<mem_node *> Nodes;
+
     mem_hdr();
     ~mem_hdr();
     void freeContent();
@@ -27,6 +33,10 @@ public:
     int64_t endOffset () const;
     int64_t freeDataUpto (int64_t);
     ssize_t copy (StoreIOBuffer const &) const;
+    /// Points target at the stored bytes at target.offset, trimming its
+    /// length to the single page that holds them, instead of copying.
+    /// \returns the page, pinned for the caller to unpin(), or nil
+    mem_node *lend(StoreIOBuffer &target) const;
     bool hasContigousContentRange(Range<int64_t> const &range) const;
     /* success or fail */
     bool write (StoreIOBuffer const &);
@@ -38,14 +48,12 @@ public:
     /* access the contained nodes - easier than punning
      * as a contianer ourselves
      */
-    const Splay<mem_node *> &getNodes() const;
+    const Nodes &getNodes() const;
     char * NodeGet(mem_node * aNode);
 
     /* Only for use of MemObject */
     void internalAppend(const char *data, int len);
 
-    static Splay<mem_node *>::SPLAYCMP NodeCompare;
-
 private:
     void debugDump() const;
     bool unlink(mem_node *aNode);
@@ -55,9 +63,10 @@ private:
     size_t copyAvailable(mem_node *aNode, int64_t location, size_t amount, char *target) const;
     bool unionNotEmpty (StoreIOBuffer const &);
     mem_node *nodeToRecieve(int64_t offset);
+    Nodes::const_iterator firstEndingAfter(int64_t location) const;
     size_t writeAvailable(mem_node *aNode, int64_t location, size_t amount, char const *source);
     int64_t inmem_hi;
-    Splay<mem_node *> nodes;
+    Nodes nodes; ///< non-overlapping nodes, sorted by offset
 };
 
 #endif /* SQUID_STMEM_H */
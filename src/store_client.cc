@@ -14,6 +14,7 @@
 #include "HttpReply.h"
 #include "HttpRequest.h"
 #include "MemBuf.h"
+#include "mem_node.h"
 #include "MemObject.h"
 #include "mime_header.h"
 #include "profiler/Profiler.h"
@@ -152,9 +153,11 @@ store_client::store_client(StoreEntry *e) : entry (e)
 #endif
     , type (e->storeClientType())
     ,  object_ok(true)
+    , lentPage(NULL)
 {
     cmp_offset = 0;
     flags.disk_io_pending = false;
+    flags.lend_pages = false;
     ++ entry->refcount;
 
     if (getType() == STORE_DISK_CLIENT)
@@ -170,7 +173,19 @@ store_client::store_client(StoreEntry *e) : entry (e)
 }
 
 store_client::~store_client()
-{}
+{
+    returnLentPage();
+}
+
+/// allows the store to free the page our last callback pointed into
+void
+store_client::returnLentPage()
+{
+    if (lentPage) {
+        lentPage->unpin();
+        lentPage = NULL;
+    }
+}
 
 /* copy bytes requested by the client */
 void
@@ -209,6 +224,9 @@ store_client::copy(StoreEntry * anEntry,
 
     assert(cmp_offset == copyRequest.offset);
 #endif
+    // the caller is done with the previous results
+    returnLentPage();
+
     /* range requests will skip into the body */
     cmp_offset = copyRequest.offset;
     _callback = Callback (callback_fn, cbdataReference(data));
@@ -429,6 +447,17 @@ void
 store_client::scheduleMemRead()
 {
     /* What the client wants is in memory */
+    if (flags.lend_pages) {
+        StoreIOBuffer page(copyInto);
+        if ((lentPage = entry->mem_obj->data_hdr.lend(page))) {
+            debugs(90, 3, "store_client::doCopy: Lending " << page.length << " bytes from memory");
+            copyInto.data = page.data;
+            callback(page.length);
+            flags.store_copying = false;
+            return;
+        }
+    }
+
     /* Old style */
     debugs(90, 3, "store_client::doCopy: Copying normal from memory");
     size_t sz = entry->mem_obj->data_hdr.copy(copyInto);
@@ -65,6 +65,7 @@ DelayId MemObject::mostBytesAllowed() const STUB_RETVAL(DelayId())
 void MemObject::unlinkRequest() STUB
 void MemObject::write(const StoreIOBuffer &writeBuffer) STUB
 void MemObject::replaceHttpReply(HttpReply *newrep) STUB
+HttpHeaderImage &MemObject::headerImage() STUB_RETSTATREF(HttpHeaderImage)
 int64_t MemObject::lowestMemReaderOffset() const STUB_RETVAL(0)
 void MemObject::kickReads() STUB
 int64_t MemObject::objectBytesOnDisk() const STUB_RETVAL(0)
@@ -17,6 +17,7 @@
 void SwapDir::create() STUB
 void SwapDir::dump(StoreEntry &) const STUB
 bool SwapDir::doubleCheck(StoreEntry &) STUB_RETVAL(false)
+int SwapDir::openContiguous(const StoreEntry &) STUB_RETVAL(-1)
 void SwapDir::unlink(StoreEntry &) STUB
 void SwapDir::getStats(StoreInfoStats &) const STUB
 void SwapDir::stat(StoreEntry &) const STUB
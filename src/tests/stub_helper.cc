@@ -14,6 +14,7 @@
 
 void helperSubmit(helper * hlp, const char *buf, HLPCB * callback, void *data) STUB
 void helperStatefulSubmit(statefulhelper * hlp, const char *buf, HLPCB * callback, void *data, helper_stateful_server * lastserver) STUB
+helper::helper(const char *name) STUB
 helper::~helper() STUB
 CBDATA_CLASS_INIT(helper);
 
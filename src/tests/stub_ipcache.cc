@@ -22,6 +22,8 @@ void ipcacheCycleAddr(const char *name, ipcache_addrs *) STUB
 void ipcacheMarkBadAddr(const char *name, const Ip::Address &) STUB
 void ipcacheMarkGoodAddr(const char *name, const Ip::Address &) STUB
 void ipcacheMarkAllGood(const char *name) STUB
+void ipcacheNoteConnect(const char *name, const Ip::Address &, bool connected, int msec) STUB
+bool ipcacheIpv4First(const ipcache_addrs *) STUB_RETVAL(true)
 void ipcacheFreeMemory(void) STUB
 ipcache_addrs *ipcacheCheckNumeric(const char *name) STUB_RETVAL(NULL)
 void ipcache_restart(void) STUB
@@ -14,4 +14,6 @@
 
 mem_node::mem_node(int64_t offset):nodeBuffer(0,offset,data) STUB
     size_t mem_node::InUseCount() STUB_RETVAL(0)
+void mem_node::unpin() STUB
+void mem_node::Release(mem_node *) STUB
 
@@ -20,7 +20,9 @@ IdleConnList::IdleConnList(const char *key, PconnPool *parent) STUB
 IdleConnList::~IdleConnList() STUB
 void IdleConnList::push(const Comm::ConnectionPointer &conn) STUB
 Comm::ConnectionPointer IdleConnList::findUseable(const Comm::ConnectionPointer &key) STUB_RETVAL(Comm::ConnectionPointer())
-void IdleConnList::clearHandlers(const Comm::ConnectionPointer &conn) STUB
+void IdleConnList::clearHandlers(IdleConn *) STUB
+void IdleConnList::closeN(size_t) STUB
+void IdleConnList::close(IdleConn *) STUB
 PconnPool::PconnPool(const char *, const CbcPointer<PeerPoolMgr>&) STUB
 PconnPool::~PconnPool() STUB
 void PconnPool::moduleInit() STUB
@@ -30,7 +32,11 @@ void PconnPool::count(int uses) STUB
 void PconnPool::noteUses(int) STUB
 void PconnPool::dumpHist(StoreEntry *e) const STUB
 void PconnPool::dumpHash(StoreEntry *e) const STUB
+void PconnPool::dumpReuse(StoreEntry *) const STUB
 void PconnPool::unlinkList(IdleConnList *list) STUB
+void PconnPool::noteConnectionAdded(IdleConn *) STUB
+void PconnPool::noteConnectionRemoved(IdleConn *) STUB
+void PconnPool::noteReuse(const IdleConn &) STUB
 PconnModule * PconnModule::GetInstance() STUB_RETVAL(NULL)
 void PconnModule::DumpWrapper(StoreEntry *e) STUB
 PconnModule::PconnModule() STUB
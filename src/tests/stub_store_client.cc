@@ -31,8 +31,6 @@ storeLog(int tag, const StoreEntry * e)
 }
 
 void storeLogOpen(void) STUB
-void storeDigestInit(void) STUB
-void storeRebuildStart(void) STUB
 void storeReplSetup(void) STUB
 bool store_client::memReaderHasLowerOffset(int64_t anOffset) const STUB_RETVAL(false)
 void store_client::dumpStats(MemBuf * output, int clientNumber) const STUB
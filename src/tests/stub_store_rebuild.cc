@@ -18,6 +18,7 @@
 #define STUB_API "stub_store_rebuild.cc"
 #include "tests/STUB.h"
 
+void storeRebuildStart(void) STUB
 void storeRebuildProgress(int sd_index, int total, int sofar) STUB
 bool storeRebuildKeepEntry(const StoreEntry &tmpe, const cache_key *key, StoreRebuildData &counts) STUB_RETVAL(false)
 bool storeRebuildParseEntry(MemBuf &, StoreEntry &, cache_key *, StoreRebuildData &, uint64_t) STUB_RETVAL(false)
@@ -14,10 +14,14 @@
 #include "CapturingStoreEntry.h"
 #include "event.h"
 #include "Mem.h"
+#include "SquidTime.h"
 #include "stat.h"
 #include "testEvent.h"
 #include "unitTestMain.h"
 
+#include <algorithm>
+#include <vector>
+
 CPPUNIT_TEST_SUITE_REGISTRATION( testEvent );
 
 /* init legacy static-initialized modules */
@@ -158,3 +162,129 @@ testEvent::testSingleton()
     CPPUNIT_ASSERT(NULL != scheduler);
 }
 
+
+/* Helper for tests - an event which records itself when called. */
+
+struct OrderedEvent {
+    OrderedEvent() : delay(0) {}
+
+    static void Handler(void *data) {
+        Fired.push_back(static_cast<OrderedEvent *>(data));
+    }
+
+    double delay;
+    static std::vector<OrderedEvent *> Fired;
+};
+
+std::vector<OrderedEvent *> OrderedEvent::Fired;
+
+/* run everything the scheduler has, recording the firing order */
+static void
+fireAll(EventScheduler &scheduler)
+{
+    const double savedTime = current_dtime;
+    current_dtime += 10.0;
+    CPPUNIT_ASSERT_EQUAL(int(AsyncEngine::EVENT_IDLE), scheduler.checkEvents(0));
+    current_dtime = savedTime;
+
+    OrderedEvent::Fired.clear();
+    while (AsyncCallQueue::Instance().fire());
+}
+
+/* schedule many events out of order, cancel some, and check that the rest
+ * fire in due time order.
+ */
+void
+testEvent::testOrder()
+{
+    EventScheduler scheduler;
+    const int count = 10000;
+    std::vector<OrderedEvent> events(count);
+
+    for (int i = 0; i < count; ++i) {
+        // a permutation of delays with some duplicates
+        events[i].delay = 1.0 + ((i * 7919) % (count / 2)) / 1000.0;
+        scheduler.schedule("ordered event", OrderedEvent::Handler, &events[i], events[i].delay, 0, false);
+    }
+
+    for (int i = 0; i < count; i += 10)
+        scheduler.cancel(OrderedEvent::Handler, &events[i]);
+    CPPUNIT_ASSERT_EQUAL(false, scheduler.find(OrderedEvent::Handler, &events[0]));
+    CPPUNIT_ASSERT_EQUAL(true, scheduler.find(OrderedEvent::Handler, &events[1]));
+
+    // nothing is due yet
+    CPPUNIT_ASSERT(scheduler.checkEvents(0) >= 1000);
+
+    fireAll(scheduler);
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(count - count / 10), OrderedEvent::Fired.size());
+    for (size_t i = 1; i < OrderedEvent::Fired.size(); ++i)
+        CPPUNIT_ASSERT(OrderedEvent::Fired[i - 1]->delay <= OrderedEvent::Fired[i]->delay);
+}
+
+/* cancel events from the top, the middle, and the bottom of the heap and
+ * check that only they are gone and the rest still fire in order.
+ */
+void
+testEvent::testCancelMiddle()
+{
+    EventScheduler scheduler;
+    const int count = 1000;
+    std::vector<OrderedEvent> events(count);
+
+    // scheduled in due time order, the heap keeps events in that order
+    for (int i = 0; i < count; ++i) {
+        events[i].delay = 1.0 + i / 1000.0;
+        scheduler.schedule("ordered event", OrderedEvent::Handler, &events[i], events[i].delay, 0, false);
+    }
+
+    const int cancelled[] = { count / 2, 50, 0, count - 1, 51 };
+    const size_t cancelledCount = sizeof(cancelled) / sizeof(*cancelled);
+    for (size_t i = 0; i < cancelledCount; ++i) {
+        scheduler.cancel(OrderedEvent::Handler, &events[cancelled[i]]);
+        CPPUNIT_ASSERT_EQUAL(false, scheduler.find(OrderedEvent::Handler, &events[cancelled[i]]));
+    }
+    CPPUNIT_ASSERT_EQUAL(true, scheduler.find(OrderedEvent::Handler, &events[1]));
+    CPPUNIT_ASSERT_EQUAL(true, scheduler.find(OrderedEvent::Handler, &events[count - 2]));
+
+    fireAll(scheduler);
+
+    CPPUNIT_ASSERT_EQUAL(count - cancelledCount, OrderedEvent::Fired.size());
+    for (size_t i = 0; i < cancelledCount; ++i) {
+        const OrderedEvent *event = &events[cancelled[i]];
+        CPPUNIT_ASSERT(std::find(OrderedEvent::Fired.begin(), OrderedEvent::Fired.end(), event) == OrderedEvent::Fired.end());
+    }
+    for (size_t i = 1; i < OrderedEvent::Fired.size(); ++i)
+        CPPUNIT_ASSERT(OrderedEvent::Fired[i - 1]->delay < OrderedEvent::Fired[i]->delay);
+}
+
+/* events due at the same time fire in the order they were scheduled, even
+ * when interleaved with events due earlier and later.
+ */
+void
+testEvent::testEqualDeadlines()
+{
+    EventScheduler scheduler;
+    const int count = 300;
+    std::vector<OrderedEvent> events(count);
+
+    for (int i = 0; i < count; ++i) {
+        // every third event is due earlier or later than the rest
+        events[i].delay = (i % 3 == 0) ? 1.0 + (i % 2) : 1.5;
+        scheduler.schedule("ordered event", OrderedEvent::Handler, &events[i], events[i].delay, 0, false);
+    }
+
+    // one of the equal events leaves the middle of the heap
+    scheduler.cancel(OrderedEvent::Handler, &events[count / 2 + 1]);
+
+    fireAll(scheduler);
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(count - 1), OrderedEvent::Fired.size());
+    for (size_t i = 1; i < OrderedEvent::Fired.size(); ++i) {
+        const OrderedEvent *previous = OrderedEvent::Fired[i - 1];
+        const OrderedEvent *current = OrderedEvent::Fired[i];
+        CPPUNIT_ASSERT(previous->delay <= current->delay);
+        if (previous->delay == current->delay)
+            CPPUNIT_ASSERT(previous < current); // submission order
+    }
+}
@@ -24,6 +24,9 @@ class testEvent : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testCheckEvents );
     CPPUNIT_TEST( testSingleton );
     CPPUNIT_TEST( testCancel );
+    CPPUNIT_TEST( testOrder );
+    CPPUNIT_TEST( testCancelMiddle );
+    CPPUNIT_TEST( testEqualDeadlines );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -36,6 +39,9 @@ protected:
     void testCheckEvents();
     void testSingleton();
     void testCancel();
+    void testOrder();
+    void testCancelMiddle();
+    void testEqualDeadlines();
 };
 
 #endif
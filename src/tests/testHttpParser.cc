@@ -1108,3 +1108,118 @@ testHttpParser::testParseRequestLineInvalid()
     }
 }
 
+
+/// feeds the request to the parser step bytes at a time, the way a slow
+/// client would; returns the request prefix size or zero on failure
+static size_t
+dripFeed(HttpParser &hp, const char *request, const int len, const int step, const bool resume)
+{
+    hp.clear();
+    for (int avail = min(step, len); avail <= len; avail = min(avail + step, len)) {
+        if (resume)
+            hp.resume(request, avail);
+        else
+            hp.reset(request, avail);
+
+        const int r = HttpParserParseReqLine(&hp);
+        if (r < 0)
+            return 0;
+        if (r > 0) {
+            if (const size_t prefixLen = hp.findHeadersEnd())
+                return prefixLen;
+        }
+        if (avail == len)
+            return 0;
+        hp.state = HTTP_PARSE_MORE;
+    }
+    return 0;
+}
+
+void
+testHttpParser::testParseRequestDripFeed()
+{
+    // ensure MemPools etc exist
+    globalSetup();
+
+    const char *request =
+        "GET /path?q=1 HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "Accept: */*\r\n"
+        "\r\n";
+    const int len = strlen(request);
+
+    HttpParser whole;
+    whole.reset(request, len);
+    CPPUNIT_ASSERT_EQUAL(1, HttpParserParseReqLine(&whole));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(len), whole.findHeadersEnd());
+
+    for (int step = 1; step <= len; ++step) {
+        HttpParser output;
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(len), dripFeed(output, request, len, step, true));
+        CPPUNIT_ASSERT_EQUAL(Http::scOkay, output.request_parse_status);
+        CPPUNIT_ASSERT_EQUAL(whole.req.start, output.req.start);
+        CPPUNIT_ASSERT_EQUAL(whole.req.end, output.req.end);
+        CPPUNIT_ASSERT_EQUAL(whole.req.m_start, output.req.m_start);
+        CPPUNIT_ASSERT_EQUAL(whole.req.m_end, output.req.m_end);
+        CPPUNIT_ASSERT_EQUAL(whole.req.u_start, output.req.u_start);
+        CPPUNIT_ASSERT_EQUAL(whole.req.u_end, output.req.u_end);
+        CPPUNIT_ASSERT_EQUAL(whole.req.v_start, output.req.v_start);
+        CPPUNIT_ASSERT_EQUAL(whole.req.v_end, output.req.v_end);
+        CPPUNIT_ASSERT_EQUAL(whole.req.v_maj, output.req.v_maj);
+        CPPUNIT_ASSERT_EQUAL(whole.req.v_min, output.req.v_min);
+    }
+
+    // a CR waiting for its LF at the end of the first chunk
+    {
+        HttpParser output;
+        output.reset(request, 23);
+        CPPUNIT_ASSERT_EQUAL(0, HttpParserParseReqLine(&output));
+        output.state = HTTP_PARSE_MORE;
+        output.resume(request, 24);
+        CPPUNIT_ASSERT_EQUAL(1, HttpParserParseReqLine(&output));
+        CPPUNIT_ASSERT_EQUAL(23, output.req.end);
+    }
+
+    // a shrunk buffer starts a new parse
+    {
+        HttpParser output;
+        output.reset(request, 10);
+        CPPUNIT_ASSERT_EQUAL(0, HttpParserParseReqLine(&output));
+        output.state = HTTP_PARSE_MORE;
+        output.resume("GET / HTTP/1.0\n\n", 5);
+        CPPUNIT_ASSERT_EQUAL(0, HttpParserParseReqLine(&output));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint8_t>(HTTP_PARSE_NEW), output.state);
+    }
+}
+
+void
+testHttpParser::testParseResumeLikeReset()
+{
+    // ensure MemPools etc exist
+    globalSetup();
+
+    MemBuf input;
+    input.init();
+    input.append("GET http://example.com/some/long/path/to/an/object.html HTTP/1.1\r\n", 67);
+    for (int i = 0; i < 100; ++i)
+        input.Printf("X-Header-%03d: a typical header field value of moderate length\r\n", i);
+    input.append("\r\n", 2);
+    const int len = input.contentSize();
+
+    const int steps[] = { 64, 1 };
+    for (unsigned int i = 0; i < sizeof(steps)/sizeof(steps[0]); ++i) {
+        HttpParser resumed;
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(len), dripFeed(resumed, input.content(), len, steps[i], true));
+        HttpParser rescanned;
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(len), dripFeed(rescanned, input.content(), len, steps[i], false));
+
+        CPPUNIT_ASSERT_EQUAL(rescanned.request_parse_status, resumed.request_parse_status);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.end, resumed.req.end);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.m_end, resumed.req.m_end);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.u_start, resumed.req.u_start);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.u_end, resumed.req.u_end);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.v_start, resumed.req.v_start);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.v_maj, resumed.req.v_maj);
+        CPPUNIT_ASSERT_EQUAL(rescanned.req.v_min, resumed.req.v_min);
+    }
+}
@@ -19,6 +19,8 @@ class testHttpParser : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testParseRequestLineProtocols );
     CPPUNIT_TEST( testParseRequestLineStrange );
     CPPUNIT_TEST( testParseRequestLineInvalid );
+    CPPUNIT_TEST( testParseRequestDripFeed );
+    CPPUNIT_TEST( testParseResumeLikeReset );
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -30,6 +32,10 @@ protected:
     void testParseRequestLineProtocols();   // protocol tokens handled correctly
     void testParseRequestLineStrange();     // strange but valid lines accepted
     void testParseRequestLineInvalid();     // rejection of invalid lines happens
+
+    // incremental parsing
+    void testParseRequestDripFeed();        // resume() gives whole-buffer results
+    void testParseResumeLikeReset();        // resume() and reset() agree
 };
 
 #endif
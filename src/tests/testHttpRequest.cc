@@ -14,9 +14,15 @@
 #include "HttpRequest.h"
 #include "Mem.h"
 #include "mime_header.h"
+#include "StrList.h"
 #include "testHttpRequest.h"
 #include "unitTestMain.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
 CPPUNIT_TEST_SUITE_REGISTRATION( testHttpRequest );
 
 /** wrapper for testing HttpRequest object private and protected functions */
@@ -210,3 +216,268 @@ testHttpRequest::testSanityCheckStartLine()
     error = Http::scNone;
 }
 
+
+/* HttpHeader id index and custom name filter */
+
+/// non-list fields that findEntry() and getLastStr() accept
+static const http_hdr_type IndexedIds[] = { HDR_HOST, HDR_COOKIE, HDR_REFERER, HDR_USER_AGENT };
+static const char *IndexedNames[] = { "Host", "Cookie", "Referer", "User-Agent" };
+static const int IndexedIdCount = sizeof(IndexedIds) / sizeof(IndexedIds[0]);
+
+/// custom field names used by the header index tests
+static const char *CustomNames[] = { "X-Alpha", "X-Beta", "X-Gamma", "X-Delta", "X-Epsilon" };
+static const int CustomNameCount = sizeof(CustomNames) / sizeof(CustomNames[0]);
+
+/// the first (or the last) entry with the given id, found by a linear scan
+static HttpHeaderEntry *
+scanForId(const HttpHeader &hdr, const http_hdr_type id, const bool wantLast)
+{
+    HttpHeaderEntry *found = NULL;
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (HttpHeaderEntry *e = hdr.getEntry(&pos)) {
+        if (e->id == id) {
+            found = e;
+            if (!wantLast)
+                break;
+        }
+    }
+    return found;
+}
+
+/// getByNameIfPresent() for custom fields, implemented with a linear scan
+static bool
+scanForName(const HttpHeader &hdr, const char *name, String &values)
+{
+    bool found = false;
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (HttpHeaderEntry *e = hdr.getEntry(&pos)) {
+        if (e->id == HDR_OTHER && e->name.caseCmp(name) == 0) {
+            found = true;
+            strListAdd(&values, e->value.termedBuf(), ',');
+        }
+    }
+    return found;
+}
+
+/// name with its letters in the opposite case
+static std::string
+flipCase(const char *name)
+{
+    std::string flipped(name);
+    for (std::string::iterator i = flipped.begin(); i != flipped.end(); ++i)
+        *i = xisupper(*i) ? xtolower(*i) : xtoupper(*i);
+    return flipped;
+}
+
+/// compares indexed lookups with linear scans; has() is only checked when
+/// no delAt() calls left stale bits in the header mask
+static void
+checkHeaderIndex(const HttpHeader &hdr, const bool maskIsExact)
+{
+    for (int i = 0; i < IndexedIdCount; ++i) {
+        const http_hdr_type id = IndexedIds[i];
+        HttpHeaderEntry *const first = scanForId(hdr, id, false);
+        HttpHeaderEntry *const last = scanForId(hdr, id, true);
+        CPPUNIT_ASSERT_EQUAL(first, hdr.findEntry(id));
+        // entry values are unique, so the value identifies findLastEntry() results
+        const char *const lastValue = hdr.getLastStr(id);
+        if (last)
+            CPPUNIT_ASSERT_EQUAL(String(last->value.termedBuf()), String(lastValue ? lastValue : "(none)"));
+        else
+            CPPUNIT_ASSERT(!lastValue);
+        if (maskIsExact)
+            CPPUNIT_ASSERT_EQUAL(first != NULL, hdr.has(id) != 0);
+    }
+
+    for (int i = 0; i < CustomNameCount; ++i) {
+        String expected;
+        const bool present = scanForName(hdr, CustomNames[i], expected);
+        String actual;
+        CPPUNIT_ASSERT_EQUAL(present, hdr.getByNameIfPresent(CustomNames[i], actual));
+        CPPUNIT_ASSERT_EQUAL(expected, actual);
+
+        String flipped;
+        CPPUNIT_ASSERT_EQUAL(present, hdr.getByNameIfPresent(flipCase(CustomNames[i]).c_str(), flipped));
+        CPPUNIT_ASSERT_EQUAL(expected, flipped);
+    }
+
+    String ignored;
+    CPPUNIT_ASSERT(!hdr.getByNameIfPresent("X-Never-Added", ignored));
+}
+
+/// a value that no other entry in the test header has
+static const char *
+uniqueValue()
+{
+    static int count = 0;
+    static char buf[32];
+    snprintf(buf, sizeof(buf), "v%d", ++count);
+    return buf;
+}
+
+/*
+ * Runs a random mix of field additions, insertions, and deletions by
+ * position, id, and name, interleaved with compact() and refreshMask(),
+ * checking the header index after every step.
+ */
+void
+testHttpRequest::testHeaderIndex()
+{
+    HttpHeader hdr(hoRequest);
+    bool maskIsExact = true;
+    srandom(1); // make failures reproducible
+
+    for (int step = 0; step < 5000; ++step) {
+        const int idIdx = random() % IndexedIdCount;
+        const http_hdr_type id = IndexedIds[idIdx];
+        const char *const name = CustomNames[random() % CustomNameCount];
+        const int entryCount = hdr.entries.size();
+
+        // grow the header to about 60 entries, then keep it there
+        switch (random() % (entryCount < 60 ? 6 : 10)) {
+        case 0:
+        case 1:
+            hdr.putStr(id, uniqueValue());
+            break;
+
+        case 2:
+        case 3:
+            hdr.putExt(name, uniqueValue());
+            break;
+
+        case 4:
+            if (random() % 2)
+                hdr.insertEntry(new HttpHeaderEntry(id, NULL, uniqueValue()));
+            else
+                hdr.insertEntry(new HttpHeaderEntry(HDR_OTHER, name, uniqueValue()));
+            break;
+
+        case 5:
+            hdr.compact();
+            break;
+
+        case 6:
+        case 7:
+            if (entryCount > 0) {
+                const HttpHeaderPos pos = random() % entryCount;
+                if (hdr.entries[pos]) {
+                    int deleted = 0;
+                    hdr.delAt(pos, deleted);
+                    CPPUNIT_ASSERT_EQUAL(1, deleted);
+                    maskIsExact = false;
+                }
+            }
+            break;
+
+        case 8:
+            if (scanForId(hdr, id, false))
+                CPPUNIT_ASSERT(hdr.delById(id) > 0);
+            else
+                CPPUNIT_ASSERT_EQUAL(0, hdr.delById(id));
+            break;
+
+        case 9:
+            // by name; may also remove an indexed id
+            if (random() % 2)
+                hdr.delByName(name);
+            else
+                hdr.delByName(flipCase(IndexedNames[idIdx]).c_str());
+            maskIsExact = true; // delByName() recomputes the mask
+            break;
+        }
+
+        if (step % 50 == 0) {
+            hdr.refreshMask();
+            maskIsExact = true;
+        }
+
+        checkHeaderIndex(hdr, maskIsExact);
+    }
+}
+
+/*
+ * Checks lookups in a header with more entries than the index can
+ * address, and after deletions bring it back under that limit.
+ */
+void
+testHttpRequest::testHeaderIndexOverflow()
+{
+    HttpHeader hdr(hoRequest);
+    hdr.putStr(HDR_HOST, "first-host");
+    hdr.putExt("X-Alpha", "early");
+
+    const int fillerCount = 66000; // more than 16-bit positions can address
+    for (int i = 0; i < fillerCount; ++i)
+        hdr.putExt("X-Filler", "f");
+
+    // the index stops here
+    hdr.putStr(HDR_HOST, "last-host");
+    hdr.putStr(HDR_USER_AGENT, "late-agent");
+    hdr.putExt("X-Beta", "late");
+    checkHeaderIndex(hdr, true);
+    CPPUNIT_ASSERT_EQUAL(String("late-agent"), String(hdr.getStr(HDR_USER_AGENT)));
+    CPPUNIT_ASSERT_EQUAL(String("last-host"), String(hdr.getLastStr(HDR_HOST)));
+
+    int deleted = 0;
+    hdr.delAt(0, deleted); // first-host
+    checkHeaderIndex(hdr, false);
+    CPPUNIT_ASSERT_EQUAL(String("last-host"), String(hdr.getStr(HDR_HOST)));
+
+    hdr.insertEntry(new HttpHeaderEntry(HDR_REFERER, NULL, "inserted"));
+    checkHeaderIndex(hdr, false);
+
+    hdr.compact();
+    hdr.refreshMask();
+    checkHeaderIndex(hdr, true);
+
+    // back under the limit, the index must be usable again
+    CPPUNIT_ASSERT_EQUAL(fillerCount, hdr.delByName("X-Filler"));
+    hdr.compact();
+    checkHeaderIndex(hdr, true);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), hdr.entries.size());
+
+    hdr.delAt(hdr.entries.size() - 1, deleted); // X-Beta
+    checkHeaderIndex(hdr, false);
+}
+
+/*
+ * The custom name filter may report absent names as present but must never
+ * hide a present name, whatever its case, after deletions and rebuilds.
+ */
+void
+testHttpRequest::testHeaderOtherNames()
+{
+    // enough names to set most filter bits and share some of them
+    const int nameCount = 300;
+    std::vector<std::string> names;
+    for (int i = 0; i < nameCount; ++i) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "X-Custom-%d", i);
+        names.push_back(buf);
+    }
+
+    HttpHeader hdr(hoRequest);
+    for (int i = 0; i < nameCount; ++i)
+        hdr.putExt(names[i].c_str(), uniqueValue());
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < nameCount; ++i) {
+            String expected;
+            const bool present = scanForName(hdr, names[i].c_str(), expected);
+            String actual;
+            CPPUNIT_ASSERT_EQUAL(present, hdr.getByNameIfPresent(names[i].c_str(), actual));
+            CPPUNIT_ASSERT_EQUAL(expected, actual);
+            String flipped;
+            CPPUNIT_ASSERT_EQUAL(present, hdr.getByNameIfPresent(flipCase(names[i].c_str()).c_str(), flipped));
+            CPPUNIT_ASSERT_EQUAL(expected, flipped);
+        }
+
+        // remove every other remaining name and vary the way we rebuild
+        for (int i = round; i < nameCount; i += 2 << round)
+            hdr.delByName(names[i].c_str());
+        if (round == 0)
+            hdr.compact();
+        else if (round == 1)
+            hdr.insertEntry(new HttpHeaderEntry(HDR_OTHER, names[0].c_str(), uniqueValue()));
+    }
+}
@@ -22,6 +22,9 @@ class testHttpRequest : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testCreateFromUrl );
     CPPUNIT_TEST( testIPv6HostColonBug );
     CPPUNIT_TEST( testSanityCheckStartLine );
+    CPPUNIT_TEST( testHeaderIndex );
+    CPPUNIT_TEST( testHeaderIndexOverflow );
+    CPPUNIT_TEST( testHeaderOtherNames );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -32,6 +35,9 @@ protected:
     void testCreateFromUrl();
     void testIPv6HostColonBug();
     void testSanityCheckStartLine();
+    void testHeaderIndex();
+    void testHeaderIndexOverflow();
+    void testHeaderOtherNames();
 };
 
 #endif
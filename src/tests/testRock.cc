@@ -19,6 +19,7 @@
 #include "SquidConfig.h"
 #include "Store.h"
 #include "StoreFileSystem.h"
+#include "store_key_md5.h"
 #include "StoreSearch.h"
 #include "SwapDir.h"
 #include "testRock.h"
@@ -26,6 +27,7 @@
 #include "unitTestMain.h"
 
 #include <stdexcept>
+#include <vector>
 #if HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
@@ -62,8 +64,18 @@ testRock::setUp()
     if (Ipc::Mem::Segment::BasePath == NULL)
         Ipc::Mem::Segment::BasePath = ".";
 
+    startStore();
+}
+
+/// configures the cache_dir and its shared memory, creating the db if needed
+void
+testRock::startStore()
+{
     Store::Root(new StoreController);
 
+    // like a fresh Squid, wait for the controller and our cache_dir rebuilds
+    StoreController::store_dirs_rebuilding = 1;
+
     store = new Rock::SwapDir();
 
     addSwapDir(store);
@@ -83,18 +95,17 @@ testRock::setUp()
 
     safe_free(config_line);
 
-    /* ok, ready to create */
+    /* ok, ready to create (an existing db is kept) */
     store->create();
 
     rr = new Rock::SwapDirRr;
     rr->useConfig();
 }
 
+/// forgets the cache_dir and destroys its shared memory, like a shutdown
 void
-testRock::tearDown()
+testRock::stopStore()
 {
-    CPPUNIT_NS::TestFixture::tearDown();
-
     Store::Root(NULL);
 
     store = NULL;
@@ -103,6 +114,14 @@ testRock::tearDown()
 
     rr->finishShutdown(); // deletes rr
     rr = NULL;
+}
+
+void
+testRock::tearDown()
+{
+    CPPUNIT_NS::TestFixture::tearDown();
+
+    stopStore();
 
     // TODO: do this once, or each time.
     // safe_free(Config.replPolicy->type);
@@ -222,6 +241,21 @@ testRock::getEntry(const int i)
     return storeGetPublic(storeId(i), Http::METHOD_GET);
 }
 
+/// whether the cache_dir index has entry i, bypassing the global store_table
+bool
+testRock::hasEntry(const int i)
+{
+    const cache_key *const key = storeKeyPublic(storeId(i), Http::METHOD_GET);
+    StoreEntry *const pe = store->get(key);
+    if (!pe)
+        return false;
+
+    // an unlocked idle entry is destroyed, closing the map entry for reading
+    pe->lock("testRock::hasEntry");
+    pe->unlock("testRock::hasEntry");
+    return true;
+}
+
 void
 testRock::testRockCreate()
 {
@@ -323,3 +357,41 @@ testRock::testRockSwapOut()
     }
 }
 
+
+void
+testRock::testRockRebuild()
+{
+    storeInit();
+
+    // store more entries than there are db slots so that some buckets
+    // overflow and some entries are evicted
+    const int count = store->entryLimitActual() + 100;
+    for (int i = 0; i < count; ++i) {
+        StoreEntry *const pe = addEntry(i);
+
+        StockEventLoop loop;
+        loop.run();
+
+        pe->unlock("testRock::testRockRebuild");
+    }
+
+    std::vector<bool> stored(count);
+    uint64_t storedCount = 0;
+    for (int i = 0; i < count; ++i) {
+        stored[i] = hasEntry(i);
+        if (stored[i])
+            ++storedCount;
+    }
+    CPPUNIT_ASSERT(storedCount > 0);
+    CPPUNIT_ASSERT_EQUAL(storedCount, store->currentCount());
+
+    // restart and load the index from disk
+    stopStore();
+    startStore();
+    storeInit();
+
+    // everything that fit before the restart must fit after it
+    CPPUNIT_ASSERT_EQUAL(storedCount, store->currentCount());
+    for (int i = 0; i < count; ++i)
+        CPPUNIT_ASSERT_EQUAL(static_cast<bool>(stored[i]), hasEntry(i));
+}
@@ -20,6 +20,7 @@ class testRock : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST_SUITE( testRock );
     CPPUNIT_TEST( testRockCreate );
     CPPUNIT_TEST( testRockSwapOut );
+    CPPUNIT_TEST( testRockRebuild );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -35,8 +36,12 @@ protected:
     StoreEntry *createEntry(const int i);
     StoreEntry *addEntry(const int i);
     StoreEntry *getEntry(const int i);
+    bool hasEntry(const int i);
+    void startStore();
+    void stopStore();
     void testRockCreate();
     void testRockSwapOut();
+    void testRockRebuild();
 
 private:
     SwapDirPointer store;
@@ -7,21 +7,14 @@
  */
 
 #include "squid.h"
-
-#if USE_MEMPOOLS
-
 #include "MemPool.h"
+#include "MemPoolChunked.h"
+#include "MemPoolMalloc.h"
+#include "MemPoolSlab.h"
 
+#include <ctime>
 #include <iostream>
 
-/* TODO: put this in a libTest */
-void
-xassert(const char *msg, const char *file, int line)
-{
-    std::cout << "Assertion failed: (" << msg << ") at " << file << ":" << line << std::endl;
-    exit (1);
-}
-
 class MemPoolTest
 {
 public:
@@ -32,15 +25,33 @@ private:
     public:
         int aValue;
     };
-    static MemAllocator *Pool;
+
+    /// which MemImplementingAllocator kind to test
+    typedef enum { ptMalloc, ptChunked, ptSlab } PoolType;
+
+    static MemImplementingAllocator *CreatePool(PoolType type, const char *label, size_t size);
+    void testReuse(PoolType type);
+    void testChurn(PoolType type);
 };
-MemAllocator *MemPoolTest::Pool = NULL;
+
+MemImplementingAllocator *
+MemPoolTest::CreatePool(PoolType type, const char *label, size_t size)
+{
+    switch (type) {
+    case ptMalloc:
+        return new MemPoolMalloc(label, size);
+    case ptChunked:
+        return new MemPoolChunked(label, size);
+    case ptSlab:
+        return new MemPoolSlab(label, size);
+    }
+    return NULL;
+}
 
 void
-MemPoolTest::run()
+MemPoolTest::testReuse(PoolType type)
 {
-    assert (Pool == NULL);
-    Pool = memPoolCreate("Test Pool", sizeof(SomethingToAlloc));
+    MemImplementingAllocator *Pool = CreatePool(type, "Test Pool", sizeof(SomethingToAlloc));
     assert (Pool);
     SomethingToAlloc *something = static_cast<SomethingToAlloc *>(Pool->alloc());
     assert (something);
@@ -54,15 +65,77 @@ MemPoolTest::run()
     delete Pool;
 }
 
-#endif /* USE_MEMPOOLS */
+/**
+ * Allocates and frees objects of several pools in random order, the way
+ * Squid interleaves its hot pools, checking that live objects stay intact.
+ * Some pools have sizes that share a slab class.
+ */
+void
+MemPoolTest::testChurn(PoolType type)
+{
+    static const size_t Sizes[] = { 24, 32, 40, 48, 100, 120, 200, 1000 };
+    static const int PoolCount = sizeof(Sizes) / sizeof(Sizes[0]);
+    static const int Live = 4096; ///< objects kept per pool
+    static const int Operations = 1000000;
+
+    MemImplementingAllocator *pools[PoolCount];
+    unsigned char **objects[PoolCount];
+    for (int p = 0; p < PoolCount; ++p) {
+        pools[p] = CreatePool(type, "Churn Pool", Sizes[p]);
+        objects[p] = static_cast<unsigned char **>(xcalloc(Live, sizeof(unsigned char *)));
+    }
+
+    unsigned int seed = 1;
+    const clock_t start = clock();
+    for (int i = 0; i < Operations; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const int p = (seed >> 8) % PoolCount;
+        const int slot = (seed >> 12) % Live;
+        unsigned char *&obj = objects[p][slot];
+        if (obj) {
+            // the fill pattern must survive other allocations
+            assert(obj[0] == static_cast<unsigned char>(slot));
+            assert(obj[Sizes[p] - 1] == static_cast<unsigned char>(p));
+            pools[p]->freeOne(obj);
+            obj = NULL;
+        } else {
+            obj = static_cast<unsigned char *>(pools[p]->alloc());
+            assert(obj[0] == 0 && obj[Sizes[p] - 1] == 0);
+            obj[0] = static_cast<unsigned char>(slot);
+            obj[Sizes[p] - 1] = static_cast<unsigned char>(p);
+        }
+    }
+    const double seconds = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+
+    static const char *Names[] = { "malloc", "chunked", "slab" };
+    std::cout << Names[type] << " pools: " << Operations << " operations in " <<
+              seconds << " seconds" << std::endl;
+
+    for (int p = 0; p < PoolCount; ++p) {
+        for (int slot = 0; slot < Live; ++slot) {
+            if (objects[p][slot])
+                pools[p]->freeOne(objects[p][slot]);
+        }
+        assert(pools[p]->getInUseCount() == 0);
+        xfree(objects[p]);
+        delete pools[p];
+    }
+}
+
+void
+MemPoolTest::run()
+{
+    for (int type = ptMalloc; type <= ptSlab; ++type) {
+        testReuse(static_cast<PoolType>(type));
+        testChurn(static_cast<PoolType>(type));
+    }
+}
 
 int
 main (int argc, char **argv)
 {
-#if USE_MEMPOOLS
     MemPoolTest aTest;
     aTest.run();
-#endif
     return 0;
 }
 
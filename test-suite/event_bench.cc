@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Compares the EventScheduler heap with the sorted event list it replaced,
+ * at 10k and 100k pending events (or at the sizes given on the command
+ * line). For each size, times adding the events in random due time order,
+ * deleting a random tenth of them, and running the rest. The list needs
+ * minutes to add 100k events. Both schedulers create and fire an AsyncCall
+ * per event, like the old list did, and must fire the same number of events.
+ */
+
+#include "squid.h"
+#include "base/AsyncCall.h"
+#include "base/AsyncCallQueue.h"
+#include "event.h"
+#include "mgr/Registration.h"
+#include "SquidTime.h"
+#include "Store.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+// event.o registers and fills a cache manager report we never show
+void Mgr::RegisterAction(char const *, char const *, OBJH *, int, int) {}
+void StoreEntry::lock(const char *) {}
+int StoreEntry::unlock(const char *) { return 0; }
+void storeAppendPrintf(StoreEntry *, const char *, ...) {}
+
+/// the number of events fired by either scheduler
+static size_t Fired = 0;
+
+static void
+countFired(void *)
+{
+    ++Fired;
+}
+
+/// calls an event handler, like EventDialer does for events without cbdata
+class ListDialer: public CallDialer
+{
+public:
+    explicit ListDialer(EVH *aHandler, void *anArg): theHandler(aHandler), theArg(anArg) {}
+
+    virtual void print(std::ostream &os) const { os << '(' << theArg << ')'; }
+    virtual bool canDial(AsyncCall &) { return true; }
+    void dial(AsyncCall &) { theHandler(theArg); }
+
+private:
+    EVH *theHandler;
+    void *theArg;
+};
+
+/// the EventScheduler event list before the heap, reduced to what we time
+class SortedEvents
+{
+public:
+    class Event
+    {
+    public:
+        Event(const char *aName, EVH *aFunc, void *anArg, double aWhen):
+            name(aName), func(aFunc), arg(anArg), when(aWhen), next(NULL) {}
+
+        const char *name;
+        EVH *func;
+        void *arg;
+        double when;
+        Event *next;
+    };
+
+    SortedEvents(): tasks(NULL) {}
+    ~SortedEvents();
+
+    void schedule(const char *name, EVH *func, void *arg, double when);
+    void cancel(EVH *func, void *arg);
+    void checkEvents(int timeout);
+
+private:
+    Event *tasks;
+};
+
+SortedEvents::~SortedEvents()
+{
+    while (Event *event = tasks) {
+        tasks = event->next;
+        delete event;
+    }
+}
+
+void
+SortedEvents::schedule(const char *name, EVH *func, void *arg, double when)
+{
+    Event *event = new Event(name, func, arg, current_dtime + when);
+
+    Event **E;
+    for (E = &tasks; *E; E = &(*E)->next) {
+        if ((*E)->when > event->when)
+            break;
+    }
+
+    event->next = *E;
+    *E = event;
+}
+
+void
+SortedEvents::cancel(EVH *func, void *arg)
+{
+    for (Event **E = &tasks; *E; E = &(*E)->next) {
+        Event *event = *E;
+        if (event->func == func && event->arg == arg) {
+            *E = event->next;
+            delete event;
+            return;
+        }
+    }
+}
+
+void
+SortedEvents::checkEvents(int)
+{
+    while (tasks && tasks->when <= current_dtime) {
+        Event *event = tasks;
+        AsyncCall::Pointer call = asyncCall(41, 5, event->name, ListDialer(event->func, event->arg));
+        call->lane = AsyncCall::laneTimer;
+        ScheduleCallHere(call);
+        tasks = event->next;
+        delete event;
+    }
+}
+
+static double
+secondsSince(clock_t start)
+{
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/// add, delete, and run timings of one scheduler
+class Timings
+{
+public:
+    Timings(): add(0), del(0), run(0), fired(0) {}
+
+    double add;
+    double del;
+    double run;
+    size_t fired;
+};
+
+/// runs all events due before the given time, as the main loop would
+template <class Scheduler>
+static void
+runAll(Scheduler &scheduler, const double horizon)
+{
+    const double savedTime = current_dtime;
+    current_dtime += horizon;
+    scheduler.checkEvents(0);
+    current_dtime = savedTime;
+    // fire() dispatches a bounded round; keep going until the queue drains
+    while (AsyncCallQueue::Instance().fire()) {}
+}
+
+static Timings
+benchList(const std::vector<double> &delays, const std::vector<size_t> &deleted, std::vector<char> &args)
+{
+    Timings t;
+    SortedEvents events;
+
+    clock_t start = clock();
+    for (size_t i = 0; i < delays.size(); ++i)
+        events.schedule("bench event", countFired, &args[i], delays[i]);
+    t.add = secondsSince(start);
+
+    start = clock();
+    for (size_t i = 0; i < deleted.size(); ++i)
+        events.cancel(countFired, &args[deleted[i]]);
+    t.del = secondsSince(start);
+
+    Fired = 0;
+    start = clock();
+    runAll(events, 3600);
+    t.run = secondsSince(start);
+    t.fired = Fired;
+    return t;
+}
+
+static Timings
+benchHeap(const std::vector<double> &delays, const std::vector<size_t> &deleted, std::vector<char> &args)
+{
+    Timings t;
+    EventScheduler scheduler;
+
+    clock_t start = clock();
+    for (size_t i = 0; i < delays.size(); ++i)
+        scheduler.schedule("bench event", countFired, &args[i], delays[i], 0, false);
+    t.add = secondsSince(start);
+
+    start = clock();
+    for (size_t i = 0; i < deleted.size(); ++i)
+        scheduler.cancel(countFired, &args[deleted[i]]);
+    t.del = secondsSince(start);
+
+    Fired = 0;
+    start = clock();
+    runAll(scheduler, 3600);
+    t.run = secondsSince(start);
+    t.fired = Fired;
+    return t;
+}
+
+static void
+report(const char *label, const Timings &t)
+{
+    std::cout << "  " << label << ": add " << t.add << "s, delete " << t.del <<
+              "s, run " << t.run << "s (" << t.fired << " fired)" << std::endl;
+}
+
+static bool
+bench(const size_t eventCount)
+{
+    std::vector<double> delays(eventCount);
+    for (size_t i = 0; i < eventCount; ++i)
+        delays[i] = 1.0 + (random() % 1000000) / 1000.0; // some share a due time
+
+    // delete a tenth of the events, in random order
+    std::vector<size_t> deleted;
+    for (size_t i = 0; i < eventCount; i += 10)
+        deleted.push_back(i);
+    for (size_t i = deleted.size(); i > 1; --i)
+        std::swap(deleted[i - 1], deleted[random() % i]);
+
+    std::vector<char> args(eventCount); // distinct event arguments
+
+    std::cout << eventCount << " pending events, " << deleted.size() << " deleted" << std::endl;
+    const Timings list = benchList(delays, deleted, args);
+    report("list", list);
+    const Timings heap = benchHeap(delays, deleted, args);
+    report("heap", heap);
+
+    const size_t expected = eventCount - deleted.size();
+    if (list.fired != expected || heap.fired != expected) {
+        std::cout << "  FAILED: expected " << expected << " fired events" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+    srandom(time(NULL));
+    getCurrentTime();
+
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(strtoul(argv[i], NULL, 10));
+    if (sizes.empty()) {
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+    }
+
+    bool ok = true;
+    for (std::vector<size_t>::const_iterator i = sizes.begin(); i != sizes.end(); ++i)
+        ok = bench(*i) && ok;
+    return ok ? 0 : 1;
+}
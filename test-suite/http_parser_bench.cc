@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Times HttpParser on a request with 100 header fields delivered in reads
+ * of the whole request, 1024, 64, and 1 bytes (or of the sizes given on the
+ * command line). Each size is parsed twice: resuming the parse as more
+ * bytes arrive and, as Squid did before resume(), rescanning the buffer
+ * from the start after every read. Both must find the whole request.
+ */
+
+#include "squid.h"
+#include "HttpParser.h"
+#include "SquidConfig.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// HttpParser only checks Config.onoff.relaxed_header_parser
+class SquidConfig Config;
+
+/// feeds the request to the parser step bytes at a time, the way a slow
+/// client would; returns the request prefix size or zero on failure
+static size_t
+dripFeed(HttpParser &hp, const char *request, const int len, const int step, const bool resume)
+{
+    hp.clear();
+    for (int avail = min(step, len); avail <= len; avail = min(avail + step, len)) {
+        if (resume)
+            hp.resume(request, avail);
+        else
+            hp.reset(request, avail);
+
+        const int r = HttpParserParseReqLine(&hp);
+        if (r < 0)
+            return 0;
+        if (r > 0) {
+            if (const size_t prefixLen = hp.findHeadersEnd())
+                return prefixLen;
+        }
+        if (avail == len)
+            return 0;
+        hp.state = HTTP_PARSE_MORE;
+    }
+    return 0;
+}
+
+static double
+secondsSince(clock_t start)
+{
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static bool
+bench(const std::string &request, const int step)
+{
+    const int len = request.size();
+    for (int resume = 1; resume >= 0; --resume) {
+        // keep the total work for the quadratic case reasonable
+        const int iterations = step >= 1024 ? 2000 : (resume ? 200 : 10);
+        HttpParser hp;
+        const clock_t start = clock();
+        for (int n = 0; n < iterations; ++n) {
+            if (dripFeed(hp, request.data(), len, step, resume) != static_cast<size_t>(len)) {
+                std::cout << "FAILED to parse " << len << "-byte request in " << step << "-byte reads" << std::endl;
+                return false;
+            }
+        }
+        const double seconds = secondsSince(start);
+        const double megabytes = static_cast<double>(len) * iterations / (1024*1024);
+        std::cout << "parsed " << len << "-byte requests in " << step << "-byte reads with " <<
+                  (resume ? "resume()" : "reset()") << ": " <<
+                  (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << std::endl;
+    }
+    return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+    std::string request("GET http://example.com/some/long/path/to/an/object.html HTTP/1.1\r\n");
+    for (int i = 0; i < 100; ++i) {
+        char field[128];
+        snprintf(field, sizeof(field), "X-Header-%03d: a typical header field value of moderate length\r\n", i);
+        request.append(field);
+    }
+    request.append("\r\n");
+
+    std::vector<int> steps;
+    for (int i = 1; i < argc; ++i)
+        steps.push_back(atoi(argv[i]));
+    if (steps.empty()) {
+        steps.push_back(request.size());
+        steps.push_back(1024);
+        steps.push_back(64);
+        steps.push_back(1);
+    }
+
+    bool ok = true;
+    for (std::vector<int>::const_iterator i = steps.begin(); i != steps.end(); ++i)
+        ok = *i > 0 && bench(request, *i) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * Compares IP ACL lookups in the Acl::IpTree prefix tree with the splay tree
+ * of masked addresses it replaced, at 1k, 100k, and 1M prefixes (or at the
+ * sizes given on the command line). Both structures must agree on every
+ * lookup. About a tenth of the prefixes and lookups are native IPv6.
+ */
+
+#include "squid.h"
+#include "acl/IpTree.h"
+#include "splay.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+/// an address and CIDR mask, compared as the ACLIP splay tree used to
+class Net
+{
+public:
+    Net(const struct in6_addr &anAddr, unsigned int aLen);
+
+    struct in6_addr addr;
+    struct in6_addr mask;
+    unsigned int len;
+};
+
+Net::Net(const struct in6_addr &anAddr, unsigned int aLen): addr(anAddr), len(aLen)
+{
+    memset(&mask, 0, sizeof(mask));
+    for (unsigned int bit = 0; bit < len; ++bit)
+        mask.s6_addr[bit / 8] |= 0x80 >> (bit % 8);
+    for (int i = 0; i < 16; ++i)
+        addr.s6_addr[i] &= mask.s6_addr[i];
+}
+
+/// compares an address p, masked by the q mask, with the q network
+static int
+compareMasked(Net * const &p, Net * const &q)
+{
+    struct in6_addr a = p->addr;
+    for (int i = 0; i < 16; ++i)
+        a.s6_addr[i] &= q->mask.s6_addr[i];
+    return memcmp(&a, &q->addr, sizeof(a));
+}
+
+/// zero if either network contains the other, like acl_ip_data::NetworkCompare
+static int
+compareNetworks(Net * const &a, Net * const &b)
+{
+    const int ret = compareMasked(b, a);
+    return ret ? compareMasked(a, b) : ret;
+}
+
+/// splay destroy() callback; bench() deletes all networks itself
+static void
+keepNet(Net * &)
+{
+}
+
+static struct in6_addr
+randomAddress()
+{
+    struct in6_addr addr;
+    memset(&addr, 0, sizeof(addr));
+    if (random() % 10) {
+        addr.s6_addr[10] = addr.s6_addr[11] = 0xFF; // IPv4-mapped
+        for (int i = 12; i < 16; ++i)
+            addr.s6_addr[i] = random() & 0xFF;
+    } else {
+        addr.s6_addr[0] = 0x20;
+        for (int i = 1; i < 16; ++i)
+            addr.s6_addr[i] = random() & 0xFF;
+    }
+    return addr;
+}
+
+static double
+secondsSince(clock_t start)
+{
+    return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static bool
+bench(size_t prefixCount)
+{
+    const size_t lookupCount = 1000000;
+
+    std::vector<Net *> nets;
+    while (nets.size() < prefixCount) {
+        const struct in6_addr addr = randomAddress();
+        const bool mapped = addr.s6_addr[10] == 0xFF;
+        const unsigned int len = mapped ? 96 + 16 + random() % 17 : 32 + random() % 97;
+        nets.push_back(new Net(addr, len));
+    }
+
+    std::vector<struct in6_addr> lookups;
+    lookups.reserve(lookupCount);
+    for (size_t i = 0; i < lookupCount; ++i) {
+        struct in6_addr addr = randomAddress();
+        if (i % 2) {
+            // probe inside a random prefix
+            const Net &net = *nets[random() % nets.size()];
+            for (int b = 0; b < 16; ++b)
+                addr.s6_addr[b] = net.addr.s6_addr[b] | (addr.s6_addr[b] & ~net.mask.s6_addr[b]);
+        }
+        lookups.push_back(addr);
+    }
+
+    // like ACLIP::parse() did, skip prefixes overlapping earlier ones
+    Splay<Net *> splay;
+    Acl::IpTree tree;
+    clock_t start = clock();
+    std::vector<Net *> kept;
+    for (std::vector<Net *>::iterator i = nets.begin(); i != nets.end(); ++i) {
+        if (!splay.find(*i, compareNetworks)) {
+            splay.insert(*i, compareNetworks);
+            kept.push_back(*i);
+        }
+    }
+    const double splayBuild = secondsSince(start);
+
+    start = clock();
+    for (std::vector<Net *>::iterator i = kept.begin(); i != kept.end(); ++i)
+        tree.add((*i)->addr, (*i)->len);
+    const double treeBuild = secondsSince(start);
+
+    std::vector<bool> splayFound(lookupCount);
+    Net probe(lookups[0], 128);
+    Net *probePtr = &probe;
+    start = clock();
+    for (size_t i = 0; i < lookupCount; ++i) {
+        probe.addr = lookups[i];
+        splayFound[i] = splay.find(probePtr, compareMasked);
+    }
+    const double splayLookup = secondsSince(start);
+
+    std::vector<bool> treeFound(lookupCount);
+    start = clock();
+    for (size_t i = 0; i < lookupCount; ++i)
+        treeFound[i] = tree.match(lookups[i]);
+    const double treeLookup = secondsSince(start);
+
+    size_t hits = 0;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < lookupCount; ++i) {
+        hits += treeFound[i];
+        mismatches += (treeFound[i] != splayFound[i]);
+    }
+
+    std::cout << prefixCount << " prefixes (" << kept.size() << " kept), " <<
+              tree.nodes() << " tree nodes, " << tree.memoryUsed() / kept.size() << " bytes/prefix" << std::endl;
+    std::cout << "  build:  splay " << splayBuild << "s, tree " << treeBuild << "s" << std::endl;
+    std::cout << "  " << lookupCount << " lookups (" << hits << " hits): splay " << splayLookup <<
+              "s, tree " << treeLookup << "s" << std::endl;
+    if (mismatches)
+        std::cout << "  FAILED: " << mismatches << " lookups disagree" << std::endl;
+
+    splay.destroy(keepNet);
+    for (std::vector<Net *>::iterator i = nets.begin(); i != nets.end(); ++i)
+        delete *i;
+    return !mismatches;
+}
+
+int
+main(int argc, char *argv[])
+{
+    srandom(time(NULL));
+
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(strtoul(argv[i], NULL, 10));
+    if (sizes.empty()) {
+        sizes.push_back(1000);
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+
+    bool ok = true;
+    for (std::vector<size_t>::const_iterator i = sizes.begin(); i != sizes.end(); ++i)
+        ok = bench(*i) && ok;
+    return ok ? 0 : 1;
+}
+
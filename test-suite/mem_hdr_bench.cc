@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 1996-2016 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 19    Store Memory Primitives */
+
+/*
+ * Times storing 1KB to 100MB objects in a mem_hdr (or objects of the sizes
+ * given on the command line) and reading them back. Objects are appended
+ * in network-sized pieces and copied out in client-sized pieces, about
+ * 100MB per object size.
+ */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "mem_node.h"
+#include "stmem.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+/*For  a reason required on some platforms */
+unsigned int TextException::FileNameHash(const char *fname)
+{
+    return 0;
+}
+
+static double
+MegabytesPerSecond(int64_t bytes, clock_t ticks)
+{
+    const double seconds = static_cast<double>(ticks) / CLOCKS_PER_SEC;
+    return seconds > 0 ? bytes / seconds / (1024*1024) : 0;
+}
+
+/// measures how fast objects of the given size are stored and read back
+static void
+benchmarkAppendAndCopy(int64_t objectSize)
+{
+    const int64_t totalBytes = 100*1024*1024;
+    const int rounds = max<int64_t>(1, totalBytes / objectSize);
+    char source[16*1024];
+    memset(source, 'A', sizeof(source));
+    char target[4*1024];
+
+    clock_t appendTicks = 0;
+    clock_t copyTicks = 0;
+    for (int round = 0; round < rounds; ++round) {
+        mem_hdr aHeader;
+
+        clock_t started = clock();
+        for (int64_t offset = 0; offset < objectSize; offset += sizeof(source))
+            aHeader.internalAppend(source, min<int64_t>(sizeof(source), objectSize - offset));
+        appendTicks += clock() - started;
+        assert (aHeader.endOffset() == objectSize);
+
+        started = clock();
+        for (int64_t offset = 0; offset < objectSize; ) {
+            const ssize_t copied = aHeader.copy(StoreIOBuffer(min<int64_t>(sizeof(target), objectSize - offset), offset, target));
+            assert (copied > 0);
+            assert (target[copied - 1] == 'A');
+            offset += copied;
+        }
+        copyTicks += clock() - started;
+    }
+
+    const int64_t bytes = objectSize * rounds;
+    std::cout << "mem_hdr " << objectSize << "-byte objects x" << rounds << ": " <<
+              "append " << MegabytesPerSecond(bytes, appendTicks) << " MB/s, " <<
+              "copy " << MegabytesPerSecond(bytes, copyTicks) << " MB/s" << std::endl;
+}
+
+int
+main(int argc, char **argv)
+{
+    std::vector<int64_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(strtoll(argv[i], NULL, 10));
+    if (sizes.empty()) {
+        for (int64_t objectSize = 1024; objectSize <= 100*1024*1024; objectSize *= 10)
+            sizes.push_back(objectSize);
+    }
+
+    for (std::vector<int64_t>::const_iterator i = sizes.begin(); i != sizes.end(); ++i) {
+        if (*i <= 0) {
+            std::cerr << "object sizes must be positive" << std::endl;
+            return 1;
+        }
+        benchmarkAppendAndCopy(*i);
+    }
+    assert (mem_node::InUseCount() == 0);
+    return 0;
+}
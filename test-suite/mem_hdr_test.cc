@@ -14,7 +14,8 @@
 #include "mem_node.h"
 #include "stmem.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 /*For  a reason required on some platforms */
@@ -48,34 +49,47 @@ testLowAndHigh()
 }
 
 void
-testSplayOfNodes()
+testNodeLookup()
 {
-    Splay<mem_node *> aSplay;
-    mem_node *temp5;
-    temp5 = new mem_node(5);
-    temp5->nodeBuffer.length = 10;
-    aSplay.insert (temp5, mem_hdr::NodeCompare);
-    assert (aSplay.start()->data == temp5);
-    assert (aSplay.finish()->data == temp5);
+    mem_hdr aHeader;
+    char sampleData[] = "0123456789ABCDE";
+
+    /* write the tail first so that the head node is inserted before it */
+    assert (aHeader.write (StoreIOBuffer(10, 5, sampleData + 5)));
+    assert (aHeader.write (StoreIOBuffer(5, 0, sampleData)));
+    assert (aHeader.size() == 2);
+    assert (aHeader.start()->start() == 0);
+    assert (aHeader.getBlockContainingLocation(4)->start() == 0);
+    assert (aHeader.getBlockContainingLocation(5)->start() == 5);
+    assert (aHeader.getBlockContainingLocation(14)->start() == 5);
+    assert (!aHeader.getBlockContainingLocation(15));
 
-    mem_node *temp0;
-    temp0 = new mem_node(0);
-    temp0->nodeBuffer.length = 5;
-    aSplay.insert (temp0, mem_hdr::NodeCompare);
-    assert (aSplay.start()->data == temp0);
-    assert (aSplay.finish()->data == temp5);
+    /* leave a hole */
+    assert (aHeader.write (StoreIOBuffer(1, 20, sampleData)));
+    assert (!aHeader.getBlockContainingLocation(17));
+    assert (aHeader.getBlockContainingLocation(20)->start() == 20);
+    assert (aHeader.hasContigousContentRange(Range<int64_t>(0,15)));
+    assert (!aHeader.hasContigousContentRange(Range<int64_t>(0,16)));
 
-    mem_node *temp14;
-    temp14 = new mem_node (14);
-    temp14->nodeBuffer.length = 1;
-    assert (aSplay.find(temp14,mem_hdr::NodeCompare));
-    delete temp14;
+    char copied[16];
+    assert (aHeader.copy (StoreIOBuffer(15, 0, copied)) == 15);
+    assert (!memcmp(copied, sampleData, 15));
 
-    mem_node ref13  (13);
-    assert (!aSplay.find(&ref13,mem_hdr::NodeCompare));
-    ref13.nodeBuffer.length = 1;
-    assert (aSplay.find(&ref13,mem_hdr::NodeCompare));
-    aSplay.destroy();
+    /* lookups of full pages appended in order */
+    mem_hdr pages;
+    char page[SM_PAGE_SIZE];
+    memset(page, 'x', sizeof(page));
+    for (int i = 0; i < 10; ++i)
+        pages.internalAppend(page, sizeof(page));
+    pages.internalAppend(page, 1);
+    assert (pages.size() == 11);
+    assert (pages.getBlockContainingLocation(3*SM_PAGE_SIZE + 1)->start() == 3*SM_PAGE_SIZE);
+    assert (pages.getBlockContainingLocation(10*SM_PAGE_SIZE)->start() == 10*SM_PAGE_SIZE);
+    assert (!pages.getBlockContainingLocation(10*SM_PAGE_SIZE + 1));
+    assert (pages.freeDataUpto(5*SM_PAGE_SIZE) == 5*SM_PAGE_SIZE);
+    assert (pages.size() == 6);
+    assert (pages.getBlockContainingLocation(7*SM_PAGE_SIZE)->start() == 7*SM_PAGE_SIZE);
+    assert (!pages.getBlockContainingLocation(SM_PAGE_SIZE));
 }
 
 void
@@ -90,9 +104,9 @@ testHdrVisit()
     safe_free (sampleData);
     std::ostringstream result;
     PointerPrinter<mem_node *> foo(result, "\n");
-    for_each (aHeader.getNodes().end(), aHeader.getNodes().end(), foo);
-    for_each (aHeader.getNodes().begin(), aHeader.getNodes().begin(), foo);
-    for_each (aHeader.getNodes().begin(), aHeader.getNodes().end(), foo);
+    std::for_each (aHeader.getNodes().end(), aHeader.getNodes().end(), foo);
+    std::for_each (aHeader.getNodes().begin(), aHeader.getNodes().begin(), foo);
+    std::for_each (aHeader.getNodes().begin(), aHeader.getNodes().end(), foo);
     std::ostringstream expectedResult;
     expectedResult << "[100,101)" << std::endl << "[102,103)" << std::endl;
     assert (result.str() == expectedResult.str());
@@ -104,7 +118,7 @@ main(int argc, char **argv)
     assert (mem_node::InUseCount() == 0);
     testLowAndHigh();
     assert (mem_node::InUseCount() == 0);
-    testSplayOfNodes();
+    testNodeLookup();
     assert (mem_node::InUseCount() == 0);
     testHdrVisit();
     assert (mem_node::InUseCount() == 0);